@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "bar_table.h"
+
+bar_table_t::bar_table_t()
+{
+    m_mem = NULL;
+    m_mem_size = 0;
+    m_ins = NULL;
+    m_bars = NULL;
+    m_slots = NULL;
+    memset(m_intervals, 0, sizeof(m_intervals));
+    m_interval_num = 0;
+    m_ring_len = 0;
+    m_max_ins = 0;
+    m_ins_num = 0;
+    m_dropped = 0;
+    m_trade_date = 0;
+    m_bar_cb = NULL;
+    m_bar_ctx = NULL;
+}
+
+bar_table_t::~bar_table_t()
+{
+    if (m_mem != NULL)
+        munmap(m_mem, m_mem_size);
+}
+
+int bar_table_t::init(const int *intervals, int interval_num, int ring_len, int max_ins)
+{
+    if (m_mem != NULL)
+    {
+        printf("bar table has been initialized!\n");
+        return -1;
+    }
+
+    if (intervals == NULL || interval_num <= 0 || interval_num > BAR_MAX_INTERVAL_NUM
+            || ring_len <= 0 || max_ins <= 0 || max_ins >= INS_TABLE_SIZE)
+    {
+        printf("invalid bar table parameters: interval_num = %d, ring_len = %d, max_ins = %d\n",
+                interval_num, ring_len, max_ins);
+        return -1;
+    }
+
+    for (int i = 0; i < interval_num; i++)
+    {
+        if (intervals[i] <= 0 || intervals[i] > 86400)
+        {
+            printf("invalid bar interval: %d\n", intervals[i]);
+            return -1;
+        }
+        m_intervals[i] = intervals[i];
+    }
+    m_interval_num = interval_num;
+
+    m_ring_len = 1;
+    while (m_ring_len < (uint32)ring_len)
+        m_ring_len <<= 1;
+    m_max_ins = max_ins;
+
+    // 布局：槽位映射 | 各槽位累计值 | 各槽位各周期的环形缓冲
+    size_t slots_size = sizeof(std::atomic<uint16>) * INS_TABLE_SIZE;
+    size_t ins_offset = (slots_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    size_t ins_size = sizeof(bar_ins_t) * max_ins;
+    size_t bars_offset = (ins_offset + ins_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    size_t bars_size = sizeof(seqlock_t<bar_t>) * max_ins * interval_num * m_ring_len;
+
+    // 匿名映射内存初始为0，MAP_POPULATE预先建立页表，避免行情到来时缺页
+    m_mem_size = bars_offset + bars_size;
+    void *mem = mmap(NULL, m_mem_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap bar table");
+        m_mem_size = 0;
+        return -1;
+    }
+
+    m_mem = mem;
+    m_slots = (std::atomic<uint16> *)mem;
+    m_ins = (bar_ins_t *)((char *)mem + ins_offset);
+    m_bars = (seqlock_t<bar_t> *)((char *)mem + bars_offset);
+    return 0;
+}
+
+void bar_table_t::clear()
+{
+    if (m_mem == NULL)
+        return;
+
+    // read_bar()可能正在其他线程读取，不能整体memset：先撤下槽位映射和K线个数，
+    // 再经顺序锁作废已用槽位的K线（序号置为不可能的值），读到旧位置的读者会重试或返回false
+    for (int slot = 0; slot < m_ins_num; slot++)
+    {
+        bar_ins_t &ins = m_ins[slot];
+        m_slots[ins.ins_idx].store(0, std::memory_order_release);
+        for (int i = 0; i < m_interval_num; i++)
+        {
+            ins.bar_cnt[i].store(0, std::memory_order_release);
+            seqlock_t<bar_t> *bars = ring(slot, i);
+            for (uint32 n = 0; n < m_ring_len; n++)
+            {
+                bar_t &bar = bars[n].begin_write();
+                memset((void *)&bar, 0, sizeof(bar));
+                bar.bar_no = ~0u;
+                bars[n].end_write();
+            }
+        }
+
+        // 其余字段只由写线程访问
+        ins.day_sec = 0;
+        ins.last = 0;
+        ins.volume = 0;
+        ins.trade_val1 = 0;
+        ins.trade_val2 = 0;
+        ins.ins_idx = 0;
+        ins.has_time = ins.has_last = ins.has_volume = ins.has_trade_val = 0;
+    }
+    m_ins_num = 0;
+}
+
+void bar_table_t::flush() const
+{
+    if (m_bar_cb == NULL)
+        return;
+
+    for (int slot = 0; slot < m_ins_num; slot++)
+    {
+        const bar_ins_t &ins = m_ins[slot];
+        for (int i = 0; i < m_interval_num; i++)
+        {
+            uint32 cnt = ins.bar_cnt[i].load(std::memory_order_relaxed);
+            if (cnt != 0)
+                m_bar_cb(m_bar_ctx, ins.ins_idx, m_intervals[i], ring(slot, i)[(cnt - 1) & (m_ring_len - 1)].data());
+        }
+    }
+}
+
+bool bar_table_t::read_bar(uint16 ins_idx, int i, int back, bar_t &bar) const
+{
+    if (m_slots == NULL || i < 0 || i >= m_interval_num || back < 0 || (uint32)back >= m_ring_len)
+        return false;
+
+    uint16 slot = m_slots[ins_idx].load(std::memory_order_acquire);
+    if (slot == 0)
+        return false;
+
+    uint32 cnt = m_ins[slot - 1].bar_cnt[i].load(std::memory_order_acquire);
+    if ((uint32)back >= cnt)
+        return false;
+
+    // 读取期间写线程可能已绕回覆盖该位置，以序号确认
+    uint32 bar_no = cnt - 1 - back;
+    ring(slot - 1, i)[bar_no & (m_ring_len - 1)].read(bar);
+    return bar.bar_no == bar_no;
+}
+
+uint16 bar_table_t::alloc(uint16 ins_idx)
+{
+    if (m_ins_num >= m_max_ins)
+        return 0;
+
+    int slot = m_ins_num++;
+    m_ins[slot].ins_idx = ins_idx;
+    m_slots[ins_idx].store(slot + 1, std::memory_order_release);
+    return slot + 1;
+}
+
+void bar_table_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    // 交易日切换后合约索引重新编排，旧K线全部作废
+    if (ev.msg_idx == 0 && ev.trade_date != m_trade_date)
+    {
+        if (m_trade_date != 0)
+            clear();
+        m_trade_date = ev.trade_date;
+    }
+}
+
+void bar_table_t::on_instrument(const mdp_tick_event_t &ev)
+{
+    if (m_slots == NULL)
+        return;
+
+    uint16 slot = m_slots[ev.ins_idx].load(std::memory_order_relaxed);
+    if (slot == 0 && (slot = alloc(ev.ins_idx)) == 0)
+    {
+        m_dropped++;
+        return;
+    }
+
+    bar_ins_t &ins = m_ins[slot - 1];
+    const mdp_fields_t &fld = ev.fld;
+
+    // 累计值与上一条行情作差，首次收到只作为基准；累计值变小（如重新开盘）时从0起算
+    int dvol = 0;
+    if (fld.has(TICK_FLD_VOLUME))
+    {
+        int volume = fld.value[TICK_FLD_VOLUME];
+        if (ins.has_volume)
+            dvol = volume >= ins.volume ? volume - ins.volume : volume;
+        ins.volume = volume;
+        ins.has_volume = 1;
+    }
+
+    // 成交金额分两部分下发，用两部分的最新值合成
+    long long dval = 0;
+    if (fld.mask & ((1u << TICK_FLD_TRADE_VAL1) | (1u << TICK_FLD_TRADE_VAL2)))
+    {
+        long long old_val = ((long long)ins.trade_val1 << 26) | ins.trade_val2;
+        if (fld.has(TICK_FLD_TRADE_VAL1))
+            ins.trade_val1 = fld.value[TICK_FLD_TRADE_VAL1];
+        if (fld.has(TICK_FLD_TRADE_VAL2))
+            ins.trade_val2 = fld.value[TICK_FLD_TRADE_VAL2];
+        long long trade_val = ((long long)ins.trade_val1 << 26) | ins.trade_val2;
+        if (ins.has_trade_val)
+            dval = trade_val >= old_val ? trade_val - old_val : trade_val;
+        ins.has_trade_val = 1;
+    }
+
+    if (fld.has(TICK_FLD_LAST))
+    {
+        ins.last = fld.value[TICK_FLD_LAST];
+        ins.has_last = 1;
+    }
+
+    if (fld.has(TICK_FLD_TIME_SEC))
+    {
+        ins.day_sec = to_day_sec(fld.value[TICK_FLD_TIME_SEC]);
+        ins.has_time = 1;
+    }
+
+    // 没有时间无法归入区间，没有价格无法开K线
+    if (!ins.has_time || !ins.has_last)
+        return;
+
+    for (int i = 0; i < m_interval_num; i++)
+        update(slot - 1, i, ins, ev.price_size, dvol, dval);
+}
+
+void bar_table_t::update(int slot, int i, bar_ins_t &ins, uint16 price_size, int dvol, long long dval)
+{
+    seqlock_t<bar_t> *bars = ring(slot, i);
+    uint32 mask = m_ring_len - 1;
+    uint32 start = ins.day_sec - ins.day_sec % m_intervals[i];
+    uint32 cnt = ins.bar_cnt[i].load(std::memory_order_relaxed);
+
+    if (cnt != 0)
+    {
+        seqlock_t<bar_t> &lock = bars[(cnt - 1) & mask];
+        const bar_t &cur = lock.data();
+
+        // 同一区间，或时间小幅回退（乱序）时并入当前K线
+        if (start == cur.start || (start < cur.start && cur.start - start < BAR_SESSION_GAP))
+        {
+            bar_t &bar = lock.begin_write();
+            if (ins.last > bar.high)
+                bar.high = ins.last;
+            if (ins.last < bar.low)
+                bar.low = ins.last;
+            bar.close = ins.last;
+            bar.volume += dvol;
+            bar.trade_val += dval;
+            bar.price_size = price_size;
+            bar.tick_cnt++;
+            lock.end_write();
+            return;
+        }
+
+        if (m_bar_cb != NULL)
+            m_bar_cb(m_bar_ctx, ins.ins_idx, m_intervals[i], cur);
+    }
+
+    // 开始新的K线，写完后再发布个数，读者不会读到未写完的新K线
+    seqlock_t<bar_t> &lock = bars[cnt & mask];
+    bar_t &bar = lock.begin_write();
+    bar.bar_no = cnt;
+    bar.start = start;
+    bar.tick_cnt = 1;
+    bar.price_size = price_size;
+    bar.open = bar.high = bar.low = bar.close = ins.last;
+    bar.volume = dvol;
+    bar.trade_val = dval;
+    lock.end_write();
+
+    ins.bar_cnt[i].store(cnt + 1, std::memory_order_release);
+}
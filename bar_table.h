@@ -0,0 +1,198 @@
+#ifndef BAR_TABLE_H_
+#define BAR_TABLE_H_
+
+#include "ins_table.h"
+
+#define BAR_MAX_INTERVAL_NUM    4       ///< 最多同时聚合的周期数
+#define BAR_DEFAULT_RING_LEN    64      ///< 每个合约每个周期默认保留的K线个数
+#define BAR_DEFAULT_MAX_INS     4096    ///< 默认最多聚合的合约个数
+#define BAR_SESSION_GAP         3600    ///< 时间回退超过该秒数视为进入下一交易时段（如夜盘跨日），否则视为乱序
+
+/**
+ * @brief K线，价格和成交金额均为原始整数
+ */
+struct bar_t
+{
+    uint32 bar_no;          ///< 序号，每个合约每个周期从0开始
+    uint32 start;           ///< 起始时间，当日秒数，按周期对齐
+    uint32 tick_cnt;        ///< 区间内的行情消息数
+    uint16 price_size;      ///< 价格精度
+    int open;               ///< 开盘价
+    int high;               ///< 最高价
+    int low;                ///< 最低价
+    int close;              ///< 收盘价（区间内最新价）
+    int volume;             ///< 区间成交量
+    long long trade_val;    ///< 区间成交金额（未除价格精度）
+
+    price_t open_price() const { return price_t(open, price_size); }
+    price_t high_price() const { return price_t(high, price_size); }
+    price_t low_price() const { return price_t(low, price_size); }
+    price_t close_price() const { return price_t(close, price_size); }
+    price_t turnover() const { return price_t(trade_val, price_size); }
+
+    /**
+     * @brief 成交量加权均价，成交金额含合约乘数，需由调用方提供；无成交时为收盘价
+     */
+    double vwap(int multiplier) const
+    {
+        if (volume <= 0 || multiplier <= 0)
+            return close_price().to_double();
+        return turnover().to_double() / ((double)volume * multiplier);
+    }
+};
+
+/**
+ * @brief K线完成回调，在解码线程中调用
+ *
+ * @param ctx 回调上下文
+ * @param ins_idx 合约索引
+ * @param interval 周期秒数
+ * @param bar 已完成的K线
+ */
+typedef void (*bar_cb_t)(void *ctx, uint16 ins_idx, int interval, const bar_t &bar);
+
+/**
+ * @brief 单个合约的累计值和各周期K线个数
+ */
+struct bar_ins_t
+{
+    std::atomic<uint32> bar_cnt[BAR_MAX_INTERVAL_NUM];  ///< 各周期已开始的K线个数
+    uint32 day_sec;         ///< 最近一次行情的时间，当日秒数
+    int last;               ///< 最新价
+    int volume;             ///< 累计成交量
+    int trade_val1;         ///< 累计成交金额(part1)
+    int trade_val2;         ///< 累计成交金额(part2)
+    uint16 ins_idx;         ///< 合约索引
+    uint8 has_time;         ///< 是否收到过时间
+    uint8 has_last;         ///< 是否收到过最新价
+    uint8 has_volume;       ///< 是否收到过成交量
+    uint8 has_trade_val;    ///< 是否收到过成交金额
+};
+
+/**
+ * @brief K线聚合表
+ *
+ * 作为解码器处理器使用：单腿行情(0x10)中的累计成交量、累计成交金额按合约
+ * 与上一条行情作差得到增量，按交易所时间（字段16）归入1秒、1分钟或自定义
+ * 周期的K线，每条行情对每个周期O(1)原地更新，无查找、无内存分配。
+ *
+ * 每个合约每个周期一个定长环形缓冲，全部在init()时预先分配；合约在首次
+ * 收到行情时分配环形缓冲，超过max_ins个合约后的行情被忽略。首次收到的
+ * 累计值只作为基准，不计入K线；没有行情的区间不生成K线。
+ * 每根K线由顺序锁保护，read_bar()可在任意线程调用，写线程从不等待读者。
+ */
+class bar_table_t : public mdp_null_handler_t
+{
+public:
+    bar_table_t();
+    ~bar_table_t();
+
+    /**
+     * @brief 分配并预先映射K线内存
+     *
+     * @param intervals 周期秒数，如{1, 60}，每个周期应能整除一天的秒数以便对齐
+     * @param interval_num 周期个数，不超过BAR_MAX_INTERVAL_NUM
+     * @param ring_len 每个合约每个周期保留的K线个数，向上取为2的幂
+     * @param max_ins 最多聚合的合约个数
+     *
+     * @return 0：成功；-1：失败
+     */
+    int init(const int *intervals, int interval_num,
+            int ring_len = BAR_DEFAULT_RING_LEN, int max_ins = BAR_DEFAULT_MAX_INS);
+
+    /**
+     * @brief 设置K线完成回调，新的K线开始时对上一根调用
+     */
+    void set_bar_cb(bar_cb_t cb, void *ctx)
+    {
+        m_bar_cb = cb;
+        m_bar_ctx = ctx;
+    }
+
+    /**
+     * @brief 对所有尚未完成的K线调用回调，如回放结束时，K线本身不变
+     */
+    void flush() const;
+
+    /**
+     * @brief 清空所有K线和累计值，经顺序锁写入，read_bar()可同时在其他线程调用
+     */
+    void clear();
+
+    int get_interval_num() const { return m_interval_num; }
+    int get_interval(int i) const { return m_intervals[i]; }
+
+    /**
+     * @brief 已分配环形缓冲的合约个数
+     */
+    int get_count() const { return m_ins_num; }
+
+    /**
+     * @brief 因合约个数超过上限被忽略的行情消息数
+     */
+    uint64_t get_dropped() const { return m_dropped; }
+
+    /**
+     * @brief 读取K线的一致快照，可在任意线程调用
+     *
+     * @param ins_idx 合约索引
+     * @param i 周期序号（init()中intervals的下标）
+     * @param back 0为当前未完成的K线，1为上一根已完成的K线，依此类推
+     * @param bar 输出的K线
+     *
+     * @return true：成功；false：不存在或已被环形缓冲覆盖
+     */
+    bool read_bar(uint16 ins_idx, int i, int back, bar_t &bar) const;
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+    void on_instrument(const mdp_tick_event_t &ev);
+
+private:
+    /**
+     * @brief 交易所时间HHMMSS转为当日秒数
+     */
+    static uint32 to_day_sec(int hhmmss)
+    {
+        return hhmmss / 10000 * 3600 + hhmmss / 100 % 100 * 60 + hhmmss % 100;
+    }
+
+    /**
+     * @brief 合约第i个周期的环形缓冲
+     */
+    seqlock_t<bar_t> *ring(int slot, int i) const
+    {
+        return m_bars + ((size_t)slot * m_interval_num + i) * m_ring_len;
+    }
+
+    /**
+     * @brief 为合约分配环形缓冲
+     *
+     * @return 槽位号+1；0：已满
+     */
+    uint16 alloc(uint16 ins_idx);
+
+    /**
+     * @brief 以一条行情更新合约某个周期的K线
+     */
+    void update(int slot, int i, bar_ins_t &ins, uint16 price_size, int dvol, long long dval);
+
+private:
+    void *m_mem;                              ///< 全部内存
+    size_t m_mem_size;                        ///< 内存大小
+    bar_ins_t *m_ins;                         ///< 各槽位的累计值，共m_max_ins项
+    seqlock_t<bar_t> *m_bars;                 ///< 各槽位各周期的环形缓冲
+    std::atomic<uint16> *m_slots;             ///< 以ins_idx为下标的槽位号+1，0为未分配
+    int m_intervals[BAR_MAX_INTERVAL_NUM];    ///< 各周期秒数
+    int m_interval_num;                       ///< 周期个数
+    uint32 m_ring_len;                        ///< 环形缓冲长度，2的幂
+    int m_max_ins;                            ///< 最多聚合的合约个数
+    int m_ins_num;                            ///< 已分配的槽位个数
+    uint64_t m_dropped;                       ///< 被忽略的行情消息数
+    uint32 m_trade_date;                      ///< 当前交易日
+    bar_cb_t m_bar_cb;                        ///< K线完成回调
+    void *m_bar_ctx;                          ///< 回调上下文
+};
+
+#endif
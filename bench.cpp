@@ -0,0 +1,523 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+#include "mdp_decoder.h"
+#include "mdp_view.h"
+#include "mdp_simd.h"
+#include "print_handler.h"
+#include "ins_table.h"
+#include "order_book.h"
+#include "pkt_gen.h"
+#include "symbol_index.h"
+#include "bar_table.h"
+#include "conflate.h"
+#include "tsc_clock.h"
+
+#define BENCH_DGRAM_NUM   2048   ///< 每个数据集预生成的UDP包个数
+#define BENCH_BUF_LEN     1400   ///< 单个UDP包上限，与交易所MTU一致
+
+/**
+ * @brief 预生成的数据集
+ */
+struct bench_set_t
+{
+    const char *name;             ///< 数据集名称
+    std::vector<char> data;       ///< 所有UDP包首尾相连
+    std::vector<int> offset;      ///< 每个UDP包的起始位置
+    std::vector<int> len;         ///< 每个UDP包的长度
+    long long msg_num;            ///< 一轮包含的消息个数
+};
+
+/**
+ * @brief 汇总事件字段的处理器，避免空处理器下解码被编译器整体优化掉
+ */
+class sink_handler_t : public mdp_null_handler_t
+{
+public:
+    sink_handler_t() : m_sum(0) {}
+
+    void on_instrument_idx(const mdp_idx_event_t &ev) { m_sum += ev.ins_idx + ev.ins_id[0]; }
+    void on_instrument_init(const mdp_init_event_t &ev) { m_sum += ev.ins_idx + ev.fld.mask; }
+    void on_instrument(const mdp_tick_event_t &ev) { m_sum += ev.fld.mask + ev.trade_val; }
+    void on_cmbtype(const mdp_cmb_event_t &ev) { m_sum += ev.fld.mask + ev.ins_idx; }
+    void on_bulletine(const mdp_bulletine_event_t &ev) { m_sum += ev.text_len; }
+    void on_quot_req(const mdp_quot_req_event_t &ev) { m_sum += ev.req_no; }
+    void on_trade_status(const mdp_trade_status_event_t &ev) { m_sum += ev.trade_status; }
+    void on_depth(const mdp_depth_event_t &ev) { m_sum += ev.mask + ev.entry[1].price; }
+
+    long long m_sum;  ///< 字段累加值
+};
+
+/**
+ * @brief 组合处理器：合约状态表+五档行情表
+ */
+typedef mdp_handler_pair_t<ins_table_t, book_table_t> state_handler_t;
+typedef mdp_handler_pair_t<state_handler_t, conflate_queue_t> conflate_handler_t;
+
+/**
+ * @brief 计算消息个数
+ */
+static int count_msgs(const char *buf, int len)
+{
+    int count = 0;
+    int offset = 0;
+    while (offset + PKG_HEAD_LEN <= len)
+    {
+        const pkg_head_t *p_head = (const pkg_head_t *)(buf + offset);
+        count += p_head->msg_num;
+        offset += read_uint16((const char *)&p_head->pkg_len) + PKG_HEAD_LEN;
+    }
+    return count;
+}
+
+/**
+ * @brief 生成数据集
+ *
+ * @param mixed 为true时生成单腿+深度混合包，此时msg_type无效
+ */
+static void build_set(bench_set_t &set, pkt_gen_t &gen, const char *name,
+        uint8 msg_type, int pkg_num, int msg_num, bool mixed = false)
+{
+    char buf[BENCH_BUF_LEN];
+
+    set.name = name;
+    set.msg_num = 0;
+    for (int i = 0; i < BENCH_DGRAM_NUM; i++)
+    {
+        int len = mixed ? gen.build_mixed(buf, sizeof(buf), msg_num)
+                        : gen.build_datagram(buf, sizeof(buf), msg_type, pkg_num, msg_num);
+        set.offset.push_back(set.data.size());
+        set.len.push_back(len);
+        set.data.insert(set.data.end(), buf, buf + len);
+        set.msg_num += count_msgs(buf, len);
+    }
+}
+
+/**
+ * @brief 单个处理器配置下逐个数据集测量解码耗时
+ *
+ * @param sub 合约订阅，NULL表示处理所有合约
+ */
+template <typename handler_t>
+static void run_config(const char *config, handler_t &handler,
+        std::vector<bench_set_t> &sets, int rounds, bool quiet, subscription_t *sub = NULL)
+{
+    mdp_decoder_t<handler_t> decoder(handler);
+    decoder.set_subscription(sub);
+
+    // 输出较多的处理器把标准输出重定向到/dev/null，只测解码和格式化
+    int saved_stdout = -1;
+    if (quiet)
+    {
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+
+    std::vector<uint64_t> elapsed_ns(sets.size());
+    std::vector<uint64_t> elapsed_tsc(sets.size());
+    for (size_t s = 0; s < sets.size(); s++)
+    {
+        bench_set_t &set = sets[s];
+        const char *data = &set.data[0];
+
+        // 预热一轮，使状态表和缓存进入稳定状态
+        for (size_t i = 0; i < set.len.size(); i++)
+            decoder.process_data(data + set.offset[i], set.len[i]);
+
+        uint64_t ns0 = monotonic_ns();
+        uint64_t tsc0 = rdtsc();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (size_t i = 0; i < set.len.size(); i++)
+                decoder.process_data(data + set.offset[i], set.len[i]);
+        }
+        elapsed_tsc[s] = rdtsc() - tsc0;
+        elapsed_ns[s] = monotonic_ns() - ns0;
+    }
+
+    if (quiet)
+    {
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    for (size_t s = 0; s < sets.size(); s++)
+    {
+        double msgs = (double)sets[s].msg_num * rounds;
+        double ns = elapsed_ns[s] > 0 ? (double)elapsed_ns[s] : 1;
+        printf("%-8s %-12s %12.0f %12.2f %12.2f %10.1f\n", config, sets[s].name,
+                msgs * 1e9 / ns, ns / msgs, (double)elapsed_tsc[s] / msgs,
+                (double)sets[s].data.size() / sets[s].len.size());
+    }
+}
+
+/**
+ * @brief 按偏移手工遍历UDP包，累加所有字段，作为视图遍历的对照
+ */
+static long long walk_manual(const char *buf, int len)
+{
+    long long sum = 0;
+    int offset = 0;
+    while (offset + PKG_HEAD_LEN <= len)
+    {
+        const pkg_head_t *p_head = (const pkg_head_t *)(buf + offset);
+        int pkg_len = read_uint16((const char *)&p_head->pkg_len);
+        if (pkg_len > len - offset - PKG_HEAD_LEN)
+            break;
+
+        int pos = 0;
+        for (int i = 0; i < p_head->msg_num && pos + MSG_HEAD_LEN <= pkg_len; i++)
+        {
+            const char *p_msg = p_head->pkg_data + pos;
+            int msg_total = read_uint16(p_msg);
+            if (msg_total < MSG_HEAD_LEN || msg_total > pkg_len - pos)
+                break;
+
+            const char *p_data = p_msg + MSG_HEAD_LEN;
+            int msg_len = msg_total - MSG_HEAD_LEN;
+            int data_pos = 4;
+            if (p_head->msg_type == PACKAGE_DEPTH)
+            {
+                while (data_pos + 8 <= msg_len)
+                {
+                    int fld_idx, price, qty, ord_cnt;
+                    data_pos += get_dep_orderbook(&p_data[data_pos], fld_idx, price, qty, ord_cnt);
+                    sum += fld_idx + price + qty + ord_cnt;
+                }
+            }
+            else
+            {
+                while (data_pos + 4 <= msg_len)
+                {
+                    int fld_idx, value;
+                    data_pos += get_int_value(&p_data[data_pos], fld_idx, value);
+                    sum += fld_idx + value;
+                }
+            }
+
+            pos += msg_total;
+        }
+
+        offset += pkg_len + PKG_HEAD_LEN;
+    }
+    return sum;
+}
+
+/**
+ * @brief 用mdp_view.h中的视图遍历UDP包，结果应与walk_manual()一致
+ */
+static long long walk_view(const char *buf, int len)
+{
+    long long sum = 0;
+    mdp_datagram_view_t dgram(buf, len);
+    for (const mdp_pkg_view_t &pkg : dgram)
+    {
+        for (const mdp_msg_view_t &msg : pkg)
+        {
+            if (pkg.type() == PACKAGE_DEPTH)
+            {
+                for (mdp_depth_field_t f : msg.depth_fields(4))
+                    sum += f.fld_idx + f.price + f.qty + f.ord_cnt;
+            }
+            else
+            {
+                for (mdp_field_t f : msg.fields(4))
+                    sum += f.fld_idx + f.value;
+            }
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief 用批量字段解码遍历UDP包，每个消息的字段先整体解码到数组再累加，结果应与walk_manual()一致
+ */
+static long long walk_batch(const char *buf, int len)
+{
+    int fld_idx[BENCH_BUF_LEN / 4];
+    int value[BENCH_BUF_LEN / 4];
+    int qty[BENCH_BUF_LEN / 8];
+    int ord_cnt[BENCH_BUF_LEN / 8];
+
+    long long sum = 0;
+    mdp_datagram_view_t dgram(buf, len);
+    for (const mdp_pkg_view_t &pkg : dgram)
+    {
+        for (const mdp_msg_view_t &msg : pkg)
+        {
+            if (pkg.type() == PACKAGE_DEPTH)
+            {
+                int count = msg.depth_fields(4).size();
+                get_dep_orderbooks(msg.data() + 4, count, fld_idx, value, qty, ord_cnt);
+                for (int i = 0; i < count; i++)
+                    sum += fld_idx[i] + value[i] + qty[i] + ord_cnt[i];
+            }
+            else
+            {
+                int count = msg.fields(4).size();
+                get_int_values(msg.data() + 4, count, fld_idx, value);
+                for (int i = 0; i < count; i++)
+                    sum += fld_idx[i] + value[i];
+            }
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief 测量遍历函数逐个数据集的耗时，不经过解码器和处理器
+ */
+static void run_walk(const char *config, long long (*walk)(const char *, int),
+        std::vector<bench_set_t> &sets, int rounds)
+{
+    long long sum = 0;
+    for (size_t s = 0; s < sets.size(); s++)
+    {
+        bench_set_t &set = sets[s];
+        const char *data = &set.data[0];
+
+        for (size_t i = 0; i < set.len.size(); i++)
+            sum += walk(data + set.offset[i], set.len[i]);
+
+        uint64_t ns0 = monotonic_ns();
+        uint64_t tsc0 = rdtsc();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (size_t i = 0; i < set.len.size(); i++)
+                sum += walk(data + set.offset[i], set.len[i]);
+        }
+        uint64_t tsc = rdtsc() - tsc0;
+        uint64_t ns = monotonic_ns() - ns0;
+
+        double msgs = (double)set.msg_num * rounds;
+        printf("%-8s %-12s %12.0f %12.2f %12.2f %10.1f\n", config, set.name,
+                msgs * 1e9 / (ns > 0 ? ns : 1), ns / msgs, tsc / msgs,
+                (double)set.data.size() / set.len.size());
+    }
+    printf("%s checksum: %lld\n", config, sum);
+}
+
+/**
+ * @brief 合约编码查找：完美哈希表对照以std::string为键的unordered_map
+ *
+ * 查询序列中约1/8为不存在的编码
+ */
+static void run_lookup(const pkt_gen_t &gen, int rounds)
+{
+    std::vector<symbol_index_t::entry_t> entries;
+    std::unordered_map<std::string, int> str_map;
+    for (int i = 0; i < gen.get_ins_num(); i++)
+    {
+        symbol_index_t::entry_t entry;
+        symbol_index_t::make_key(gen.get_ins_id(i), entry.key);
+        entry.ins_idx = i;
+        entries.push_back(entry);
+        str_map[gen.get_ins_id(i)] = i;
+    }
+
+    uint64_t ns0 = monotonic_ns();
+    symbol_index_t index;
+    index.build(entries);
+    uint64_t build_ns = monotonic_ns() - ns0;
+
+    std::vector<char> names(BENCH_DGRAM_NUM * MDP_INS_ID_LEN);
+    std::vector<symbol_key_t> keys(BENCH_DGRAM_NUM);
+    for (int i = 0; i < BENCH_DGRAM_NUM; i++)
+    {
+        char *name = &names[i * MDP_INS_ID_LEN];
+        if (i % 8 == 7)
+            snprintf(name, MDP_INS_ID_LEN, "XX%d", i);
+        else
+            snprintf(name, MDP_INS_ID_LEN, "%s", gen.get_ins_id((i * 7919) % gen.get_ins_num()));
+        symbol_index_t::make_key(name, keys[i]);
+    }
+
+    // key为预先转换好的键，只测哈希和比较
+    const char *kinds[] = {"index", "key", "unordered"};
+    long long sum = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        uint64_t t0 = monotonic_ns();
+        uint64_t tsc0 = rdtsc();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (int i = 0; i < BENCH_DGRAM_NUM; i++)
+            {
+                const char *name = &names[i * MDP_INS_ID_LEN];
+                if (k == 0)
+                {
+                    sum += index.find(name);
+                }
+                else if (k == 1)
+                {
+                    sum += index.find(keys[i]);
+                }
+                else
+                {
+                    std::unordered_map<std::string, int>::const_iterator it = str_map.find(name);
+                    sum += it != str_map.end() ? it->second : -1;
+                }
+            }
+        }
+        uint64_t tsc = rdtsc() - tsc0;
+        double ns = (double)(monotonic_ns() - t0);
+        double num = (double)BENCH_DGRAM_NUM * rounds;
+        printf("%-8s %-12s %12.0f %12.2f %12.2f %10s\n", "lookup", kinds[k],
+                num * 1e9 / (ns > 0 ? ns : 1), ns / num, (double)tsc / num, "-");
+    }
+    printf("lookup checksum: %lld, symbols = %d, table bytes = %d, build us = %.1f\n",
+            sum, index.get_count(), (int)index.mem_size(), build_ns / 1e3);
+}
+
+static void usage(const char *prog)
+{
+    printf("usage: %s [-s seed] [-n rounds] [-c config]\n", prog);
+    printf("  -s seed    随机种子，默认1\n");
+    printf("  -n rounds  每个数据集重复轮数，默认200\n");
+    printf("  -c config  只运行指定配置：sink/table/state/print，或遍历对照manual/view/batch，filter为只订阅SR品种，lookup为合约编码查找，bars为1秒+1分钟K线聚合，conflate为state加合并输出队列标记\n");
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long seed = 1;
+    int rounds = 200;
+    const char *only = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:c:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'n':
+            rounds = atoi(optarg);
+            break;
+        case 'c':
+            only = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (rounds < 1)
+        rounds = 1;
+
+    pkt_gen_t gen(seed);
+
+    // 合约索引放在最前，后续数据集的合约在状态表中都已存在
+    std::vector<bench_set_t> sets(11);
+    build_set(sets[0], gen, "0x05", PACKAGE_INSTRUMENT_IDX, 1, 20);
+    build_set(sets[1], gen, "0x06", PACKAGE_INSTRUMENT_INIT, 1, 20);
+    build_set(sets[2], gen, "0x10", PACKAGE_INSTRUMENT, 1, 10);
+    build_set(sets[3], gen, "0x11", PACKAGE_CMBTYPE, 1, 10);
+    build_set(sets[4], gen, "0x12", PACKAGE_BULLETINE, 1, 1);
+    build_set(sets[5], gen, "0x13", PACKAGE_QUOT_REQ, 1, 5);
+    build_set(sets[6], gen, "0x14", PACKAGE_TRADE_STATUS, 1, 1);
+    build_set(sets[7], gen, "0x20", PACKAGE_DEPTH, 1, 10);
+    build_set(sets[8], gen, "0x10x1", PACKAGE_INSTRUMENT, 1, 1);
+    build_set(sets[9], gen, "0x10multi", PACKAGE_INSTRUMENT, 4, 5);
+    build_set(sets[10], gen, "0x10+0x20", 0, 1, 5, true);
+
+    printf("seed=%llu rounds=%d datagrams/set=%d tsc/ns=%.3f\n",
+            seed, rounds, BENCH_DGRAM_NUM, tsc_per_ns());
+    printf("%-8s %-12s %12s %12s %12s %10s\n", "config", "set", "msgs/s", "ns/msg", "tsc/msg", "bytes/pkt");
+
+    // 只遍历字段不产生事件，对照手工偏移解析与视图迭代的开销
+    if (only == NULL || strcmp(only, "manual") == 0)
+        run_walk("manual", walk_manual, sets, rounds);
+
+    if (only == NULL || strcmp(only, "view") == 0)
+        run_walk("view", walk_view, sets, rounds);
+
+    // 批量字段解码逐级对比，标量级别即逐个字段解码到数组
+    if (only == NULL || strcmp(only, "batch") == 0)
+    {
+        mdp_simd_level_t best = get_simd_level();
+        for (int level = MDP_SIMD_SCALAR; level <= best; level++)
+        {
+            set_simd_level((mdp_simd_level_t)level);
+            run_walk(get_simd_name((mdp_simd_level_t)level), walk_batch, sets, rounds);
+        }
+        set_simd_level(best);
+    }
+
+    if (only == NULL || strcmp(only, "lookup") == 0)
+        run_lookup(gen, rounds);
+
+    if (only == NULL || strcmp(only, "sink") == 0)
+    {
+        sink_handler_t sink;
+        run_config("sink", sink, sets, rounds, false);
+        printf("sink checksum: %lld\n", sink.m_sum);
+    }
+
+    // 只订阅一个品种（约1/14的合约），其余行情消息读取合约索引后跳过
+    if (only == NULL || strcmp(only, "filter") == 0)
+    {
+        sink_handler_t sink;
+        subscription_t sub;
+        sub.add_product("SR");
+        run_config("filter", sink, sets, rounds, false, &sub);
+        printf("filter checksum: %lld, subscribed = %d\n", sink.m_sum, sub.get_count());
+    }
+
+    ins_table_t table;
+    book_table_t books;
+    if (table.init() != 0 || books.init() != 0)
+    {
+        printf("state table init failed.\n");
+        return 1;
+    }
+
+    if (only == NULL || strcmp(only, "table") == 0)
+        run_config("table", table, sets, rounds, false);
+
+    if (only == NULL || strcmp(only, "state") == 0)
+    {
+        state_handler_t state(table, books);
+        run_config("state", state, sets, rounds, false);
+    }
+
+    // 没有消费者，标记很快全部置位，测得的是解码线程每条消息多出的原子或操作
+    if (only == NULL || strcmp(only, "conflate") == 0)
+    {
+        state_handler_t state(table, books);
+        conflate_queue_t queue;
+        conflate_handler_t handler(state, queue);
+        run_config("conflate", handler, sets, rounds, false);
+    }
+
+    if (only == NULL || strcmp(only, "bars") == 0)
+    {
+        bar_table_t bars;
+        const int intervals[] = {1, 60};
+        if (bars.init(intervals, 2) != 0)
+        {
+            printf("bar table init failed.\n");
+            return 1;
+        }
+        run_config("bars", bars, sets, rounds, false);
+    }
+
+    // 打印格式化耗时远高于解码，减少轮数
+    if (only == NULL || strcmp(only, "print") == 0)
+    {
+        print_handler_t printer;
+        run_config("print", printer, sets, rounds / 20 > 0 ? rounds / 20 : 1, true);
+    }
+
+    return 0;
+}
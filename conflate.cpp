@@ -0,0 +1,72 @@
+#include "conflate.h"
+
+conflate_queue_t::conflate_queue_t()
+{
+    m_cursor = 0;
+    m_delivered = 0;
+    for (int i = 0; i < CONFLATE_SUMMARY_WORDS; i++)
+        m_summary[i] = 0;
+    for (int i = 0; i < CONFLATE_LEAF_WORDS; i++)
+        m_leaf[i] = 0;
+}
+
+int conflate_queue_t::poll(uint16 *ins_idx, int max)
+{
+    // 先取游标之后的合约，不够时再从头取到游标处
+    int start = m_cursor;
+    int count = collect(start, INS_TABLE_SIZE, ins_idx, max, 0);
+    if (count < max && start > 0)
+        count = collect(0, start, ins_idx, max, count);
+
+    m_delivered += count;
+    return count;
+}
+
+int conflate_queue_t::collect(int begin, int end, uint16 *ins_idx, int max, int count)
+{
+    if (begin >= end)
+        return count;
+
+    int first_word = begin >> 6;
+    int last_word = (end - 1) >> 6;
+    for (int s = first_word >> 6; s <= (last_word >> 6) && count < max; s++)
+    {
+        // 只取范围内叶子字的汇总位，范围外的留给另一段扫描
+        int lo = first_word > s * 64 ? first_word - s * 64 : 0;
+        int hi = last_word < s * 64 + 63 ? last_word - s * 64 : 63;
+        uint64_t range = bit_range(lo, hi);
+        if ((m_summary[s].load(std::memory_order_relaxed) & range) == 0)
+            continue;
+
+        uint64_t summary = m_summary[s].fetch_and(~range, std::memory_order_acquire) & range;
+        while (summary != 0)
+        {
+            int word = s * 64 + __builtin_ctzll(summary);
+            summary &= summary - 1;
+
+            // 数组已满，未取的叶子字只放回汇总位
+            if (count == max)
+            {
+                restore(word, 0);
+                continue;
+            }
+
+            // 清叶子字后再读合约表，读到的至少是置位之前的更新
+            uint64_t leaf = m_leaf[word].exchange(0, std::memory_order_acquire);
+            uint64_t keep = leaf & ~bit_range(word == first_word ? begin & 63 : 0, word == last_word ? (end - 1) & 63 : 63);
+            leaf &= ~keep;
+            while (leaf != 0 && count < max)
+            {
+                int idx = word * 64 + __builtin_ctzll(leaf);
+                ins_idx[count++] = idx;
+                m_cursor = (idx + 1) & (INS_TABLE_SIZE - 1);
+                leaf &= leaf - 1;
+            }
+
+            if ((leaf | keep) != 0)
+                restore(word, leaf | keep);
+        }
+    }
+
+    return count;
+}
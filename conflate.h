@@ -0,0 +1,102 @@
+#ifndef CONFLATE_H_
+#define CONFLATE_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "ins_table.h"
+
+#define CONFLATE_LEAF_WORDS     (INS_TABLE_SIZE / 64)       ///< 每个ins_idx一位，共1024个64位字
+#define CONFLATE_SUMMARY_WORDS  (CONFLATE_LEAF_WORDS / 64)  ///< 每个叶子字一位，共16个64位字
+
+/**
+ * @brief 合并输出队列（供慢消费者使用）
+ *
+ * 作为解码器处理器放在合约表、盘口表之后：单腿/组合/深度行情更新表后只把该合约
+ * 在脏位图中置位，每个合约最多一个待处理标记，内存固定，解码线程从不等待消费者。
+ * 消费者用poll()取出有变化的ins_idx，再从ins_table_t/book_table_t读取最新的
+ * 一致快照，因此总是拿到每个合约最新的状态，积压期间的中间行情被合并掉。
+ *
+ * 位图分两级：叶子位图每个ins_idx一位，汇总位图每个叶子字一位，消费者只扫描
+ * 16个汇总字即可找到所有脏合约。生产者先置叶子位再置汇总位，消费者先清汇总位
+ * 再清叶子位，标记不会丢失；置位都是原子或操作，可同时放进两个通道的处理器组合。
+ * 同一队列只能有一个消费者，多个消费者各自使用一个队列。
+ */
+class conflate_queue_t : public mdp_null_handler_t
+{
+public:
+    conflate_queue_t();
+
+    /**
+     * @brief 取出有变化的合约，只能由唯一的消费者线程调用
+     *
+     * 取出的合约标记被清除，之后的行情会重新标记；超过max个时剩余的标记保留到下次，
+     * 下次从最后取出的合约之后继续，扫到末尾再回到开头，避免索引靠后的合约被饿死。
+     *
+     * @param ins_idx 输出的合约索引数组
+     * @param max 数组长度
+     *
+     * @return 取出的合约个数，0表示没有变化
+     */
+    int poll(uint16 *ins_idx, int max);
+
+    /**
+     * @brief 已取出的合约标记总数
+     */
+    uint64_t get_delivered() const { return m_delivered; }
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument(const mdp_tick_event_t &ev) { mark(ev.ins_idx); }
+    void on_cmbtype(const mdp_cmb_event_t &ev) { mark(ev.ins_idx); }
+    void on_depth(const mdp_depth_event_t &ev) { mark(ev.ins_idx); }
+
+private:
+    /**
+     * @brief 标记合约有变化
+     *
+     * 原子或操作同时是完整的内存屏障，之前对合约表的写入先于标记可见。
+     * 叶子字原来不为0时汇总位已置位，或消费者正在取该字，不必再置汇总位。
+     */
+    void mark(uint16 ins_idx)
+    {
+        uint64_t old = m_leaf[ins_idx >> 6].fetch_or(1ULL << (ins_idx & 63), std::memory_order_acq_rel);
+        if (old == 0)
+            m_summary[ins_idx >> 12].fetch_or(1ULL << ((ins_idx >> 6) & 63), std::memory_order_release);
+    }
+
+    /**
+     * @brief 取出ins_idx在[begin, end)内的标记，范围外被一并取出的位原样放回
+     *
+     * @return 加上本次取出后的合约个数
+     */
+    int collect(int begin, int end, uint16 *ins_idx, int max, int count);
+
+    /**
+     * @brief 第lo~hi位（含）为1的掩码
+     */
+    static uint64_t bit_range(int lo, int hi)
+    {
+        return (~0ULL >> (63 - hi)) & (~0ULL << lo);
+    }
+
+    /**
+     * @brief 放回未取完的标记，顺序与生产者相同：先叶子后汇总
+     */
+    void restore(int word, uint64_t leaf)
+    {
+        if (leaf != 0)
+            m_leaf[word].fetch_or(leaf, std::memory_order_relaxed);
+        m_summary[word >> 6].fetch_or(1ULL << (word & 63), std::memory_order_release);
+    }
+
+private:
+    int m_cursor;                                             ///< 下次开始扫描的ins_idx（消费者）
+    uint64_t m_delivered;                                     ///< 已取出的标记数（消费者）
+
+    char m_pad[64];                                           ///< 隔开消费者私有变量和位图
+    std::atomic<uint64_t> m_summary[CONFLATE_SUMMARY_WORDS];  ///< 汇总位图
+    std::atomic<uint64_t> m_leaf[CONFLATE_LEAF_WORDS];        ///< 叶子位图
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "feed_stats.h"
+#include "tsc_clock.h"
+
+feed_stats_table_t::feed_stats_table_t()
+{
+    m_base = NULL;
+    m_size = 0;
+    m_header = NULL;
+    m_channels = NULL;
+}
+
+feed_stats_table_t::~feed_stats_table_t()
+{
+    if (m_base != NULL)
+        munmap(m_base, m_size);
+}
+
+int feed_stats_table_t::init(const char *shm_name, int channel_num)
+{
+    if (m_base != NULL)
+    {
+        printf("feed stats table has been created!\n");
+        return -1;
+    }
+
+    if (channel_num < 1 || channel_num > FEED_STATS_MAX_CHANNEL)
+    {
+        printf("invalid feed stats channel number: %d (1 ~ %d)\n", channel_num, FEED_STATS_MAX_CHANNEL);
+        return -1;
+    }
+
+    uint64_t size = sizeof(feed_stats_header_t) + (uint64_t)channel_num * sizeof(feed_stats_t);
+    void *mem = MAP_FAILED;
+    if (shm_name == NULL)
+    {
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    }
+    else
+    {
+        if (shm_unlink(shm_name) != 0 && errno != ENOENT)
+        {
+            perror("unlink feed stats shared memory");
+            return -2;
+        }
+
+        int fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            perror("create feed stats shared memory");
+            return -2;
+        }
+
+        if (ftruncate(fd, size) != 0)
+        {
+            perror("resize feed stats shared memory");
+            close(fd);
+            shm_unlink(shm_name);
+            return -3;
+        }
+
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        close(fd);
+    }
+
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap feed stats");
+        if (shm_name != NULL)
+            shm_unlink(shm_name);
+        return -4;
+    }
+
+    // 新映射的内存为全零，即所有计数的初始状态
+    m_base = (char *)mem;
+    m_size = size;
+    m_header = (feed_stats_header_t *)m_base;
+    m_channels = (feed_stats_t *)(m_base + sizeof(feed_stats_header_t));
+
+    m_header->version = FEED_STATS_VERSION;
+    m_header->channel_num = channel_num;
+    m_header->writer_pid = getpid();
+    m_header->session_id = realtime_ns();
+
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = FEED_STATS_MAGIC;
+
+    return 0;
+}
+
+int feed_stats_table_t::open(const char *shm_name)
+{
+    if (m_base != NULL)
+    {
+        printf("feed stats table has been opened!\n");
+        return -1;
+    }
+
+    int fd = shm_open(shm_name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        perror("open feed stats shared memory");
+        return -2;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(feed_stats_header_t))
+    {
+        printf("feed stats %s is not ready\n", shm_name);
+        ::close(fd);
+        return -4;
+    }
+
+    void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap feed stats");
+        return -3;
+    }
+
+    feed_stats_header_t *header = (feed_stats_header_t *)mem;
+    if (header->magic != FEED_STATS_MAGIC)
+    {
+        printf("feed stats %s is not ready\n", shm_name);
+        munmap(mem, st.st_size);
+        return -4;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (header->version != FEED_STATS_VERSION || header->channel_num > FEED_STATS_MAX_CHANNEL
+            || sizeof(feed_stats_header_t) + header->channel_num * sizeof(feed_stats_t) > (size_t)st.st_size)
+    {
+        printf("feed stats %s layout mismatch, version = %u\n", shm_name, header->version);
+        munmap(mem, st.st_size);
+        return -5;
+    }
+
+    m_base = (char *)mem;
+    m_size = st.st_size;
+    m_header = header;
+    m_channels = (feed_stats_t *)(m_base + sizeof(feed_stats_header_t));
+
+    return 0;
+}
+
+feed_stats_t *feed_stats_table_t::get(int channel)
+{
+    if (m_header == NULL || channel < 0 || channel >= (int)m_header->channel_num)
+        return NULL;
+    return &m_channels[channel];
+}
+
+void feed_stats_table_t::print(const feed_stats_t &stats)
+{
+    printf("channel %u %s: packets = %llu, bytes = %llu, timeouts = %llu, recv errors = %llu, "
+            "kernel drops = %llu, unknown types = %llu, malformed = %llu, filtered = %llu\n",
+            stats.channel_id, stats.name,
+            (unsigned long long)stats.packets.load(std::memory_order_relaxed),
+            (unsigned long long)stats.bytes.load(std::memory_order_relaxed),
+            (unsigned long long)stats.timeouts.load(std::memory_order_relaxed),
+            (unsigned long long)stats.recv_errors.load(std::memory_order_relaxed),
+            (unsigned long long)stats.rxq_drops.load(std::memory_order_relaxed),
+            (unsigned long long)stats.unknown_types.load(std::memory_order_relaxed),
+            (unsigned long long)stats.malformed.load(std::memory_order_relaxed),
+            (unsigned long long)stats.filtered.load(std::memory_order_relaxed));
+
+    for (int i = 0; i < 256; i++)
+    {
+        uint64_t n = stats.msgs[i].load(std::memory_order_relaxed);
+        if (n != 0)
+            printf("  0x%02x: %llu\n", i, (unsigned long long)n);
+    }
+}
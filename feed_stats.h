@@ -0,0 +1,107 @@
+#ifndef FEED_STATS_H_
+#define FEED_STATS_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "mdp_protocol.h"
+
+#define FEED_STATS_MAGIC        0x54535A43  ///< "CZST"
+#define FEED_STATS_VERSION      2
+#define FEED_STATS_MAX_CHANNEL  8           ///< 最多统计的通道数
+#define FEED_STATS_NAME_LEN     32          ///< 通道名称最大长度
+
+/**
+ * @brief 单个通道的行情健康计数
+ *
+ * 每个计数只由该通道的接收线程写入，用relaxed读加写代替原子加；
+ * 其他线程或进程可随时读取，各计数之间不保证同一时刻。
+ */
+struct alignas(64) feed_stats_t
+{
+    char name[FEED_STATS_NAME_LEN];         ///< 通道名称，如"239.26.1.1:23001"
+    uint16 channel_id;                      ///< 通道号
+
+    std::atomic<uint64_t> packets;          ///< 收到的UDP包数
+    std::atomic<uint64_t> bytes;            ///< 收到的字节数
+    std::atomic<uint64_t> timeouts;         ///< 接收超时次数
+    std::atomic<uint64_t> recv_errors;      ///< 接收出错次数
+    std::atomic<uint64_t> rxq_drops;        ///< 内核因接收队列满丢弃的包数(SO_RXQ_OVFL)，累计值
+    std::atomic<uint64_t> unknown_types;    ///< 未知报文类型
+    std::atomic<uint64_t> malformed;        ///< 长度不合法的UDP包
+    std::atomic<uint64_t> filtered;         ///< 因合约未订阅而跳过的消息数
+    std::atomic<uint64_t> last_recv_ns;     ///< 最近一次收包的系统时钟(ns)
+    std::atomic<uint64_t> msgs[256];        ///< 按报文类型的消息数
+
+    /**
+     * @brief 单写者计数累加
+     */
+    static void add(std::atomic<uint64_t> &counter, uint64_t n = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 统计页头部
+ */
+struct alignas(64) feed_stats_header_t
+{
+    uint32 magic;           ///< 初始化完成后写入FEED_STATS_MAGIC
+    uint32 version;         ///< 布局版本
+    uint32 channel_num;     ///< 通道数
+    int writer_pid;         ///< 写入进程号
+    uint64_t session_id;    ///< 创建时间(ns)，写入进程重启后变化
+};
+
+/**
+ * @brief 各通道行情健康计数表
+ *
+ * 写入端用init()创建，给定名称时建在POSIX共享内存上，旁路进程用open()只读挂接后
+ * 随时读取；不给名称时只在进程内使用。布局：头部 | feed_stats_t * channel_num。
+ */
+class feed_stats_table_t
+{
+public:
+    feed_stats_table_t();
+    ~feed_stats_table_t();
+
+    /**
+     * @brief 创建计数表，已存在的同名共享内存被删除后重建
+     *
+     * @param shm_name 共享内存名称，如"/czce_md_stats"；NULL表示进程内匿名内存
+     * @param channel_num 通道数，最大FEED_STATS_MAX_CHANNEL
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int init(const char *shm_name, int channel_num);
+
+    /**
+     * @brief 只读挂接写入端创建的计数表
+     *
+     * @return 0：成功；-4：写入端尚未完成初始化；其他：错误码
+     */
+    int open(const char *shm_name);
+
+    /**
+     * @brief 获取通道计数，写入端使用
+     */
+    feed_stats_t *get(int channel);
+
+    const feed_stats_t &at(int channel) const { return m_channels[channel]; }
+    int get_channel_num() const { return m_header == NULL ? 0 : m_header->channel_num; }
+    uint64_t get_session_id() const { return m_header == NULL ? 0 : m_header->session_id; }
+
+    /**
+     * @brief 打印单个通道的计数
+     */
+    static void print(const feed_stats_t &stats);
+
+private:
+    char *m_base;                   ///< 映射起始地址
+    uint64_t m_size;                ///< 映射大小
+    feed_stats_header_t *m_header;  ///< 头部
+    feed_stats_t *m_channels;       ///< 各通道计数
+};
+
+#endif
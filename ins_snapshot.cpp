@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ins_snapshot.h"
+#include "tsc_clock.h"
+
+static bool entry_less(const snap_entry_t &entry, uint16 ins_idx)
+{
+    return entry.ins_idx < ins_idx;
+}
+
+ins_snapshot_t::ins_snapshot_t()
+{
+    m_map = NULL;
+    m_map_len = 0;
+    m_header = NULL;
+    m_entries = NULL;
+    m_replaying = false;
+    m_live_date = 0;
+    m_idx_same = 0;
+    m_idx_diff = 0;
+    m_init_same = 0;
+    m_init_diff = 0;
+}
+
+ins_snapshot_t::~ins_snapshot_t()
+{
+    close();
+}
+
+int ins_snapshot_t::save(const ins_table_t &table, const char *dir, const char *name)
+{
+    uint32 trade_date = table.get_trade_date();
+    if (trade_date == 0)
+        return -1;
+
+    // 按ins_idx顺序读取，快照天然有序
+    std::vector<snap_entry_t> entries;
+    ins_info_t info;
+    for (int i = 0; i < INS_TABLE_SIZE; i++)
+    {
+        if (!table.read_info(i, info))
+            continue;
+
+        snap_entry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.ins_idx = i;
+        entry.ins_type = info.ins_type;
+        entry.has_init = info.has_init;
+        entry.init_mask = info.init_mask;
+        entry.price_size = info.price_size;
+        memcpy(entry.ins_id, info.ins_id, sizeof(entry.ins_id));
+        entry.last_close = info.last_close;
+        entry.last_clear = info.last_clear;
+        entry.last_holding = info.last_holding;
+        entry.limit_up = info.limit_up;
+        entry.limit_down = info.limit_down;
+        entries.push_back(entry);
+    }
+
+    // 交易日在读取期间切换时合约表已被清空，放弃本次保存
+    if (entries.empty() || table.get_trade_date() != trade_date)
+        return -1;
+
+    snap_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAP_MAGIC, sizeof(header.magic));
+    header.version = SNAP_VERSION;
+    header.header_len = sizeof(header);
+    header.trade_date = trade_date;
+    header.count = entries.size();
+    header.entry_size = sizeof(snap_entry_t);
+    header.create_ns = realtime_ns();
+
+    char path[1024], tmp_path[1100];
+    snprintf(path, sizeof(path), "%s/%s_%u%s", dir, name, trade_date, SNAP_SUFFIX);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL)
+    {
+        perror("create snapshot file");
+        return -1;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+            && fwrite(&entries[0], sizeof(snap_entry_t), entries.size(), fp) == entries.size()
+            && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0)
+        ok = false;
+
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        perror("write snapshot file");
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+uint32 ins_snapshot_t::min_trade_date(time_t now)
+{
+    struct tm tm;
+    localtime_r(&now, &tm);
+    if (tm.tm_hour >= SNAP_DAY_CLOSE_HOUR)
+    {
+        now += 86400;
+        localtime_r(&now, &tm);
+    }
+    return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+
+int ins_snapshot_t::open_latest(const char *dir, const char *name, uint32 min_date)
+{
+    DIR *dp = opendir(dir);
+    if (dp == NULL)
+    {
+        perror("open snapshot directory");
+        return -1;
+    }
+
+    // 文件名为<名称>_<交易日>.snap，取交易日最大的一个
+    std::string prefix = std::string(name) + "_";
+    uint32 latest = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dp)) != NULL)
+    {
+        if (strncmp(ent->d_name, prefix.c_str(), prefix.size()) != 0)
+            continue;
+
+        unsigned int date = 0;
+        char suffix[16] = "";
+        if (sscanf(ent->d_name + prefix.size(), "%8u%15s", &date, suffix) == 2
+                && strcmp(suffix, SNAP_SUFFIX) == 0 && date > latest)
+        {
+            latest = date;
+        }
+    }
+    closedir(dp);
+
+    if (latest == 0 || latest < min_date)
+    {
+        printf("no snapshot %s for trade date >= %u, latest = %u\n", name, min_date, latest);
+        return -1;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s_%u%s", dir, name, latest, SNAP_SUFFIX);
+    return open(path);
+}
+
+int ins_snapshot_t::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("open snapshot file");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snap_file_header_t))
+    {
+        printf("invalid snapshot file: %s\n", path);
+        ::close(fd);
+        return -1;
+    }
+
+    void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap snapshot file");
+        return -1;
+    }
+
+    const snap_file_header_t *header = (const snap_file_header_t *)mem;
+    if (memcmp(header->magic, SNAP_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAP_VERSION
+            || header->header_len != sizeof(snap_file_header_t) || header->entry_size != sizeof(snap_entry_t)
+            || header->header_len + (uint64_t)header->count * header->entry_size > (uint64_t)st.st_size)
+    {
+        printf("invalid snapshot file header: %s\n", path);
+        munmap(mem, st.st_size);
+        return -1;
+    }
+
+    m_map = (char *)mem;
+    m_map_len = st.st_size;
+    m_header = header;
+    m_entries = (const snap_entry_t *)(m_map + header->header_len);
+    m_live_date = 0;
+    return 0;
+}
+
+void ins_snapshot_t::close()
+{
+    if (m_map == NULL)
+        return;
+
+    munmap(m_map, m_map_len);
+    m_map = NULL;
+    m_map_len = 0;
+    m_header = NULL;
+    m_entries = NULL;
+}
+
+const snap_entry_t *ins_snapshot_t::find(uint16 ins_idx) const
+{
+    const snap_entry_t *end = m_entries + m_header->count;
+    const snap_entry_t *entry = std::lower_bound(m_entries, end, ins_idx, entry_less);
+    return entry != end && entry->ins_idx == ins_idx ? entry : NULL;
+}
+
+void ins_snapshot_t::print_stats(const char *name) const
+{
+    if (m_header == NULL)
+        return;
+
+    printf("snapshot %s: trade date = %u, instruments = %u, live trade date = %u, "
+            "index same = %lu, diff = %lu, init same = %lu, diff = %lu\n",
+            name, m_header->trade_date, m_header->count, m_live_date,
+            (unsigned long)m_idx_same, (unsigned long)m_idx_diff,
+            (unsigned long)m_init_same, (unsigned long)m_init_diff);
+}
+
+void ins_snapshot_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    if (m_header == NULL || m_replaying)
+        return;
+
+    if (ev.msg_idx == 0 && ev.trade_date != m_live_date)
+    {
+        m_live_date = ev.trade_date;
+        if (m_live_date != m_header->trade_date)
+            printf("snapshot trade date %u is stale, live trade date = %u\n", m_header->trade_date, m_live_date);
+    }
+
+    if (!live_matches())
+        return;
+
+    const snap_entry_t *entry = find(ev.ins_idx);
+    if (entry != NULL && entry->ins_type == ev.ins_type && strncmp(entry->ins_id, ev.ins_id, MDP_INS_ID_LEN) == 0)
+        m_idx_same++;
+    else
+        m_idx_diff++;
+}
+
+void ins_snapshot_t::on_instrument_init(const mdp_init_event_t &ev)
+{
+    if (!live_matches())
+        return;
+
+    // 只比较本次出现的字段
+    const snap_entry_t *entry = find(ev.ins_idx);
+    const mdp_fields_t &fld = ev.fld;
+    bool same = entry != NULL && entry->has_init && entry->price_size == ev.price_size
+            && (!fld.has(INIT_FLD_LAST_CLOSE) || fld.value[INIT_FLD_LAST_CLOSE] == entry->last_close)
+            && (!fld.has(INIT_FLD_LAST_CLEAR) || fld.value[INIT_FLD_LAST_CLEAR] == entry->last_clear)
+            && (!fld.has(INIT_FLD_LAST_HOLDING) || fld.value[INIT_FLD_LAST_HOLDING] == entry->last_holding)
+            && (!fld.has(INIT_FLD_LIMIT_UP) || fld.value[INIT_FLD_LIMIT_UP] == entry->limit_up)
+            && (!fld.has(INIT_FLD_LIMIT_DOWN) || fld.value[INIT_FLD_LIMIT_DOWN] == entry->limit_down);
+    if (same)
+        m_init_same++;
+    else
+        m_init_diff++;
+}
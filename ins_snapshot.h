@@ -0,0 +1,221 @@
+#ifndef INS_SNAPSHOT_H_
+#define INS_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "ins_table.h"
+
+#define SNAP_MAGIC      "CZCESNP1"  ///< 文件标识
+#define SNAP_VERSION    1
+#define SNAP_SUFFIX     ".snap"     ///< 文件名为<名称>_<交易日>.snap
+#define SNAP_DAY_CLOSE_HOUR 16      ///< 本地时间过该小时后重启视为夜盘，交易日至少为次日
+
+/**
+ * @brief 快照文件头
+ */
+struct snap_file_header_t
+{
+    char magic[8];          ///< SNAP_MAGIC
+    uint32 version;         ///< 文件格式版本
+    uint32 header_len;      ///< 文件头长度，第一个合约从此偏移开始
+    uint32 trade_date;      ///< 交易日
+    uint32 count;           ///< 合约个数
+    uint32 entry_size;      ///< 每个合约的字节数
+    uint32 reserved;
+    uint64_t create_ns;     ///< 保存时间(ns)
+};
+
+/**
+ * @brief 快照中的合约，按ins_idx升序存放
+ */
+struct snap_entry_t
+{
+    uint16 ins_idx;               ///< 合约索引
+    uint8 ins_type;               ///< 合约类型
+    uint8 has_init;               ///< 是否有初始行情
+    uint16 price_size;            ///< 价格精度
+    uint16 init_mask;             ///< 收到过的初始行情字段位图，旧版本文件为0，视为全部字段
+    char ins_id[MDP_INS_ID_LEN];  ///< 合约编码
+    int last_close;               ///< 昨收盘价
+    int last_clear;               ///< 昨结算价
+    int last_holding;             ///< 昨持仓
+    int limit_up;                 ///< 涨停价
+    int limit_down;               ///< 跌停价
+};
+
+/**
+ * @brief 合约索引和初始行情快照（热启动）
+ *
+ * 盘中重启后，在交易所重新广播合约索引(0x05)和初始行情(0x06)之前无法把
+ * ins_idx映射到合约。运行中由save()把合约表的索引和初始行情保存为按交易日
+ * 命名的紧凑二进制文件；启动时用open_latest()映射交易日不早于当前时段的
+ * 快照，在接收线程启动前由replay()按广播顺序生成索引和初始行情事件送入
+ * 处理器组合，合约表、编码查找表、共享内存等与收到广播时的状态一致。
+ *
+ * 本对象同时作为解码器处理器，收到实时广播后与快照逐个核对：交易日相同时
+ * 广播直接覆盖快照中的值，只统计一致和不一致的消息数；交易日不同时各处理器
+ * 按交易日切换自行清空，快照不再参与核对。
+ */
+class ins_snapshot_t : public mdp_null_handler_t
+{
+public:
+    ins_snapshot_t();
+    ~ins_snapshot_t();
+
+    /**
+     * @brief 保存合约表的快照，先写临时文件再改名，读者不会看到写了一半的文件
+     *
+     * 可在任意线程调用，合约静态信息按顺序锁读取。
+     *
+     * @param table 合约表
+     * @param dir 快照目录
+     * @param name 快照名称，如"czce_l1"
+     *
+     * @return 0：成功；-1：失败或尚未收到合约索引
+     */
+    static int save(const ins_table_t &table, const char *dir, const char *name);
+
+    /**
+     * @brief 按本地时间推算当前时段最早可能的交易日
+     *
+     * 日盘收盘后重启时处于夜盘，其交易日为下一个交易日，昨日日盘的快照已过期。
+     */
+    static uint32 min_trade_date(time_t now);
+
+    /**
+     * @brief 映射目录中交易日最新的快照
+     *
+     * @param min_date 快照交易日早于该值时视为过期，不加载
+     *
+     * @return 0：成功；-1：没有可用的快照
+     */
+    int open_latest(const char *dir, const char *name, uint32 min_date);
+
+    /**
+     * @brief 映射快照文件并校验
+     *
+     * @return 0：成功；-1：失败
+     */
+    int open(const char *path);
+
+    /**
+     * @brief 解除映射，解码线程运行期间不能调用
+     */
+    void close();
+
+    bool is_open() const { return m_header != NULL; }
+
+    /**
+     * @brief 快照交易日，未打开时为0
+     */
+    uint32 get_trade_date() const { return m_header != NULL ? m_header->trade_date : 0; }
+
+    /**
+     * @brief 快照中的合约个数
+     */
+    int get_count() const { return m_header != NULL ? m_header->count : 0; }
+
+    /**
+     * @brief 将快照按广播顺序送入处理器：先全部合约索引，再全部初始行情
+     *
+     * 必须在接收线程启动前、在解码线程将使用的处理器组合上调用。
+     * 初始行情只带原消息中出现过的字段。
+     */
+    template <typename handler_t>
+    void replay(handler_t &handler);
+
+    /**
+     * @brief 只回放合约索引，用于解码器中处理器组合之外的订阅对象等
+     */
+    template <typename handler_t>
+    void replay_index(handler_t &handler);
+
+    /**
+     * @brief 打印核对结果
+     */
+    void print_stats(const char *name) const;
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+    void on_instrument_init(const mdp_init_event_t &ev);
+
+private:
+    /**
+     * @brief 按ins_idx二分查找快照中的合约
+     */
+    const snap_entry_t *find(uint16 ins_idx) const;
+
+    /**
+     * @brief 实时广播是否与快照属于同一交易日
+     */
+    bool live_matches() const { return m_header != NULL && !m_replaying && m_live_date == m_header->trade_date; }
+
+private:
+    char *m_map;                        ///< 文件映射
+    size_t m_map_len;                   ///< 映射长度
+    const snap_file_header_t *m_header; ///< 文件头
+    const snap_entry_t *m_entries;      ///< 合约数组
+    bool m_replaying;                   ///< 正在回放，回放产生的事件不参与核对
+    uint32 m_live_date;                 ///< 实时广播的交易日，未收到时为0
+
+    uint64_t m_idx_same;                ///< 与快照一致的合约索引消息数
+    uint64_t m_idx_diff;                ///< 与快照不一致或快照中没有的合约索引消息数
+    uint64_t m_init_same;               ///< 与快照一致的初始行情消息数
+    uint64_t m_init_diff;               ///< 与快照不一致的初始行情消息数
+};
+
+template <typename handler_t>
+void ins_snapshot_t::replay_index(handler_t &handler)
+{
+    if (m_header == NULL)
+        return;
+
+    mdp_idx_event_t idx_ev;
+    memset(&idx_ev, 0, sizeof(idx_ev));
+    for (uint32 i = 0; i < m_header->count; i++)
+    {
+        const snap_entry_t &entry = m_entries[i];
+        idx_ev.msg_idx = i;
+        idx_ev.trade_date = m_header->trade_date;
+        idx_ev.ins_type = entry.ins_type;
+        idx_ev.ins_idx = entry.ins_idx;
+        memcpy(idx_ev.ins_id, entry.ins_id, sizeof(idx_ev.ins_id));
+        handler.on_instrument_idx(idx_ev);
+    }
+}
+
+template <typename handler_t>
+void ins_snapshot_t::replay(handler_t &handler)
+{
+    if (m_header == NULL)
+        return;
+
+    m_replaying = true;
+    replay_index(handler);
+
+    mdp_init_event_t init_ev;
+    memset(&init_ev, 0, sizeof(init_ev));
+    for (uint32 i = 0; i < m_header->count; i++)
+    {
+        const snap_entry_t &entry = m_entries[i];
+        if (!entry.has_init)
+            continue;
+
+        init_ev.fld.mask = entry.init_mask != 0 ? entry.init_mask : INIT_FLD_ALL_MASK;
+        init_ev.price_size = entry.price_size;
+        init_ev.ins_idx = entry.ins_idx;
+        init_ev.fld.value[INIT_FLD_LAST_CLOSE] = entry.last_close;
+        init_ev.fld.value[INIT_FLD_LAST_CLEAR] = entry.last_clear;
+        init_ev.fld.value[INIT_FLD_LAST_HOLDING] = entry.last_holding;
+        init_ev.fld.value[INIT_FLD_LIMIT_UP] = entry.limit_up;
+        init_ev.fld.value[INIT_FLD_LIMIT_DOWN] = entry.limit_down;
+        handler.on_instrument_init(init_ev);
+    }
+
+    m_replaying = false;
+}
+
+#endif
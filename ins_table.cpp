@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "ins_table.h"
+
+ins_table_t::ins_table_t()
+{
+    m_records = NULL;
+    m_own_mem = false;
+    m_trade_date.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+}
+
+ins_table_t::~ins_table_t()
+{
+    if (m_records != NULL && m_own_mem)
+        munmap(m_records, mem_size());
+}
+
+int ins_table_t::init()
+{
+    if (m_records != NULL)
+    {
+        printf("instrument table has been initialized!\n");
+        return -1;
+    }
+
+    // 匿名映射内存初始为0，MAP_POPULATE预先建立页表，避免行情到来时缺页
+    void *mem = mmap(NULL, mem_size(), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap instrument table");
+        return -1;
+    }
+
+    m_records = (ins_record_t *)mem;
+    m_own_mem = true;
+    return 0;
+}
+
+int ins_table_t::init(void *mem)
+{
+    if (m_records != NULL || mem == NULL)
+    {
+        printf("instrument table has been initialized or memory is null!\n");
+        return -1;
+    }
+
+    m_records = (ins_record_t *)mem;
+    m_own_mem = false;
+    return 0;
+}
+
+void ins_table_t::clear()
+{
+    // 表可能在共享内存中被其他进程读取，逐条经顺序锁清空，不能整体memset把序号归零
+    for (int i = 0; i < INS_TABLE_SIZE; i++)
+    {
+        m_records[i].info.reset();
+        m_records[i].l1.reset();
+    }
+    m_trade_date.store(0, std::memory_order_release);
+    m_count.store(0, std::memory_order_release);
+}
+
+void ins_table_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    // 交易日切换后合约索引重新编排，旧记录全部作废
+    uint32 trade_date = m_trade_date.load(std::memory_order_relaxed);
+    if (ev.msg_idx == 0 && ev.trade_date != trade_date)
+    {
+        if (trade_date != 0)
+            clear();
+        m_trade_date.store(ev.trade_date, std::memory_order_release);
+    }
+
+    seqlock_t<ins_info_t> &lock = m_records[ev.ins_idx].info;
+    if (!lock.data().has_idx)
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    ins_info_t &info = lock.begin_write();
+    memcpy(info.ins_id, ev.ins_id, sizeof(info.ins_id));
+    info.ins_type = ev.ins_type;
+    info.has_idx = 1;
+    lock.end_write();
+}
+
+void ins_table_t::on_instrument_init(const mdp_init_event_t &ev)
+{
+    seqlock_t<ins_info_t> &lock = m_records[ev.ins_idx].info;
+    ins_info_t &info = lock.begin_write();
+    const mdp_fields_t &fld = ev.fld;
+
+    info.price_size = ev.price_size;
+    if (fld.has(INIT_FLD_LAST_CLOSE))
+        info.last_close = fld.value[INIT_FLD_LAST_CLOSE];
+    if (fld.has(INIT_FLD_LAST_CLEAR))
+        info.last_clear = fld.value[INIT_FLD_LAST_CLEAR];
+    if (fld.has(INIT_FLD_LAST_HOLDING))
+        info.last_holding = fld.value[INIT_FLD_LAST_HOLDING];
+    if (fld.has(INIT_FLD_LIMIT_UP))
+        info.limit_up = fld.value[INIT_FLD_LIMIT_UP];
+    if (fld.has(INIT_FLD_LIMIT_DOWN))
+        info.limit_down = fld.value[INIT_FLD_LIMIT_DOWN];
+    info.init_mask |= fld.mask & INIT_FLD_ALL_MASK;
+    info.has_init = 1;
+    lock.end_write();
+}
@@ -0,0 +1,209 @@
+#ifndef INS_TABLE_H_
+#define INS_TABLE_H_
+
+#include <stddef.h>
+#include <atomic>
+
+#include "mdp_handler.h"
+#include "seqlock.h"
+
+#define INS_TABLE_SIZE  65536   ///< ins_idx为uint16，按最大索引直接寻址
+#define CACHE_LINE_SIZE 64      ///< CPU缓存行大小
+
+/**
+ * @brief 合约静态信息，来自合约索引(0x05)及初始行情(0x06)
+ */
+struct ins_info_t
+{
+    char ins_id[MDP_INS_ID_LEN];  ///< 合约编码
+    uint8 ins_type;               ///< 合约类型
+    uint8 has_idx;                ///< 是否已收到合约索引
+    uint8 has_init;               ///< 是否已收到初始行情
+    uint8 init_mask;              ///< 已收到过的初始行情字段位图（INIT_FLD_*）
+    uint16 price_size;            ///< 价格精度（初始行情中的值）
+    int last_close;               ///< 昨收盘价
+    int last_clear;               ///< 昨结算价
+    int last_holding;             ///< 昨持仓
+    int limit_up;                 ///< 涨停价
+    int limit_down;               ///< 跌停价
+
+    price_t limit_up_price() const { return price_t(limit_up, price_size); }
+    price_t limit_down_price() const { return price_t(limit_down, price_size); }
+
+    /**
+     * @brief 价格是否在涨跌停范围内，按整数精确比较，未收到初始行情时总是true
+     */
+    bool within_limits(const price_t &price) const
+    {
+        return has_init == 0 || (price >= limit_down_price() && price <= limit_up_price());
+    }
+};
+
+/**
+ * @brief 合约最新一档行情，按字段索引保存单腿(TICK_FLD_*)或组合(CMB_FLD_*)行情
+ */
+struct ins_l1_t
+{
+    uint16 price_size;          ///< 价格精度
+    uint32 update_cnt;          ///< 已处理的行情消息数
+    uint32 mask;                ///< 已收到过的字段位图
+    int value[MDP_FIELD_NUM];   ///< 各字段最新值
+    long long trade_val;        ///< 总成交金额（未除价格精度）
+
+    price_t price(int fld_idx) const { return price_t(value[fld_idx], price_size); }
+    price_t turnover() const { return price_t(trade_val, price_size); }
+};
+
+/**
+ * @brief 合约记录，按缓存行对齐，避免相邻合约互相干扰
+ *
+ * 静态信息和最新行情分别由顺序锁保护，其他线程可无锁读取一致的快照。
+ */
+struct alignas(CACHE_LINE_SIZE) ins_record_t
+{
+    seqlock_t<ins_info_t> info;  ///< 静态信息
+    seqlock_t<ins_l1_t> l1;      ///< 最新行情
+};
+
+/**
+ * @brief 合约状态表
+ *
+ * 以ins_idx为下标的定长数组，作为解码器处理器使用：合约索引和初始行情
+ * 填充静态信息，单腿/组合行情原地更新最新字段，更新过程无查找、无内存分配。
+ * 表只应由一个解码线程写入；read_info()/read_l1()可在任意线程调用，
+ * 写线程从不等待读者。
+ */
+class ins_table_t : public mdp_null_handler_t
+{
+public:
+    ins_table_t();
+    ~ins_table_t();
+
+    /**
+     * @brief 分配并预先映射表内存
+     *
+     * @return 0：成功；-1：失败
+     */
+    int init();
+
+    /**
+     * @brief 使用外部内存（如共享内存）作为表存储，内存由调用方释放
+     *
+     * @param mem 至少mem_size()字节、按缓存行对齐且初始为0的内存
+     *
+     * @return 0：成功；-1：失败
+     */
+    int init(void *mem);
+
+    /**
+     * @brief 表存储所需的内存大小
+     */
+    static size_t mem_size() { return sizeof(ins_record_t) * INS_TABLE_SIZE; }
+
+    /**
+     * @brief 清空所有合约记录，逐条经顺序锁写入，其他线程或进程可同时读取
+     */
+    void clear();
+
+    /**
+     * @brief 获取合约记录，不加保护地访问数据只限写线程自身
+     *
+     * @param ins_idx 合约索引
+     *
+     * @return 合约记录，未收到索引的合约info.has_idx为0
+     */
+    const ins_record_t &get(uint16 ins_idx) const { return m_records[ins_idx]; }
+
+    /**
+     * @brief 读取合约静态信息的一致快照，可在任意线程调用
+     *
+     * @param ins_idx 合约索引
+     * @param info 输出的静态信息
+     *
+     * @return true：已收到该合约索引；false：合约不存在
+     */
+    bool read_info(uint16 ins_idx, ins_info_t &info) const
+    {
+        m_records[ins_idx].info.read(info);
+        return info.has_idx != 0;
+    }
+
+    /**
+     * @brief 读取合约最新行情的一致快照，可在任意线程调用
+     *
+     * @param ins_idx 合约索引
+     * @param l1 输出的最新行情
+     *
+     * @return true：已收到过行情；false：尚无行情
+     */
+    bool read_l1(uint16 ins_idx, ins_l1_t &l1) const
+    {
+        m_records[ins_idx].l1.read(l1);
+        return l1.update_cnt != 0;
+    }
+
+    /**
+     * @brief 获取当前交易日，未收到合约索引时为0，可在其他线程调用
+     */
+    uint32 get_trade_date() const { return m_trade_date.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 获取已收到索引的合约个数，可在其他线程调用
+     */
+    int get_count() const { return m_count.load(std::memory_order_acquire); }
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+    void on_instrument_init(const mdp_init_event_t &ev);
+
+    void on_instrument(const mdp_tick_event_t &ev)
+    {
+        seqlock_t<ins_l1_t> &lock = m_records[ev.ins_idx].l1;
+        ins_l1_t &l1 = lock.begin_write();
+        update_l1(l1, ev.price_size, ev.fld);
+
+        // 成交金额分两部分下发，任一部分更新后用最新的两部分重新合成
+        if (ev.fld.mask & ((1u << TICK_FLD_TRADE_VAL1) | (1u << TICK_FLD_TRADE_VAL2)))
+        {
+            long long part1 = l1.value[TICK_FLD_TRADE_VAL1];
+            long long part2 = l1.value[TICK_FLD_TRADE_VAL2];
+            l1.trade_val = (part1 << 26) | part2;
+        }
+        lock.end_write();
+    }
+
+    void on_cmbtype(const mdp_cmb_event_t &ev)
+    {
+        seqlock_t<ins_l1_t> &lock = m_records[ev.ins_idx].l1;
+        update_l1(lock.begin_write(), ev.price_size, ev.fld);
+        lock.end_write();
+    }
+
+private:
+    /**
+     * @brief 将消息中出现的字段写入最新行情
+     */
+    static void update_l1(ins_l1_t &l1, uint16 price_size, const mdp_fields_t &fld)
+    {
+        uint32 mask = fld.mask;
+        while (mask != 0)
+        {
+            int fld_idx = __builtin_ctz(mask);
+            l1.value[fld_idx] = fld.value[fld_idx];
+            mask &= mask - 1;
+        }
+
+        l1.mask |= fld.mask;
+        l1.price_size = price_size;
+        l1.update_cnt++;
+    }
+
+private:
+    ins_record_t *m_records;  ///< 合约记录数组，共INS_TABLE_SIZE项
+    bool m_own_mem;           ///< 表内存是否由本对象分配
+    std::atomic<uint32> m_trade_date;  ///< 当前交易日，只由写线程修改
+    std::atomic<int> m_count;          ///< 已收到索引的合约个数，只由写线程修改
+};
+
+#endif
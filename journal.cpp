@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "journal.h"
+#include "tsc_clock.h"
+
+jnl_queue_t::jnl_queue_t(uint16 channel_id, uint32 queue_size)
+{
+    m_channel_id = channel_id;
+    m_size = queue_size;
+    m_tail = 0;
+    m_head_cache = 0;
+    m_dropped = 0;
+    m_head = 0;
+
+    // 预先映射，避免接收线程首次写入槽位时缺页
+    void *mem = mmap(NULL, sizeof(slot_t) * m_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    m_slots = mem == MAP_FAILED ? NULL : (slot_t *)mem;
+}
+
+jnl_queue_t::~jnl_queue_t()
+{
+    if (m_slots != NULL)
+        munmap(m_slots, sizeof(slot_t) * m_size);
+}
+
+jnl_writer_t::jnl_writer_t()
+{
+    m_file_size = JNL_DEFAULT_FILE_SIZE;
+    m_session_id = 0;
+    m_file_seq = 0;
+
+    m_fd = -1;
+    m_map = NULL;
+    m_pos = 0;
+
+    m_started = false;
+    m_stop = false;
+    m_roll_req = false;
+    m_roll_date = 0;
+    m_failed = false;
+    m_written = 0;
+}
+
+jnl_writer_t::~jnl_writer_t()
+{
+    stop();
+
+    for (size_t i = 0; i < m_queues.size(); i++)
+        delete m_queues[i];
+}
+
+jnl_queue_t *jnl_writer_t::add_channel(uint16 channel_id, uint32 queue_size)
+{
+    if (m_started)
+    {
+        printf("add journal channel failed: writer started!\n");
+        return NULL;
+    }
+
+    if (queue_size == 0 || (queue_size & (queue_size - 1)) != 0)
+    {
+        printf("journal queue size must be power of 2: %u\n", queue_size);
+        return NULL;
+    }
+
+    jnl_queue_t *queue = new jnl_queue_t(channel_id, queue_size);
+    if (queue->m_slots == NULL)
+    {
+        perror("mmap journal queue");
+        delete queue;
+        return NULL;
+    }
+
+    m_queues.push_back(queue);
+    return queue;
+}
+
+int jnl_writer_t::start(const char *dir, const char *prefix, uint64_t file_size)
+{
+    if (m_started)
+    {
+        printf("journal writer has been started!\n");
+        return -1;
+    }
+
+    if (file_size < sizeof(jnl_file_header_t) + sizeof(jnl_record_head_t) * 2 + JNL_MAX_DATA_LEN)
+    {
+        printf("journal file size too small: %lu\n", (unsigned long)file_size);
+        return -1;
+    }
+
+    m_dir = dir;
+    m_prefix = prefix;
+    m_file_size = file_size;
+    m_session_id = realtime_ns();
+    m_file_seq = 0;
+
+    if (open_file() != 0)
+    {
+        return -2;
+    }
+
+    m_stop = false;
+    int res = pthread_create(&m_thread, NULL, thread_main, this);
+    if (res != 0)
+    {
+        printf("create journal thread failed: %s\n", strerror(res));
+        close_file();
+        return -3;
+    }
+
+    m_started = true;
+    return 0;
+}
+
+void jnl_writer_t::stop()
+{
+    if (!m_started)
+        return;
+
+    m_stop.store(true, std::memory_order_release);
+    pthread_join(m_thread, NULL);
+    m_started = false;
+
+    close_file();
+
+    for (size_t i = 0; i < m_queues.size(); i++)
+    {
+        printf("journal channel %u: dropped = %lu\n", m_queues[i]->get_channel_id(),
+                (unsigned long)m_queues[i]->get_dropped());
+    }
+    printf("journal records written: %lu%s\n", (unsigned long)get_written(),
+            is_failed() ? ", stopped after roll failure" : "");
+}
+
+void *jnl_writer_t::thread_main(void *arg)
+{
+    ((jnl_writer_t *)arg)->run();
+    return NULL;
+}
+
+void jnl_writer_t::run()
+{
+    while (true)
+    {
+        if (m_roll_req.exchange(false, std::memory_order_acq_rel) && roll_file() != 0)
+            return;
+
+        int count = drain();
+        if (count < 0)
+            return;
+        if (count > 0)
+            continue;
+
+        // 队列已空，停止请求之前的报文都已写入
+        if (m_stop.load(std::memory_order_acquire))
+        {
+            drain();
+            return;
+        }
+
+        usleep(100);
+    }
+}
+
+int jnl_writer_t::drain()
+{
+    int count = 0;
+
+    for (size_t i = 0; i < m_queues.size(); i++)
+    {
+        jnl_queue_t *queue = m_queues[i];
+
+        // 每个队列每轮最多取一批，避免某个通道独占写盘线程
+        for (int n = 0; n < 256; n++)
+        {
+            const jnl_queue_t::slot_t *slot = queue->front();
+            if (slot == NULL)
+                break;
+
+            uint64_t rec_len = (sizeof(jnl_record_head_t) + slot->head.len + JNL_ALIGN - 1) & ~(uint64_t)(JNL_ALIGN - 1);
+
+            // 预留一个记录头作为结束标记
+            if (m_pos + rec_len + sizeof(jnl_record_head_t) > m_file_size && roll_file() != 0)
+            {
+                m_written.store(m_written.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+                return -1;
+            }
+
+            memcpy(m_map + m_pos, slot, sizeof(jnl_record_head_t) + slot->head.len);
+            m_pos += rec_len;
+
+            queue->pop();
+            count++;
+        }
+    }
+
+    if (count > 0)
+        m_written.store(m_written.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+
+    return count;
+}
+
+int jnl_writer_t::roll_file()
+{
+    close_file();
+    if (open_file() == 0)
+        return 0;
+
+    // 不再消费队列，接收线程写满队列后按丢弃计数
+    m_failed.store(true, std::memory_order_release);
+    printf("journal roll failed, recording stopped!\n");
+    return -1;
+}
+
+int jnl_writer_t::open_file()
+{
+    char time_str[32];
+    time_t now = time(NULL);
+    struct tm tm_now;
+    localtime_r(&now, &tm_now);
+    strftime(time_str, sizeof(time_str), "%Y%m%d_%H%M%S", &tm_now);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s_%s_%03u.jnl", m_dir.c_str(), m_prefix.c_str(), time_str, m_file_seq);
+
+    m_fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (m_fd < 0)
+    {
+        perror("create journal file");
+        return -1;
+    }
+
+    // 预分配磁盘空间，写入过程中不再扩展文件
+    int res = posix_fallocate(m_fd, 0, m_file_size);
+    if (res != 0)
+    {
+        printf("allocate journal file failed: %s\n", strerror(res));
+        close(m_fd);
+        m_fd = -1;
+        return -1;
+    }
+
+    void *mem = mmap(NULL, m_file_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap journal file");
+        close(m_fd);
+        m_fd = -1;
+        return -1;
+    }
+
+    m_map = (char *)mem;
+    madvise(m_map, m_file_size, MADV_SEQUENTIAL);
+
+    jnl_file_header_t *header = (jnl_file_header_t *)m_map;
+    memcpy(header->magic, JNL_MAGIC, sizeof(header->magic));
+    header->version = JNL_VERSION;
+    header->header_len = sizeof(jnl_file_header_t);
+    header->create_ns = realtime_ns();
+    header->session_id = m_session_id;
+    header->file_seq = m_file_seq;
+    header->data_len = 0;
+
+    m_pos = sizeof(jnl_file_header_t);
+    m_file_seq++;
+
+    printf("Journal file opened: %s\n", path);
+    return 0;
+}
+
+void jnl_writer_t::close_file()
+{
+    if (m_map == NULL)
+        return;
+
+    // 结束标记：预分配区域本身为0，这里只需保证截断后仍保留一个空记录头
+    uint64_t file_len = m_pos + sizeof(jnl_record_head_t);
+    memset(m_map + m_pos, 0, sizeof(jnl_record_head_t));
+    ((jnl_file_header_t *)m_map)->data_len = m_pos;
+
+    msync(m_map, file_len, MS_SYNC);
+    munmap(m_map, m_file_size);
+    m_map = NULL;
+
+    if (ftruncate(m_fd, file_len) != 0)
+        perror("truncate journal file");
+    close(m_fd);
+    m_fd = -1;
+}
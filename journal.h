@@ -0,0 +1,318 @@
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "mdp_protocol.h"
+#include "mdp_handler.h"
+
+#define JNL_MAGIC               "CZCEJNL1"  ///< 文件标识
+#define JNL_VERSION             1
+#define JNL_MAX_DATA_LEN        4096        ///< 单条记录最大数据长度，与接收缓冲区一致
+#define JNL_DEFAULT_FILE_SIZE   (1ULL << 30)  ///< 默认单个文件预分配1GB
+#define JNL_DEFAULT_QUEUE_SIZE  4096        ///< 默认每通道队列槽位数，必须为2的幂
+#define JNL_ALIGN               8           ///< 记录按8字节对齐
+
+/**
+ * @brief 日志文件头
+ */
+struct jnl_file_header_t
+{
+    char magic[8];          ///< JNL_MAGIC
+    uint32 version;         ///< 文件格式版本
+    uint32 header_len;      ///< 文件头长度，首条记录从此偏移开始
+    uint64_t create_ns;     ///< 文件创建时间(ns)
+    uint64_t session_id;    ///< 录制会话标识，同一次录制滚动出的文件相同
+    uint32 file_seq;        ///< 会话内文件序号
+    uint32 reserved;
+    uint64_t data_len;      ///< 有效数据长度（含文件头），关闭文件时写入
+    char reserved2[16];
+};
+
+/**
+ * @brief 日志记录头，其后紧跟len字节数据，整条记录按JNL_ALIGN对齐
+ *
+ * 文件预分配部分全为0，recv_ns为0的记录头表示数据结束。
+ */
+struct jnl_record_head_t
+{
+    uint64_t recv_ns;       ///< 接收时间(ns)
+    uint16 channel_id;      ///< 通道号
+    uint16 len;             ///< 数据长度
+    uint32 reserved;
+};
+
+/**
+ * @brief 单通道录制队列（单生产者单消费者）
+ *
+ * 接收线程调用push()把报文复制到队列，写盘线程从队列取出，接收线程不接触磁盘。
+ * 队列满时丢弃报文并计数，不阻塞接收。
+ */
+class jnl_queue_t
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param channel_id 通道号
+     * @param queue_size 槽位数，必须为2的幂
+     */
+    jnl_queue_t(uint16 channel_id, uint32 queue_size);
+    ~jnl_queue_t();
+
+    /**
+     * @brief 写入一个报文，仅限该通道的接收线程调用
+     *
+     * @param recv_ns 接收时间(ns)
+     * @param buf 报文数据
+     * @param len 报文长度，超出JNL_MAX_DATA_LEN的部分截断
+     *
+     * @return true：成功；false：队列已满，报文被丢弃
+     */
+    bool push(uint64_t recv_ns, const char *buf, int len)
+    {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache >= m_size)
+        {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache >= m_size)
+            {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        slot_t &slot = m_slots[tail & (m_size - 1)];
+        if (len > JNL_MAX_DATA_LEN)
+            len = JNL_MAX_DATA_LEN;
+        slot.head.recv_ns = recv_ns;
+        slot.head.channel_id = m_channel_id;
+        slot.head.len = len;
+        slot.head.reserved = 0;
+        memcpy(slot.data, buf, len);
+
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint16 get_channel_id() const { return m_channel_id; }
+
+    /**
+     * @brief 因队列满被丢弃的报文数
+     */
+    uint64_t get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    friend class jnl_writer_t;
+
+    /**
+     * @brief 队列槽位
+     */
+    struct slot_t
+    {
+        jnl_record_head_t head;
+        char data[JNL_MAX_DATA_LEN];
+    };
+
+    /**
+     * @brief 取出队首记录，仅限写盘线程调用
+     *
+     * @return 队首记录，队列为空时返回NULL
+     */
+    const slot_t *front()
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return NULL;
+        return &m_slots[head & (m_size - 1)];
+    }
+
+    /**
+     * @brief 释放队首记录
+     */
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    uint16 m_channel_id;                ///< 通道号
+    uint32 m_size;                      ///< 槽位数
+    slot_t *m_slots;                    ///< 槽位数组
+
+    // 对象经new分配，C++11下无法保证alignas生效，用填充隔开两个线程各自写的变量
+    char m_pad0[64];
+    std::atomic<uint64_t> m_tail;       ///< 写入位置（接收线程）
+    uint64_t m_head_cache;              ///< 接收线程缓存的读取位置
+    std::atomic<uint64_t> m_dropped;    ///< 丢弃计数
+
+    char m_pad1[64];
+    std::atomic<uint64_t> m_head;       ///< 读取位置（写盘线程）
+    char m_pad2[64];
+};
+
+/**
+ * @brief 报文录制器
+ *
+ * 独立写盘线程从各通道队列取出报文，追加到预分配并映射到内存的日志文件中。
+ * 文件写满、调用roll()或交易日切换（经jnl_roll_handler_t通知）时滚动到新文件，文件名为<dir>/<prefix>_<日期>_<时间>_<序号>.jnl。
+ */
+class jnl_writer_t
+{
+public:
+    jnl_writer_t();
+
+    /**
+     * @brief 析构函数，未停止的写盘线程会被停止
+     */
+    ~jnl_writer_t();
+
+    /**
+     * @brief 添加录制通道，需在start()之前调用
+     *
+     * @param channel_id 通道号，写入每条记录
+     * @param queue_size 队列槽位数，必须为2的幂
+     *
+     * @return 通道队列，交给mc_client_t::set_recorder()；失败返回NULL
+     */
+    jnl_queue_t *add_channel(uint16 channel_id, uint32 queue_size = JNL_DEFAULT_QUEUE_SIZE);
+
+    /**
+     * @brief 打开第一个日志文件并启动写盘线程
+     *
+     * @param dir 日志目录
+     * @param prefix 文件名前缀
+     * @param file_size 单个文件预分配大小，写满后滚动
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int start(const char *dir, const char *prefix, uint64_t file_size = JNL_DEFAULT_FILE_SIZE);
+
+    /**
+     * @brief 请求滚动到新文件，如交易时段切换时调用
+     */
+    void roll() { m_roll_req.store(true, std::memory_order_release); }
+
+    /**
+     * @brief 通知当前交易日，交易日变大时请求滚动，可由多个接收线程调用，同一交易日只滚动一次
+     *
+     * @param trade_date 合约索引中的交易日
+     */
+    void on_trade_date(uint32 trade_date)
+    {
+        uint32 prev = m_roll_date.load(std::memory_order_relaxed);
+        while (trade_date > prev)
+        {
+            if (m_roll_date.compare_exchange_weak(prev, trade_date, std::memory_order_relaxed))
+            {
+                // 首次收到的交易日属于刚打开的文件
+                if (prev != 0)
+                    roll();
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief 写完队列中剩余报文后停止写盘线程并关闭文件
+     */
+    void stop();
+
+    /**
+     * @brief 已写入的记录数
+     */
+    uint64_t get_written() const { return m_written.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 滚动失败后写盘线程已退出，之后的报文在队列满后丢弃
+     */
+    bool is_failed() const { return m_failed.load(std::memory_order_acquire); }
+
+private:
+    /**
+     * @brief 写盘线程入口
+     */
+    static void *thread_main(void *arg);
+
+    /**
+     * @brief 写盘循环
+     */
+    void run();
+
+    /**
+     * @brief 取出各队列中的记录写入文件
+     *
+     * @return 本次写入的记录数；-1：滚动失败，录制已停止
+     */
+    int drain();
+
+    /**
+     * @brief 关闭当前文件并创建新文件，失败时置失败标志
+     *
+     * @return 0：成功；-1：失败
+     */
+    int roll_file();
+
+    /**
+     * @brief 创建并映射新文件
+     *
+     * @return 0：成功；-1：失败
+     */
+    int open_file();
+
+    /**
+     * @brief 写入有效长度，截掉未使用的预分配部分并关闭当前文件
+     */
+    void close_file();
+
+private:
+    std::vector<jnl_queue_t *> m_queues;    ///< 通道队列
+    std::string m_dir;                      ///< 日志目录
+    std::string m_prefix;                   ///< 文件名前缀
+    uint64_t m_file_size;                   ///< 单个文件大小
+    uint64_t m_session_id;                  ///< 会话标识
+    uint32 m_file_seq;                      ///< 当前文件序号
+
+    int m_fd;                               ///< 当前文件描述符
+    char *m_map;                            ///< 当前文件映射
+    uint64_t m_pos;                         ///< 当前写入偏移
+
+    pthread_t m_thread;                     ///< 写盘线程
+    bool m_started;                         ///< 写盘线程是否已启动
+    std::atomic<bool> m_stop;               ///< 停止标志
+    std::atomic<bool> m_roll_req;           ///< 滚动请求
+    std::atomic<uint32> m_roll_date;        ///< 最近通知的交易日
+    std::atomic<bool> m_failed;             ///< 滚动失败，录制已停止
+    std::atomic<uint64_t> m_written;        ///< 已写入记录数
+};
+
+/**
+ * @brief 交易日切换处理器，接入处理器组合后在交易日切换时让录制器滚动文件
+ *
+ * 未设置录制器时不做任何事，两个通道的处理器组合可共用一个对象。
+ */
+class jnl_roll_handler_t : public mdp_null_handler_t
+{
+public:
+    jnl_roll_handler_t() : m_writer(NULL) {}
+
+    /**
+     * @brief 设置录制器，需在接收线程启动前调用
+     */
+    void set_writer(jnl_writer_t *writer) { m_writer = writer; }
+
+    void on_instrument_idx(const mdp_idx_event_t &ev)
+    {
+        if (ev.msg_idx == 0 && m_writer != NULL)
+            m_writer->on_trade_date(ev.trade_date);
+    }
+
+private:
+    jnl_writer_t *m_writer;  ///< 录制器
+};
+
+#endif
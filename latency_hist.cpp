@@ -0,0 +1,92 @@
+#include <stdio.h>
+
+#include "latency_hist.h"
+
+latency_hist_t::latency_hist_t()
+{
+    m_sum.store(0);
+    m_max.store(0);
+    for (int i = 0; i < LAT_BUCKET_NUM; i++)
+        m_bucket[i].store(0);
+}
+
+uint64_t latency_hist_t::bucket_high(int idx)
+{
+    if (idx < LAT_SUB_COUNT)
+        return idx;
+
+    int exp = idx / LAT_SUB_COUNT - 1;
+    uint64_t sub = idx % LAT_SUB_COUNT;
+    return ((LAT_SUB_COUNT + sub + 1) << exp) - 1;
+}
+
+uint64_t latency_hist_t::get_count() const
+{
+    uint64_t count = 0;
+    for (int i = 0; i < LAT_BUCKET_NUM; i++)
+        count += m_bucket[i].load(std::memory_order_relaxed);
+    return count;
+}
+
+uint64_t latency_hist_t::percentile(double pct) const
+{
+    // 先取快照，保证总数与各桶计数一致
+    uint64_t snap[LAT_BUCKET_NUM];
+    uint64_t count = 0;
+    for (int i = 0; i < LAT_BUCKET_NUM; i++)
+    {
+        snap[i] = m_bucket[i].load(std::memory_order_relaxed);
+        count += snap[i];
+    }
+    if (count == 0)
+        return 0;
+
+    uint64_t target = (uint64_t)(count * pct / 100.0);
+    if (target >= count)
+        target = count - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_BUCKET_NUM; i++)
+    {
+        seen += snap[i];
+        if (seen > target)
+        {
+            uint64_t high = bucket_high(i);
+            uint64_t max = get_max();
+            return high < max ? high : max;
+        }
+    }
+    return get_max();
+}
+
+void latency_hist_t::print(const char *name) const
+{
+    uint64_t count = get_count();
+    if (count == 0)
+        return;
+
+    printf("  %-10s n=%-10llu avg=%-8llu p50=%-8llu p99=%-8llu p99.9=%-8llu max=%llu (ns)\n", name,
+            (unsigned long long)count,
+            (unsigned long long)(get_sum() / count),
+            (unsigned long long)percentile(50),
+            (unsigned long long)percentile(99),
+            (unsigned long long)percentile(99.9),
+            (unsigned long long)get_max());
+}
+
+latency_stats_t::latency_stats_t()
+{
+    m_ns_per_tsc = 1.0 / tsc_per_ns();
+}
+
+void latency_stats_t::print(const char *name) const
+{
+    static const char *stage_names[LAT_STAGE_NUM] = {"wire", "queue", "decode", "total"};
+    static const char *type_names[LAT_TYPE_NUM] = {"0x05", "0x06", "0x10", "0x11", "0x12", "0x13", "0x14", "0x20", "other"};
+
+    printf("latency %s:\n", name);
+    for (int i = 0; i < LAT_STAGE_NUM; i++)
+        m_stage[i].print(stage_names[i]);
+    for (int i = 0; i < LAT_TYPE_NUM; i++)
+        m_type[i].print(type_names[i]);
+}
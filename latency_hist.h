@@ -0,0 +1,166 @@
+#ifndef LATENCY_HIST_H_
+#define LATENCY_HIST_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "mdp_event.h"
+#include "tsc_clock.h"
+
+#define LAT_SUB_BITS    5                                   ///< 每个2的幂区间细分的位数，相对误差约1/32
+#define LAT_SUB_COUNT   (1 << LAT_SUB_BITS)                 ///< 每个区间的子桶数
+#define LAT_MAX_EXP     36                                  ///< 最大区间指数，可记录到约2^41ns
+#define LAT_BUCKET_NUM  ((LAT_MAX_EXP + 1) * LAT_SUB_COUNT) ///< 桶个数
+
+///< 分阶段延迟
+#define LAT_STAGE_WIRE      0   ///< 内核接收 -> 用户态取出
+#define LAT_STAGE_QUEUE     1   ///< 用户态取出 -> 开始解码
+#define LAT_STAGE_DECODE    2   ///< 开始解码 -> 最后一个消息处理完成
+#define LAT_STAGE_TOTAL     3   ///< 内核接收 -> 最后一个消息处理完成
+#define LAT_STAGE_NUM       4
+
+#define LAT_TYPE_NUM        9   ///< 8种已知报文类型+其他
+
+/**
+ * @brief HDR风格的对数-线性延迟直方图(ns)
+ *
+ * 单线程写入，任意线程可随时读取分位数；计数用relaxed原子读写，不加锁。
+ */
+class latency_hist_t
+{
+public:
+    latency_hist_t();
+
+    /**
+     * @brief 记录一个样本，只能由一个线程调用
+     */
+    void record(uint64_t ns)
+    {
+        int idx = bucket_of(ns);
+        m_bucket[idx].store(m_bucket[idx].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_sum.store(m_sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > m_max.load(std::memory_order_relaxed))
+            m_max.store(ns, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 样本个数
+     */
+    uint64_t get_count() const;
+
+    /**
+     * @brief 分位数，返回所在桶的上界
+     *
+     * @param pct 百分位，如99.9
+     */
+    uint64_t percentile(double pct) const;
+
+    uint64_t get_max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t get_sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 打印样本数、均值、p50/p99/p99.9和最大值
+     */
+    void print(const char *name) const;
+
+private:
+    static int bucket_of(uint64_t v)
+    {
+        if (v < LAT_SUB_COUNT)
+            return (int)v;
+
+        int exp = 63 - __builtin_clzll(v) - LAT_SUB_BITS;
+        if (exp > LAT_MAX_EXP - 1)
+            return LAT_BUCKET_NUM - 1;
+        return (exp + 1) * LAT_SUB_COUNT + (int)((v >> exp) - LAT_SUB_COUNT);
+    }
+
+    static uint64_t bucket_high(int idx);
+
+private:
+    std::atomic<uint64_t> m_sum;                    ///< 样本总和
+    std::atomic<uint64_t> m_max;                    ///< 最大值
+    std::atomic<uint64_t> m_bucket[LAT_BUCKET_NUM]; ///< 各桶计数
+};
+
+/**
+ * @brief 单个通道的延迟统计：分阶段直方图和按报文类型的端到端直方图
+ *
+ * 由该通道的接收线程写入，转储可在其他线程进行。
+ * 没有内核时间戳时（如回放），端到端延迟从用户态取出报文开始计。
+ */
+class latency_stats_t
+{
+public:
+    latency_stats_t();
+
+    /**
+     * @brief 记录一个UDP包的分阶段延迟
+     *
+     * @param info 接收信息
+     * @param decode_tsc 开始解码时的rdtsc
+     * @param done_tsc 最后一个消息处理完成时的rdtsc
+     */
+    void record_datagram(const mdp_recv_info_t &info, uint64_t decode_tsc, uint64_t done_tsc)
+    {
+        uint64_t wire_ns = get_wire_ns(info);
+        if (info.kernel_ns != 0)
+            m_stage[LAT_STAGE_WIRE].record(wire_ns);
+        m_stage[LAT_STAGE_QUEUE].record(tsc_to_ns(decode_tsc - info.dequeue_tsc));
+        m_stage[LAT_STAGE_DECODE].record(tsc_to_ns(done_tsc - decode_tsc));
+        m_stage[LAT_STAGE_TOTAL].record(wire_ns + tsc_to_ns(done_tsc - info.dequeue_tsc));
+    }
+
+    /**
+     * @brief 记录一个消息从接收到处理完成的延迟
+     *
+     * @param msg_type 报文类型
+     * @param info 接收信息
+     * @param done_tsc 消息处理完成时的rdtsc
+     */
+    void record_msg(uint8 msg_type, const mdp_recv_info_t &info, uint64_t done_tsc)
+    {
+        m_type[type_slot(msg_type)].record(get_wire_ns(info) + tsc_to_ns(done_tsc - info.dequeue_tsc));
+    }
+
+    const latency_hist_t &get_stage(int stage) const { return m_stage[stage]; }
+    const latency_hist_t &get_type(uint8 msg_type) const { return m_type[type_slot(msg_type)]; }
+
+    /**
+     * @brief 打印全部直方图，空直方图不输出
+     *
+     * @param name 通道名称
+     */
+    void print(const char *name) const;
+
+private:
+    static int type_slot(uint8 msg_type)
+    {
+        switch (msg_type)
+        {
+        case PACKAGE_INSTRUMENT_IDX:  return 0;
+        case PACKAGE_INSTRUMENT_INIT: return 1;
+        case PACKAGE_INSTRUMENT:      return 2;
+        case PACKAGE_CMBTYPE:         return 3;
+        case PACKAGE_BULLETINE:       return 4;
+        case PACKAGE_QUOT_REQ:        return 5;
+        case PACKAGE_TRADE_STATUS:    return 6;
+        case PACKAGE_DEPTH:           return 7;
+        default:                      return 8;
+        }
+    }
+
+    static uint64_t get_wire_ns(const mdp_recv_info_t &info)
+    {
+        return info.kernel_ns != 0 && info.dequeue_ns > info.kernel_ns ? info.dequeue_ns - info.kernel_ns : 0;
+    }
+
+    uint64_t tsc_to_ns(uint64_t tsc) const { return (uint64_t)(tsc * m_ns_per_tsc); }
+
+private:
+    double m_ns_per_tsc;                    ///< 每个rdtsc计数对应的纳秒数
+    latency_hist_t m_stage[LAT_STAGE_NUM];  ///< 分阶段直方图
+    latency_hist_t m_type[LAT_TYPE_NUM];    ///< 按报文类型的端到端直方图
+};
+
+#endif
@@ -1,9 +1,98 @@
 #include "mc_client.h"
+#include "mc_runner.h"
+#include "mdp_decoder.h"
+#include "print_handler.h"
+#include "ins_table.h"
+#include "order_book.h"
+#include "shm_bus.h"
+#include "journal.h"
+#include "tick_store.h"
+#include "latency_hist.h"
+#include "feed_stats.h"
+#include "symbol_index.h"
+#include "ins_snapshot.h"
+#include "quote_merge.h"
 #include <string>
+#include <signal.h>
 
 char localbindip1[] = "1.1.1.223";      //本地接收行情网卡设备的ip
 char localbindip2[] = "1.1.1.224";      //本地接收行情网卡设备的ip
 
+const int recv_buf_len = 2048;          //socket接收缓冲区大小(Kb)
+const int recv_batch = 32;              //单次recvmmsg最多接收的报文数，1表示逐个recvfrom
+
+const int recv_cpu1 = -1;               //一档行情接收线程绑定的CPU核心，-1表示不绑定
+const int recv_cpu2 = -1;               //五档行情接收线程绑定的CPU核心，-1表示不绑定
+const int recv_rt_priority = 0;         //接收线程SCHED_FIFO优先级，0表示普通调度
+
+const bool busy_poll1 = false;          //一档行情是否忙轮询接收，开启后独占一个CPU核心，建议同时绑定CPU
+const bool busy_poll2 = false;          //五档行情是否忙轮询接收
+const int busy_poll_us = 50;            //内核SO_BUSY_POLL时间(us)，0表示只在用户态轮询
+const int idle_backoff_ms = 1000;       //忙轮询连续空闲超过该时间后退避到epoll等待，0表示始终轮询
+
+const bool packet_ring = false;         //是否从AF_PACKET内存映射接收环（TPACKET_V3）接收，需CAP_NET_RAW
+const uint32 ring_block_size = 1 << 20; //接收环块大小
+const uint32 ring_block_num = 64;       //接收环块个数
+const uint32 ring_retire_ms = 1;        //接收环块超时(ms)
+
+const bool uring_engine = false;        //是否由一个io_uring线程接收所有通道（绑定recv_cpu1），否则每通道一个线程
+
+const bool print_market_data = true;    //是否打印解码后的行情，关闭后只解码不输出
+
+const char subscribe_list[] = "";       //订阅的合约，逗号分隔，如"SR,CF505,#2"（品种、合约、合约类型），为空时处理所有合约
+
+const bool shm_publish = false;         //是否将行情发布到共享内存，供其他进程通过shm_reader_t读取
+const char shm_name1[] = "/czce_md_l1"; //一档行情共享内存名称
+const char shm_name2[] = "/czce_md_l5"; //五档行情共享内存名称
+
+const bool record_journal = false;      //是否录制原始报文
+const char journal_dir[] = ".";         //录制文件目录
+const uint64_t journal_file_size = JNL_DEFAULT_FILE_SIZE;  //单个录制文件大小，写满后滚动
+const uint16 channel_id1 = 1;           //一档行情通道号，写入录制记录
+const uint16 channel_id2 = 5;           //五档行情通道号，写入录制记录
+
+const bool store_ticks = false;         //是否将解码后的一档、五档行情按合约写入列存文件，供研究时直接映射读取
+const char tick_store_dir[] = "./ticks";  //列存根目录，其下按交易日/通道/合约分文件
+
+const bool warm_start = false;          //是否保存合约索引和初始行情快照，并在盘中重启时加载当日快照，不必等待交易所重新广播
+const char snapshot_dir[] = ".";        //快照目录，文件名按通道和交易日区分
+const char snapshot_name1[] = "czce_l1";  //一档行情快照名称
+const char snapshot_name2[] = "czce_l5";  //五档行情快照名称
+
+const bool merge_quotes = false;        //是否按合约合并一档成交和五档盘口，其他线程可用merger.read()读取合并行情
+
+const bool stats_publish = false;       //是否将通道健康计数发布到共享内存，供mdp_stats等旁路进程读取
+const char stats_shm_name[] = "/czce_md_stats";  //健康计数共享内存名称
+
+const bool measure_latency = false;     //是否统计接收到处理完成的延迟，运行中发送SIGUSR1打印
+
+typedef mdp_handler_pair_t<ins_table_t, book_table_t> table_chain_t;
+typedef mdp_handler_pair_t<table_chain_t, ins_snapshot_t> snap_chain_t;
+typedef mdp_handler_pair_t<snap_chain_t, symbol_map_t> state_chain_t;
+typedef mdp_handler_pair_t<state_chain_t, tick_feed_t> store_chain_t;
+typedef mdp_handler_pair_t<store_chain_t, quote_merge_input_t> merge_chain_t;
+typedef mdp_handler_pair_t<merge_chain_t, jnl_roll_handler_t> roll_chain_t;
+typedef mdp_handler_pair_t<roll_chain_t, shm_publisher_t> feed_chain_t;
+typedef mdp_handler_pair_t<feed_chain_t, print_handler_t> print_chain_t;
+typedef mdp_decoder_t<print_chain_t> print_decoder_t;
+typedef mdp_decoder_t<feed_chain_t> feed_decoder_t;
+
+/**
+ * @brief 合约个数连续两次检查不变时视为本轮索引广播结束，每个交易日保存一次快照
+ */
+static void save_snapshot(const ins_table_t &table, const char *name, uint32 &saved_date, int &last_count)
+{
+    int count = table.get_count();
+    uint32 trade_date = table.get_trade_date();
+    if (trade_date != 0 && trade_date != saved_date && count > 0 && count == last_count
+            && ins_snapshot_t::save(table, snapshot_dir, name) == 0)
+    {
+        saved_date = trade_date;
+        printf("snapshot %s saved: trade date = %u, instruments = %d\n", name, trade_date, count);
+    }
+    last_count = count;
+}
+
 int main()
 {
 
@@ -26,20 +115,273 @@ int main()
 
     mc_client_t client1(mc_ip1, mc_port1);
     mc_client_t client2(mc_ip2, mc_port2);
+    client1.set_busy_poll(busy_poll1, busy_poll_us, idle_backoff_ms);
+    client2.set_busy_poll(busy_poll2, busy_poll_us, idle_backoff_ms);
+    client1.set_packet_ring(packet_ring, ring_block_size, ring_block_num, ring_retire_ms);
+    client2.set_packet_ring(packet_ring, ring_block_size, ring_block_num, ring_retire_ms);
 
-    if (client1.init(localbindip1) == -1)  //允许从所有网卡接收数据
+    if (client1.init(localbindip1, recv_buf_len, recv_batch) < 0)  //允许从所有网卡接收数据
     {
         return -1;
     }
 
-    if (client2.init(localbindip2) == -1)  //允许从所有网卡接收数据
+    if (client2.init(localbindip2, recv_buf_len, recv_batch) < 0)  //允许从所有网卡接收数据
     {
         return -2;
     }
 
+    // 每个通道独立的合约表、盘口表和解码器，分别在各自的接收线程中运行；
+    // 发布到共享内存时两张表直接建在共享内存上
+    ins_table_t table1, table2;
+    book_table_t books1, books2;
+    shm_publisher_t publisher1, publisher2;
+    if (shm_publish)
+    {
+        if (publisher1.init(shm_name1) != 0 || publisher2.init(shm_name2) != 0
+                || table1.init(publisher1.get_table_mem()) != 0 || table2.init(publisher2.get_table_mem()) != 0
+                || books1.init(publisher1.get_book_mem()) != 0 || books2.init(publisher2.get_book_mem()) != 0)
+        {
+            return -3;
+        }
+    }
+    else if (table1.init() != 0 || table2.init() != 0 || books1.init() != 0 || books2.init() != 0)
+    {
+        return -3;
+    }
+
+    // 合约编码查找表在合约索引广播结束后构建，其他线程可用symbols1/2.find()按编码取ins_idx
+    symbol_map_t symbols1, symbols2;
+    ins_snapshot_t snapshot1, snapshot2;
+    table_chain_t tables1(table1, books1), tables2(table2, books2);
+    snap_chain_t snap_chain1(tables1, snapshot1), snap_chain2(tables2, snapshot2);
+    state_chain_t state1(snap_chain1, symbols1), state2(snap_chain2, symbols2);
+
+    // 列存输入在此接入处理器组合，写盘线程在屏蔽信号后启动；不写列存时接入空队列
+    tick_store_t store;
+    tick_feed_t idle_feed1("l1", 0), idle_feed2("l5", 0);
+    tick_feed_t *tick_feed1 = &idle_feed1, *tick_feed2 = &idle_feed2;
+    if (store_ticks)
+    {
+        tick_feed1 = store.add_feed("l1");
+        tick_feed2 = store.add_feed("l5");
+        if (tick_feed1 == NULL || tick_feed2 == NULL)
+        {
+            return -9;
+        }
+    }
+
+    // 两个接收线程写同一张合并行情表，未初始化时输入直接返回
+    quote_merger_t merger;
+    if (merge_quotes && merger.init() != 0)
+    {
+        return -10;
+    }
+
+    store_chain_t store_chain1(state1, *tick_feed1), store_chain2(state2, *tick_feed2);
+    merge_chain_t merge_chain1(store_chain1, merger.input(0)), merge_chain2(store_chain2, merger.input(1));
+    // 录制器在屏蔽信号后启动，交易日切换处理器先接入，录制时再设置录制器
+    jnl_roll_handler_t roller;
+    roll_chain_t roll_chain1(merge_chain1, roller), roll_chain2(merge_chain2, roller);
+    feed_chain_t feed1(roll_chain1, publisher1), feed2(roll_chain2, publisher2);
+    print_handler_t printer1, printer2;
+    print_chain_t print_chain1(feed1, printer1), print_chain2(feed2, printer2);
+    print_decoder_t print_decoder1(print_chain1), print_decoder2(print_chain2);
+    feed_decoder_t feed_decoder1(feed1), feed_decoder2(feed2);
+
+    // 每个通道的订阅位图由该通道的解码线程按合约索引解析
+    subscription_t sub1, sub2;
+    if (subscribe_list[0] != '\0')
+    {
+        if (sub1.parse(subscribe_list) < 0 || sub2.parse(subscribe_list) < 0)
+        {
+            return -8;
+        }
+        print_decoder1.set_subscription(&sub1);
+        print_decoder2.set_subscription(&sub2);
+        feed_decoder1.set_subscription(&sub1);
+        feed_decoder2.set_subscription(&sub2);
+    }
+
+    // 接收线程启动前把当前时段的快照回放到各处理器，实时广播到达后由快照对象核对；
+    // 订阅位图由解码器在处理器组合之外维护，合约索引另行回放给订阅对象
+    uint32 saved_date1 = 0, saved_date2 = 0;
+    if (warm_start)
+    {
+        uint32 min_date = ins_snapshot_t::min_trade_date(time(NULL));
+        if (snapshot1.open_latest(snapshot_dir, snapshot_name1, min_date) == 0)
+        {
+            snapshot1.replay(feed1);
+            if (!sub1.empty())
+                snapshot1.replay_index(sub1);
+            saved_date1 = snapshot1.get_trade_date();
+            printf("warm start level 1: trade date = %u, instruments = %d\n", saved_date1, snapshot1.get_count());
+        }
+        if (snapshot2.open_latest(snapshot_dir, snapshot_name2, min_date) == 0)
+        {
+            snapshot2.replay(feed2);
+            if (!sub2.empty())
+                snapshot2.replay_index(sub2);
+            saved_date2 = snapshot2.get_trade_date();
+            printf("warm start level 5: trade date = %u, instruments = %d\n", saved_date2, snapshot2.get_count());
+        }
+    }
+
+    client1.set_channel_id(channel_id1);
+    client2.set_channel_id(channel_id2);
+
+    // 收包计数由接收客户端写入，消息计数和格式错误由解码器写入同一对象
+    feed_stats_table_t stats;
+    if (stats.init(stats_publish ? stats_shm_name : NULL, 2) != 0)
+    {
+        return -6;
+    }
+    client1.set_stats(stats.get(0));
+    client2.set_stats(stats.get(1));
+    print_decoder1.set_stats(stats.get(0));
+    print_decoder2.set_stats(stats.get(1));
+    feed_decoder1.set_stats(stats.get(0));
+    feed_decoder2.set_stats(stats.get(1));
+
+    // 直方图由接收线程写入，主线程收到SIGUSR1时读取
+    latency_stats_t *latency1 = NULL, *latency2 = NULL;
+    if (measure_latency)
+    {
+        latency1 = new latency_stats_t();
+        latency2 = new latency_stats_t();
+        print_decoder1.set_latency(latency1);
+        print_decoder2.set_latency(latency2);
+        feed_decoder1.set_latency(latency1);
+        feed_decoder2.set_latency(latency2);
+    }
+
+    if (print_market_data)
+    {
+        client1.set_data_cb(&print_decoder_t::data_cb, &print_decoder1);
+        client2.set_data_cb(&print_decoder_t::data_cb, &print_decoder2);
+    }
+    else
+    {
+        client1.set_data_cb(&feed_decoder_t::data_cb, &feed_decoder1);
+        client2.set_data_cb(&feed_decoder_t::data_cb, &feed_decoder2);
+    }
+
+    // 屏蔽退出信号，由主线程统一等待，接收线程和写盘线程继承该屏蔽字
+    sigset_t sig_set;
+    sigemptyset(&sig_set);
+    sigaddset(&sig_set, SIGINT);
+    sigaddset(&sig_set, SIGTERM);
+    sigaddset(&sig_set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &sig_set, NULL);
+
+    // 列存写盘线程在接收线程之前启动，最后停止
+    if (store_ticks && store.start(tick_store_dir) != 0)
+    {
+        return -9;
+    }
+
+    // 录制写盘线程在接收线程之前启动，最后停止
+    jnl_writer_t recorder;
+    if (record_journal)
+    {
+        jnl_queue_t *queue1 = recorder.add_channel(channel_id1);
+        jnl_queue_t *queue2 = recorder.add_channel(channel_id2);
+        if (queue1 == NULL || queue2 == NULL || recorder.start(journal_dir, "czce", journal_file_size) != 0)
+        {
+            return -5;
+        }
+        client1.set_recorder(queue1);
+        client2.set_recorder(queue2);
+        roller.set_writer(&recorder);
+    }
+
+    mc_runner_t runner;
+    uring_engine_t engine;
+    if (uring_engine)
+    {
+        if (engine.add_channel(&client1) != 0 || engine.add_channel(&client2) != 0 || engine.init() != 0)
+        {
+            return -7;
+        }
+        runner.add_engine(&engine, recv_cpu1, recv_rt_priority);
+    }
+    else
+    {
+        runner.add_channel(&client1, recv_cpu1, recv_rt_priority);
+        runner.add_channel(&client2, recv_cpu2, recv_rt_priority);
+    }
+
     printf("Receiving market data...\n");
-    client1.loop();
-    client2.loop();
+    if (runner.start() != 0)
+    {
+        return -4;
+    }
+
+    // 每秒检查一次是否需要保存快照
+    int sig = 0;
+    int last_count1 = -1, last_count2 = -1;
+    const struct timespec poll_interval = {1, 0};
+    while (true)
+    {
+        sig = sigtimedwait(&sig_set, NULL, &poll_interval);
+        if (sig < 0)
+        {
+            if (warm_start)
+            {
+                save_snapshot(table1, snapshot_name1, saved_date1, last_count1);
+                save_snapshot(table2, snapshot_name2, saved_date2, last_count2);
+            }
+            continue;
+        }
+        if (sig != SIGUSR1)
+            break;
+
+        if (latency1 != NULL)
+        {
+            latency1->print(client1.get_name().c_str());
+            latency2->print(client2.get_name().c_str());
+        }
+    }
+    printf("Signal %d received, stopping...\n", sig);
+
+    runner.stop();
+    runner.join();
+
+    // 退出前再保存一次，包含运行中收到的全部索引和初始行情
+    if (warm_start)
+    {
+        ins_snapshot_t::save(table1, snapshot_dir, snapshot_name1);
+        ins_snapshot_t::save(table2, snapshot_dir, snapshot_name2);
+        snapshot1.print_stats(snapshot_name1);
+        snapshot2.print_stats(snapshot_name2);
+    }
+    recorder.stop();
+    store.stop();
+
+    if (uring_engine)
+    {
+        engine.print_stats();
+    }
+    else
+    {
+        client1.print_batch_stats();
+        client2.print_batch_stats();
+    }
+    feed_stats_table_t::print(stats.at(0));
+    feed_stats_table_t::print(stats.at(1));
+    printf("instruments: level 1 = %d, level 5 = %d\n", table1.get_count(), table2.get_count());
+    printf("symbols: level 1 = %d, level 5 = %d\n", symbols1.get_count(), symbols2.get_count());
+    if (merge_quotes)
+        printf("quotes: level 1 = %lu, level 5 = %lu, suppressed: level 1 = %lu, level 5 = %lu\n",
+                (unsigned long)merger.get_emitted(0), (unsigned long)merger.get_emitted(1),
+                (unsigned long)merger.get_suppressed(0), (unsigned long)merger.get_suppressed(1));
+
+    if (latency1 != NULL)
+    {
+        latency1->print(client1.get_name().c_str());
+        latency2->print(client2.get_name().c_str());
+        delete latency1;
+        delete latency2;
+    }
 
     return 0;
 }
@@ -4,8 +4,24 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
 
 #include "mc_client.h"
+#include "journal.h"
+#include "feed_stats.h"
+#include "pkt_ring.h"
+#include "tsc_clock.h"
+#include "seqlock.h"
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
 
 mc_client_t::mc_client_t(std::string mc_ip, unsigned int mc_port)
 {
@@ -13,15 +29,54 @@ mc_client_t::mc_client_t(std::string mc_ip, unsigned int mc_port)
     m_mc_port = mc_port;
 
     m_mc_fd = -1;
+    m_stop = false;
+
+    m_data_cb = NULL;
+    m_data_ctx = NULL;
+    m_recorder = NULL;
+    m_stats = NULL;
+    m_channel_id = 0;
+    m_ts_enabled = false;
+
+    m_use_ring = false;
+    m_ring_block_size = 0;
+    m_ring_block_num = 0;
+    m_ring_retire_ms = 0;
+    m_ring = NULL;
+
+    m_busy_poll = false;
+    m_busy_poll_us = 0;
+    m_idle_backoff_ms = 0;
+    m_epoll_fd = -1;
+    m_idle_backoff_tsc = 0;
+    m_idle_start_tsc = 0;
+    m_idle_waits = 0;
+
+    m_recv_batch = 1;
+    m_batch_buf = NULL;
+    m_batch_msgs = NULL;
+    m_batch_iovs = NULL;
+    m_batch_ctrl = NULL;
+
+    m_recv_calls = 0;
+    m_recv_dgrams = 0;
+    memset(m_batch_hist, 0, sizeof(m_batch_hist));
 }
 
 mc_client_t::~mc_client_t()
 {
     if (m_mc_fd > 0)
         close(m_mc_fd);
+
+    if (m_epoll_fd >= 0)
+        close(m_epoll_fd);
+
+    delete m_ring;
+
+    free_batch_ring();
 }
 
-int mc_client_t::init(const char *bind_if, const int recv_buf_len)
+int mc_client_t::init(const char *bind_if, const int recv_buf_len, const int recv_batch)
 {
     if (-1 != m_mc_fd)
     {
@@ -29,6 +84,19 @@ int mc_client_t::init(const char *bind_if, const int recv_buf_len)
         return -1;
     }
 
+    if (recv_batch < 1 || recv_batch > MC_MAX_RECV_BATCH)
+    {
+        printf("invalid recv batch size: %d (1 ~ %d)\n", recv_batch, MC_MAX_RECV_BATCH);
+        return -1;
+    }
+
+    m_recv_batch = recv_batch;
+    if (m_recv_batch > 1 && alloc_batch_ring() != 0)
+    {
+        printf("alloc recv batch ring failed!\n");
+        return -1;
+    }
+
     m_mc_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
     if (m_mc_fd < 0)
     {
@@ -48,6 +116,7 @@ int mc_client_t::init(const char *bind_if, const int recv_buf_len)
     {
         perror("bind ip"); 
         close(m_mc_fd);
+        m_mc_fd = -1;
         return -2;
     }
     printf("Bind successful. Return value: %d\n", bind_res);
@@ -61,6 +130,7 @@ int mc_client_t::init(const char *bind_if, const int recv_buf_len)
         {
             perror("set socket buffer");
             close(m_mc_fd);
+            m_mc_fd = -1;
             return -3;
         }
         printf("Socket buffer set successfully. Return value: %d\n", set_res);
@@ -75,6 +145,7 @@ int mc_client_t::init(const char *bind_if, const int recv_buf_len)
     {
         perror("join multicast group");
         close(m_mc_fd);
+        m_mc_fd = -1;
         return -4;
     }
     printf("Joined multicast group successfully. Return value: %d\n", setopt_res);
@@ -86,465 +157,558 @@ int mc_client_t::init(const char *bind_if, const int recv_buf_len)
     {
         printf("set socket timeout failed!\n");
         close(m_mc_fd);
+        m_mc_fd = -1;
         return -5;  // Return an error code specific to this failure.
     }
 
-    printf("Binding to interface IP: %s\n", bind_if);
+    enable_timestamp();
 
-    return m_mc_fd;
-}
+    // 内核在控制消息中附带该socket因接收队列满累计丢弃的包数
+    int rxq_ovfl = 1;
+    if (setsockopt(m_mc_fd, SOL_SOCKET, SO_RXQ_OVFL, &rxq_ovfl, sizeof(rxq_ovfl)) != 0)
+        perror("enable SO_RXQ_OVFL");
 
-void mc_client_t::loop()
-{
-    int recv_len = 0;
-    int buf_size = sizeof(m_recv_buf);
-    printf("buf_size = %d\n", buf_size);
-    struct sockaddr_in sender_addr;
-    socklen_t addr_len = sizeof(sender_addr);
+    if (m_use_ring && init_packet_ring(bind_if) != 0)
+    {
+        close(m_mc_fd);
+        m_mc_fd = -1;
+        return -7;
+    }
 
-    while(true)
+    if (m_busy_poll && init_busy_poll() != 0)
     {
-        memset(&sender_addr, 0, sizeof(sender_addr)); // Clear the sender address structure
-        
-        recv_len = ::recvfrom(m_mc_fd, &m_recv_buf, buf_size, 0, (struct sockaddr*)&sender_addr, &addr_len);
-        if (recv_len < 0)
-        {
-            int err = errno; // Capture the error number
-            if (err == EWOULDBLOCK || err == EAGAIN) 
-            {
-                printf("recvfrom() timed out.\n");
-                continue;  // Try again.
-            }
-            printf("recv data from multicast group failed! Error no: %d, Message: %s\n", err, strerror(err));
-            continue;
-        }
-        else if(recv_len == 0)
+        // 接收环和epoll随socket一起释放，失败后可重新init()
+        delete m_ring;
+        m_ring = NULL;
+        if (m_epoll_fd >= 0)
         {
-            printf("Received empty packet or the sender performed an orderly shutdown.\n");
-            continue;
+            close(m_epoll_fd);
+            m_epoll_fd = -1;
         }
+        close(m_mc_fd);
+        m_mc_fd = -1;
+        return -6;
+    }
 
-        char sender_ip_str[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &(sender_addr.sin_addr), sender_ip_str, INET_ADDRSTRLEN);
-        printf("Received packet from %s:%d of length %d\n", sender_ip_str, ntohs(sender_addr.sin_port), recv_len);
-
-        process_data(m_recv_buf, recv_len);
+    printf("Binding to interface IP: %s\n", bind_if);
+    printf("Receive batch size: %d\n", m_recv_batch);
 
+    return m_mc_fd;
 }
+
+void mc_client_t::set_busy_poll(bool enable, int busy_poll_us, int idle_backoff_ms)
+{
+    m_busy_poll = enable;
+    m_busy_poll_us = busy_poll_us;
+    m_idle_backoff_ms = idle_backoff_ms;
 }
 
-int mc_client_t::process_data(const char* buf, int len)
+int mc_client_t::init_busy_poll()
 {
-    int offset = 0;
-    while(offset < len)  //可能存在一个UDP包中含有多个数据包
+    int flags = fcntl(m_mc_fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(m_mc_fd, F_SETFL, flags | O_NONBLOCK) != 0)
     {
-        pkg_head_t *p_head = (pkg_head_t*)(buf + offset);
-        printf("------------------ 报文类型：0x%02x ------------------\n", p_head->msg_type);
-
-        int len = 0;  // 记录当前已处理的数据长度
-        int pkg_len = read_uint16((char*)&p_head->pkg_len);
-        for (size_t i = 0; i < p_head->msg_num && len < pkg_len; i++)
-        {
-            msg_head_t *p_msg_head = (msg_head_t *)(p_head->pkg_data + len);
-            uint16 msg_len = read_uint16((char*)&p_msg_head->msg_len) - MSG_HEAD_LEN;  //减去消息头长度
+        perror("set socket non-blocking");
+        return -1;
+    }
 
-            char *p_data = p_msg_head->msg_data;
+    // 内核忙轮询需要网卡驱动支持NAPI，设置失败时仍可在用户态轮询
+    if (m_busy_poll_us > 0)
+    {
+        if (setsockopt(m_mc_fd, SOL_SOCKET, SO_BUSY_POLL, &m_busy_poll_us, sizeof(m_busy_poll_us)) != 0)
+            perror("set SO_BUSY_POLL");
 
-            switch (p_head->msg_type)
-            {
-            case PACKAGE_INSTRUMENT_IDX:   //合约索引信息消息
-                on_instrument_idx(p_data, msg_len, i);
-                break;
-            case PACKAGE_INSTRUMENT_INIT:  //初始行情消息
-                on_instrument_init(p_data, msg_len);
-                break;
-            case PACKAGE_INSTRUMENT:       //单腿行情消息
-                on_instrument(p_data, msg_len);
-                break;
-            case PACKAGE_CMBTYPE:          //组合行情消息
-                on_cmbtype(p_data, msg_len);
-                break;
-            case PACKAGE_BULLETINE:        //交易所告示消息
-                on_bulletine(p_data);
-                break;
-            case PACKAGE_QUOT_REQ:         //做市商报价请求消息
-                on_quot_req(p_data);
-                break;
-            case PACKAGE_TRADE_STATUS:     //交易系统状态消息
-                on_trade_status(p_data);
-                break;
-            case PACKAGE_DEPTH:     //交易系统状态消息
-                on_depth(p_data, msg_len);
-                break;
-            default:
-                printf("unknown package type: 0x%02x\n", p_head->msg_type);
-                return -1;
-            }
+        int prefer = 1;
+        if (setsockopt(m_mc_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) != 0)
+            perror("set SO_PREFER_BUSY_POLL");
+    }
 
-            len += msg_len + MSG_HEAD_LEN;  //完成一个msg的解析
-            printf("------------------ message %lu end ------------------\n", i + 1);
-        }
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0)
+    {
+        perror("create epoll");
+        return -1;
+    }
 
-        offset += pkg_len + PKG_HEAD_LEN;  //完成一个pkg的解析
+    // 使用接收环时UDP socket不会收到报文，只在stop()的shutdown时可读，用于唤醒
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_mc_fd, &ev) != 0
+            || (m_ring != NULL && epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_ring->get_fd(), &ev) != 0))
+    {
+        perror("add socket to epoll");
+        return -1;
     }
 
+    m_idle_backoff_tsc = (uint64_t)(m_idle_backoff_ms * 1000000.0 * tsc_per_ns());
+    m_idle_start_tsc = 0;
+
+    printf("Busy poll: kernel %d us, idle back-off %d ms\n", m_busy_poll_us, m_idle_backoff_ms);
     return 0;
 }
 
-void mc_client_t::on_instrument_idx(const char *p_data, uint16 msg_len, int msg_idx)
+void mc_client_t::on_idle()
 {
-    int data_pos = 0;
+    uint64_t now_tsc = rdtsc();
+    if (m_idle_start_tsc == 0)
+        m_idle_start_tsc = now_tsc;
 
-    // 交易日（仅在第一个msg中存在）
-    if (msg_idx == 0)
+    if (m_idle_backoff_tsc == 0 || now_tsc - m_idle_start_tsc < m_idle_backoff_tsc)
     {
-        uint32 trade_date = read_uint32(&p_data[data_pos]);
-        data_pos += 4;
-        printf("trade date = %u\n", trade_date);
+        cpu_relax();
+        return;
     }
 
-    // 合约类型
-    uint8 type = p_data[data_pos];
-    data_pos += 1;
-    printf("Type = %d\n", type);
-
-    // 合约索引
-    uint16 ins_idx = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("Index = %u\n", ins_idx);
-
-    // 合约编码
-    char instrument_id[20] = {0};
-    memcpy(instrument_id, &p_data[data_pos], msg_idx == 0 ? (msg_len - 7) : (msg_len - 3));
-    printf("InstrumentId = %s\n", instrument_id);
+    // 空闲过久，阻塞到socket可读；stop()中的shutdown同样会唤醒epoll
+    m_idle_waits++;
+    struct epoll_event ev;
+    int res = epoll_wait(m_epoll_fd, &ev, 1, MC_IDLE_WAIT_MS);
+    if (res == 0)
+    {
+        if (m_stats != NULL)
+            feed_stats_t::add(m_stats->timeouts);
+        printf("epoll_wait() timed out.\n");
+    }
 }
 
-void mc_client_t::on_instrument_init(const char *p_data, uint16 msg_len)
+void mc_client_t::set_packet_ring(bool enable, uint32 block_size, uint32 block_num, uint32 retire_ms)
 {
-    int data_pos = 0;
-
-    // 价格精度
-    uint16 price_size = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("price_size = %u\n", price_size);
-
-    // 合约索引
-    uint16 ins_idx = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("ins_idx = %u\n", ins_idx);
+    m_use_ring = enable;
+    m_ring_block_size = block_size;
+    m_ring_block_num = block_num;
+    m_ring_retire_ms = retire_ms;
+}
 
-    while (data_pos < msg_len)
+int mc_client_t::init_packet_ring(const char *bind_if)
+{
+    // 由本地绑定IP找到网卡名
+    char if_name[IF_NAMESIZE] = {0};
+    struct ifaddrs *ifs = NULL;
+    if (getifaddrs(&ifs) != 0)
     {
-        int fld_idx = 0;
-        int value = 0;
-        data_pos += get_int_value(&p_data[data_pos], fld_idx, value);
-
-        switch (fld_idx)
+        perror("get interface addresses");
+        return -1;
+    }
+    in_addr_t bind_addr = inet_addr(bind_if);
+    for (struct ifaddrs *ifa = ifs; ifa != NULL; ifa = ifa->ifa_next)
+    {
+        if (ifa->ifa_addr != NULL && ifa->ifa_addr->sa_family == AF_INET
+                && ((struct sockaddr_in *)ifa->ifa_addr)->sin_addr.s_addr == bind_addr)
         {
-        case 1:  // 昨收盘价
-            printf("last close price = %f\n", (double)value / price_size);
-            break;
-        case 2:  // 昨结算价
-            printf("last clear price = %f\n", (double)value / price_size);
-            break;
-        case 3:  // 昨持仓
-            printf("last holding = %d\n", value);
-            break;
-        case 4:  // 涨停价
-            printf("limit up price = %f\n", (double)value / price_size);
-            break;
-        case 5:  // 跌停价
-            printf("limit down price = %f\n", (double)value / price_size);
-            break;
-        default:
-            printf("item: %d, value: %d\n", fld_idx, value);
+            snprintf(if_name, sizeof(if_name), "%s", ifa->ifa_name);
             break;
         }
     }
+    freeifaddrs(ifs);
+
+    if (if_name[0] == '\0')
+    {
+        printf("no interface has address %s\n", bind_if);
+        return -1;
+    }
+
+    m_ring = new pkt_ring_t();
+    if (m_ring->open(if_name, m_mc_ip.c_str(), m_mc_port, m_ring_block_size, m_ring_block_num, m_ring_retire_ms) != 0)
+    {
+        delete m_ring;
+        m_ring = NULL;
+        return -1;
+    }
+
+    // UDP socket只为加入组播组，报文由接收环读取，socket队列中的副本直接丢弃
+    struct sock_filter drop_all = BPF_STMT(BPF_RET | BPF_K, 0);
+    struct sock_fprog prog;
+    prog.len = 1;
+    prog.filter = &drop_all;
+    if (setsockopt(m_mc_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0)
+    {
+        perror("attach drop filter");
+        delete m_ring;
+        m_ring = NULL;
+        return -1;
+    }
+
+    return 0;
 }
 
-void mc_client_t::on_instrument(const char *p_data, uint16 msg_len)
+void mc_client_t::loop()
 {
-    int data_pos = 0;
-    long long trade_val_part1 = 0;  //long long保证左移26位时不溢出
-    long long trade_val_part2 = 0;
+    if (m_ring != NULL)
+        loop_ring();
+    else if (m_recv_batch > 1)
+        loop_batch();
+    else
+        loop_single();
+}
 
-    // 价格精度
-    uint16 price_size = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("price_size = %u\n", price_size);
+void mc_client_t::stop()
+{
+    m_stop.store(true);
 
-    // 合约索引
-    uint16 ins_idx = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("ins_idx = %u\n", ins_idx);
+    // 对未连接的UDP socket执行shutdown同样会唤醒阻塞的recv，使其返回0
+    if (m_mc_fd >= 0)
+        ::shutdown(m_mc_fd, SHUT_RD);
+}
 
-    while (data_pos < msg_len)
-    {
-        int fld_idx = 0;
-        int value = 0;
-        data_pos += get_int_value(&p_data[data_pos], fld_idx, value);
+void mc_client_t::set_data_cb(mc_data_cb_t cb, void *ctx)
+{
+    m_data_cb = cb;
+    m_data_ctx = ctx;
+}
 
-        switch (fld_idx)
-        {
-        case 1:  // 开盘价
-            printf("open price = %f\n", (double)value / price_size);
-            break;
-        case 2:  // 最高价
-            printf("high price = %f\n", (double)value / price_size);
-            break;
-        case 3:  // 最低价
-            printf("low price = %f\n", (double)value / price_size);
-            break;
-        case 4:  // 最新价
-            printf("last price = %f\n", (double)value / price_size);
-            break;
-        case 9:  // 成交量
-            printf("volume = %d\n", value);
-            break;
-        case 16:  // 秒级时间戳
-            printf("time sec = %06d\n", value);
-            break;
-        case 18:  // 新增：微秒级时间戳
-            printf("time usec = %06d\n", value);
-            break;
-        case 19:  // 新增：总成交金额(part1)
-            trade_val_part1 = value;
-            printf("trade value(part1) = %d\n", value);
-            break;
-        case 20:  // 新增：总成交金额(part2)
-            trade_val_part2 = value;
-            printf("trade value(part2) = %d\n", value);
-            break;
-        case 21:  // 新增：历史最高价
-            printf("life high price = %f\n", (double)value / price_size);
-            break;
-        case 22:  // 新增：历史最低价
-            printf("life low price = %f\n", (double)value / price_size);
-            break;
-        default:
-            printf("item: %d, value: %d\n", fld_idx, value);
-            break;
-        }
-    }
+void mc_client_t::set_recorder(jnl_queue_t *recorder)
+{
+    m_recorder = recorder;
+}
 
-    // 总成交金额
-    if (trade_val_part1 != 0 || trade_val_part2 != 0)
-    {
-        double trade_val_sum = (double)((trade_val_part1 << 26) | trade_val_part2) / price_size;
-        printf("trade value(sum) = %lf\n", trade_val_sum);
-    }
+void mc_client_t::set_stats(feed_stats_t *stats)
+{
+    m_stats = stats;
+    fill_stats_info();
+}
+
+void mc_client_t::set_channel_id(uint16 channel_id)
+{
+    m_channel_id = channel_id;
+    fill_stats_info();
+}
+
+void mc_client_t::fill_stats_info()
+{
+    // 在设置时写入，不依赖loop()，由外部接收引擎驱动的通道同样有名称
+    if (m_stats == NULL)
+        return;
+    snprintf(m_stats->name, sizeof(m_stats->name), "%s", get_name().c_str());
+    m_stats->channel_id = m_channel_id;
 }
 
-void mc_client_t::on_cmbtype(const char *p_data, uint16 msg_len)
+void mc_client_t::enable_timestamp()
 {
-    int data_pos = 0;
+    // 只取软件时间戳：网卡原始硬件时间戳来自网卡时钟(PHC)，未必与系统时钟同步（如运行在TAI），
+    // 与realtime_ns()相减会得到无意义的延迟
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(m_mc_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0)
+    {
+        m_ts_enabled = true;
+        printf("Kernel timestamp: SO_TIMESTAMPING\n");
+        return;
+    }
 
-    // 价格精度
-    uint16 price_size = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("price_size = %u\n", price_size);
+    int on = 1;
+    if (setsockopt(m_mc_fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0)
+    {
+        m_ts_enabled = true;
+        printf("Kernel timestamp: SO_TIMESTAMPNS\n");
+        return;
+    }
 
-    // 合约索引
-    uint16 ins_idx = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("ins_idx = %u\n", ins_idx);
+    perror("enable kernel timestamp");
+}
 
-    while (data_pos < msg_len)
+void mc_client_t::read_cmsg(struct msghdr *msg, mdp_recv_info_t &info)
+{
+    info.kernel_ns = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg))
     {
-        int fld_idx = 0;
-        int value = 0;
-        data_pos += get_int_value(&p_data[data_pos], fld_idx, value);
+        if (cmsg->cmsg_level != SOL_SOCKET)
+            continue;
 
-        switch (fld_idx)
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING)
         {
-        case 1:  // 买价
-            printf("bid price = %f\n", (double)value / price_size);
-            break;
-        case 2:  // 卖价
-            printf("ask price = %f\n", (double)value / price_size);
-            break;
-        case 3:  // 买量
-            printf("bid lot = %d\n", value);
-            break;
-        case 4:  // 卖量
-            printf("ask lot = %d\n", value);
-            break;
-        case 7: //新增：秒级时间戳
-            printf("time sec = %d\n", value);
-            break;
-        case 8: //新增：微秒级时间戳
-            printf("time usec = %d\n", value);
-            break;
-        default:
-            printf("item: %d, value: %d\n", fld_idx, value);
-            break;
+            // ts[0]为软件时间戳(CLOCK_REALTIME)，未请求硬件时间戳
+            struct timespec ts[3];
+            memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+            info.kernel_ns = (uint64_t)ts[0].tv_sec * 1000000000ULL + ts[0].tv_nsec;
+        }
+        else if (cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            struct timespec t;
+            memcpy(&t, CMSG_DATA(cmsg), sizeof(t));
+            info.kernel_ns = (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+        }
+        else if (cmsg->cmsg_type == SO_RXQ_OVFL && m_stats != NULL)
+        {
+            uint32 drops = 0;
+            memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            m_stats->rxq_drops.store(drops, std::memory_order_relaxed);
         }
     }
 }
 
-void mc_client_t::on_bulletine(const char *p_data)
+void mc_client_t::count_packet(int recv_len, const mdp_recv_info_t &info)
 {
-    int data_pos = 0;
-
-    // 广播消息头
-    data_pos += 2;
-
-    // 广播消息序号
-    uint16 msg_seq = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("bulletine seq = %u\n", msg_seq);
+    if (m_stats == NULL)
+        return;
 
-    // 广播内容
-    printf("bulletine context: %s\n", &p_data[data_pos]);
+    feed_stats_t::add(m_stats->packets);
+    feed_stats_t::add(m_stats->bytes, recv_len);
+    m_stats->last_recv_ns.store(info.dequeue_ns, std::memory_order_relaxed);
 }
 
-void mc_client_t::on_quot_req(const char *p_data)
+std::string mc_client_t::get_name() const
 {
-    int data_pos = 0;
+    return m_mc_ip + ":" + std::to_string(m_mc_port);
+}
 
-    // 询价消息头
-    data_pos += 2;
+void mc_client_t::get_batch_stats(unsigned long long &recv_calls, unsigned long long &recv_dgrams) const
+{
+    recv_calls = m_recv_calls;
+    recv_dgrams = m_recv_dgrams;
+}
 
-    // 询价合约索引
-    uint16 ins_idx = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("Index = %u\n", ins_idx);
+void mc_client_t::print_batch_stats() const
+{
+    printf("recv calls = %llu, datagrams = %llu, datagrams/call = %.2f\n",
+            m_recv_calls, m_recv_dgrams,
+            m_recv_calls == 0 ? 0.0 : (double)m_recv_dgrams / m_recv_calls);
 
-    int fld_idx = 0;
-    int value = 0;
+    if (m_busy_poll)
+        printf("  idle back-off waits: %llu\n", m_idle_waits);
 
-    // 当前交易日期
-    data_pos += get_int_value(&p_data[data_pos], fld_idx, value);
-    printf("trade date = %d\n", value);
+    for (int i = 1; i <= m_recv_batch; i++)
+    {
+        if (m_batch_hist[i] != 0)
+            printf("  %2d datagrams/call: %llu\n", i, m_batch_hist[i]);
+    }
+}
 
-    // 询价号
-    data_pos += get_int_value(&p_data[data_pos], fld_idx, value);
-    printf("req no = %d\n", value);
+void mc_client_t::deliver(const char *buf, int len, struct msghdr *msg, mdp_recv_info_t &info)
+{
+    info.channel_id = m_channel_id;
+    read_cmsg(msg, info);
+    count_packet(len, info);
 
-    // 询价方向（0-买；1-卖；2-其他）
-    uint8 direction = p_data[data_pos];
-    printf("direction = %d\n", direction);
-    data_pos += 1;
+    if (m_recorder != NULL)
+        m_recorder->push(info.kernel_ns != 0 ? info.kernel_ns : info.dequeue_ns, buf, len);
 
-    // 询价来源（0-会员；1-交易所）
-    uint8 request_by = p_data[data_pos];
-    printf("request_by = %d\n", request_by);
-    data_pos += 1;
+    if (m_data_cb != NULL)
+        m_data_cb(m_data_ctx, buf, len, &info);
 }
 
-void mc_client_t::on_trade_status(const char *p_data)
+void mc_client_t::loop_single()
 {
-    // 交易状态
-    uint8 trade_status = p_data[0];
-    printf("trade status = %d\n", trade_status);
-}
+    int recv_len = 0;
+    int buf_size = sizeof(m_recv_buf);
+    printf("buf_size = %d\n", buf_size);
 
+    struct iovec iov;
+    iov.iov_base = m_recv_buf;
+    iov.iov_len = buf_size;
 
-void mc_client_t::on_depth(const char* p_data, uint16 msg_len)
-{
-    int data_pos = 0;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    mdp_recv_info_t info;
+    info.channel_id = m_channel_id;
+
+    while(!m_stop.load(std::memory_order_relaxed))
+    {
+        msg.msg_control = m_ctrl_buf;
+        msg.msg_controllen = sizeof(m_ctrl_buf);
+        recv_len = ::recvmsg(m_mc_fd, &msg, 0);
+        if (recv_len < 0)
+        {
+            int err = errno; // Capture the error number
+            if (m_busy_poll && (err == EWOULDBLOCK || err == EAGAIN))
+            {
+                on_idle();
+                continue;
+            }
+            if (err == EWOULDBLOCK || err == EAGAIN) 
+            {
+                if (m_stats != NULL)
+                    feed_stats_t::add(m_stats->timeouts);
+                printf("recvfrom() timed out.\n");
+                continue;  // Try again.
+            }
+            if (m_stats != NULL)
+                feed_stats_t::add(m_stats->recv_errors);
+            printf("recv data from multicast group failed! Error no: %d, Message: %s\n", err, strerror(err));
+            continue;
+        }
+        else if(recv_len == 0)
+        {
+            if (m_stop.load(std::memory_order_relaxed))
+                break;
+            printf("Received empty packet or the sender performed an orderly shutdown.\n");
+            continue;
+        }
+
+        info.dequeue_tsc = rdtsc();
+        info.dequeue_ns = realtime_ns();
+        m_idle_start_tsc = 0;
+
+        m_recv_calls++;
+        m_recv_dgrams++;
+        m_batch_hist[1]++;
 
-    // 价格精度
-    uint16 price_size = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("price_size = %u\n", price_size);
+        deliver(m_recv_buf, recv_len, &msg, info);
+    }
+}
 
-    // 合约索引
-    uint16 ins_idx = read_uint16(&p_data[data_pos]);
-    data_pos += 2;
-    printf("ins_idx = %u\n", ins_idx);
+void mc_client_t::loop_batch()
+{
+    printf("buf_size = %d, batch = %d\n", MC_RECV_BUF_LEN, m_recv_batch);
 
+    mdp_recv_info_t info;
+    info.channel_id = m_channel_id;
 
-    while (data_pos < msg_len)
+    while(!m_stop.load(std::memory_order_relaxed))
     {
-        int fld_idx = 0;
-        int price = 0;
-        int qty = 0;
-        int ord_cnt = 0;
-        data_pos += get_dep_orderbook(&p_data[data_pos], fld_idx, price, qty, ord_cnt);
-
-        switch (fld_idx)
+        // MSG_WAITFORONE：阻塞等待第一个报文，之后把已到达的报文一次取完
+        int recv_num = ::recvmmsg(m_mc_fd, m_batch_msgs, m_recv_batch, MSG_WAITFORONE, NULL);
+        if (recv_num < 0)
         {
-        case 1:  
-            printf("BidDepth1 = %f BidSize1 = %d \n", (double)price / price_size, qty);
-            break;
-        case 2:  
-            printf("AskDepth1 = %f %d\n", (double)price / price_size, qty);
-            break;
-        case 3:
-            printf("BidDepth2 = %f %d\n", (double)price / price_size, qty);
-            break;
-        case 4:
-            printf("AskDepth2 = %f %d \n", (double)price / price_size, qty);
-            break;
-        case 5:
-            printf("BidDepth3 = %f\n", (double)price / price_size);
-            break;
-        case 6:
-            printf("AskDepth3 = %f\n", (double)price / price_size);
-            break;
-        case 7:
-            printf("BidDepth4 = %f\n", (double)price / price_size);
-            break;
-        case 8:
-            printf("AskDepth4 = %f\n", (double)price / price_size);
-            break;
-        case 9:
-            printf("BidDepth5 = %f\n", (double)price / price_size);
-            break;
-        case 10:
-            printf("AskDepth5 = %f\n", (double)price / price_size);
-            break;
-        default:
-            printf("item: %d, value: %d\n", fld_idx, price);
+            int err = errno;
+            if (m_busy_poll && (err == EWOULDBLOCK || err == EAGAIN))
+            {
+                on_idle();
+                continue;
+            }
+            if (err == EWOULDBLOCK || err == EAGAIN)
+            {
+                if (m_stats != NULL)
+                    feed_stats_t::add(m_stats->timeouts);
+                printf("recvmmsg() timed out.\n");
+                print_batch_stats();
+                continue;
+            }
+            if (m_stats != NULL)
+                feed_stats_t::add(m_stats->recv_errors);
+            printf("recv data from multicast group failed! Error no: %d, Message: %s\n", err, strerror(err));
+            continue;
+        }
+
+        if (m_stop.load(std::memory_order_relaxed))
             break;
+
+        // 同一批报文共用取出时间，内核时间戳逐个读取
+        m_idle_start_tsc = 0;
+        info.dequeue_tsc = rdtsc();
+        info.dequeue_ns = realtime_ns();
+
+        m_recv_calls++;
+        m_recv_dgrams += recv_num;
+        m_batch_hist[recv_num]++;
+
+        for (int i = 0; i < recv_num; i++)
+        {
+            struct msghdr *msg = &m_batch_msgs[i].msg_hdr;
+            int recv_len = m_batch_msgs[i].msg_len;
+            if (recv_len == 0)
+                printf("Received empty packet or the sender performed an orderly shutdown.\n");
+            else
+                deliver(m_batch_buf[i], recv_len, msg, info);
+
+            // 内核会改写msg_controllen，下次接收前恢复
+            msg->msg_controllen = MC_CTRL_BUF_LEN;
         }
     }
 }
 
+void mc_client_t::loop_ring()
+{
+    printf("recv from packet ring\n");
 
+    mdp_recv_info_t info;
+    info.channel_id = m_channel_id;
 
-uint16 mc_client_t::read_uint16(const char *tbuf)
-{
-    unsigned char *buf = (unsigned char *)tbuf;
-    return (buf[0] << 8) + buf[1];
-}
+    // 帧直接在接收环中交给回调，录制队列仍需复制
+    auto visit = [&](const char *payload, int len, uint64_t kernel_ns)
+    {
+        info.kernel_ns = kernel_ns;
+        count_packet(len, info);
 
-uint32 mc_client_t::read_uint32(const char *tbuf)
-{
-    unsigned char*buf = (unsigned char*)tbuf;
-    return (buf[0] << 24) + (buf[1] << 16) + (buf[2] << 8) + buf[3];
-}
+        if (m_recorder != NULL)
+            m_recorder->push(kernel_ns != 0 ? kernel_ns : info.dequeue_ns, payload, len);
 
-int mc_client_t::get_int_value(const char* p_buf, int &fld_idx, int &value)
-{
-    uint32 temp = 0;
-    memcpy(&temp, p_buf, 4);
-    temp = ntohl(temp);
+        if (m_data_cb != NULL)
+            m_data_cb(m_data_ctx, payload, len, &info);
+    };
+
+    struct pollfd fds[2];
+    fds[0].fd = m_ring->get_fd();
+    fds[0].events = POLLIN;
+    fds[1].fd = m_mc_fd;
+    fds[1].events = POLLIN;
+
+    while(!m_stop.load(std::memory_order_relaxed))
+    {
+        if (!m_ring->block_ready())
+        {
+            if (m_busy_poll)
+            {
+                on_idle();
+                continue;
+            }
+
+            int res = ::poll(fds, 2, MC_IDLE_WAIT_MS);
+            if (res == 0)
+            {
+                if (m_stats != NULL)
+                    feed_stats_t::add(m_stats->timeouts);
+                printf("poll() timed out.\n");
+            }
+            continue;
+        }
 
-    int sign = temp >> 31;           // 符号位(B31)
-    fld_idx = (temp >> 26) & 0x1F;   // item索引(B30-B26)
+        if (m_ring->block_losing() && m_stats != NULL)
+            m_stats->rxq_drops.store(m_ring->read_drops(), std::memory_order_relaxed);
 
-    value = temp & FIELD_VALUE_BIT;  // 数值部分(B25-B0)
-    value *= (0 == sign ? 1 : -1);
+        m_idle_start_tsc = 0;
+        info.dequeue_tsc = rdtsc();
+        info.dequeue_ns = realtime_ns();
+
+        int num = m_ring->consume_block(visit);
+        m_recv_calls++;
+        m_recv_dgrams += num;
+    }
 
-    return 4;
+    if (m_stats != NULL)
+        m_stats->rxq_drops.store(m_ring->read_drops(), std::memory_order_relaxed);
 }
 
-int mc_client_t::get_dep_orderbook(const char* p_buf, int &fld_idx,
-        int &price, int &qty, int &ord_cnt)
+int mc_client_t::alloc_batch_ring()
 {
-    // 获取价格(低位4字节的B0~B31)
-    get_int_value(p_buf, fld_idx, price);
+    free_batch_ring();
 
-    // 获取委托量和订单个数（从高位4字节获取）
-    uint32 temp = 0;
-    memcpy(&temp, &p_buf[4], 4);
-    temp = ntohl(temp);
+    m_batch_buf = (char (*)[MC_RECV_BUF_LEN])calloc(m_recv_batch, MC_RECV_BUF_LEN);
+    m_batch_msgs = (struct mmsghdr *)calloc(m_recv_batch, sizeof(struct mmsghdr));
+    m_batch_iovs = (struct iovec *)calloc(m_recv_batch, sizeof(struct iovec));
+    m_batch_ctrl = (char (*)[MC_CTRL_BUF_LEN])calloc(m_recv_batch, MC_CTRL_BUF_LEN);
+    if (m_batch_buf == NULL || m_batch_msgs == NULL || m_batch_iovs == NULL || m_batch_ctrl == NULL)
+    {
+        free_batch_ring();
+        return -1;
+    }
 
-    qty = temp >> 12;         // 委托量(B31-B12)
-    ord_cnt = temp & 0x0FFF;  // 订单个数(B11-B0)
+    for (int i = 0; i < m_recv_batch; i++)
+    {
+        m_batch_iovs[i].iov_base = m_batch_buf[i];
+        m_batch_iovs[i].iov_len = MC_RECV_BUF_LEN;
 
-    return 8;
+        m_batch_msgs[i].msg_hdr.msg_iov = &m_batch_iovs[i];
+        m_batch_msgs[i].msg_hdr.msg_iovlen = 1;
+        m_batch_msgs[i].msg_hdr.msg_control = m_batch_ctrl[i];
+        m_batch_msgs[i].msg_hdr.msg_controllen = MC_CTRL_BUF_LEN;
+    }
+
+    return 0;
 }
+
+void mc_client_t::free_batch_ring()
+{
+    free(m_batch_buf);
+    free(m_batch_msgs);
+    free(m_batch_iovs);
+    free(m_batch_ctrl);
+
+    m_batch_buf = NULL;
+    m_batch_msgs = NULL;
+    m_batch_iovs = NULL;
+    m_batch_ctrl = NULL;
+}
+
@@ -6,49 +6,32 @@
 #include <memory.h>
 #include <stdlib.h>
 #include <string>
+#include <atomic>
 
-typedef unsigned char uint8;   //8位无符号整数
-typedef unsigned short uint16; //16位无符号整数
-typedef unsigned int uint32;   //32位无符号整数
+#include "mdp_event.h"
 
-#define FIELD_VALUE_BIT 0x3FFFFFF
+#define MC_RECV_BUF_LEN   4096  ///< 单个接收缓冲区大小
+#define MC_MAX_RECV_BATCH 64    ///< 批量接收时单次系统调用最多收取的报文数
+#define MC_CTRL_BUF_LEN   128   ///< 单个报文的控制消息缓冲区大小，容纳接收时间戳
+#define MC_IDLE_WAIT_MS   5000  ///< 忙轮询模式退避到epoll后单次等待的超时，与阻塞模式的接收超时一致
 
-/************* 协议定义 开始 *************/
-///<  消息类型定义
-#define	PACKAGE_INSTRUMENT_IDX		    0x05    ///< 合约索引
-#define	PACKAGE_INSTRUMENT_INIT		    0x06    ///< 初始行情
-#define	PACKAGE_INSTRUMENT		        0x10    ///< 单腿行情
-#define	PACKAGE_CMBTYPE	    		    0x11    ///< 组合行情
-#define	PACKAGE_BULLETINE				0x12    ///< 交易所告示
-#define	PACKAGE_QUOT_REQ		        0x13    ///< 报价请求
-#define	PACKAGE_TRADE_STATUS			0x14    ///< 交易状态
-#define	PACKAGE_DEPTH       			0x20    ///< 深度行情
-
-#define PKG_HEAD_LEN 4   ///< 报文头长度
-#define MSG_HEAD_LEN 2   ///< 消息头长度
-
-#pragma pack(push, 1)
-
-// 报文头
-typedef struct
-{
-    uint8 msg_type;   ///< 报文的类型，0x01-0xff
-    uint8 msg_num;    ///< 报文中消息个数，最大为255
-    uint16 pkg_len;   ///< 报文的长度，不包含4字节报头，高字节在前
-    char pkg_data[0]; ///< 数据正文
-} pkg_head_t;         ///< 报文头
-
-// 消息头
-typedef struct
-{
-    uint16 msg_len;   ///< 消息长度，不包含2字节消息头，高字节在前
-    char msg_data[0]; ///< 消息正文
-} msg_head_t;         ///< 消息头
-
-#pragma pack(pop)
+/**
+ * @brief 组播数据回调，每收到一个UDP包调用一次
+ *
+ * @param ctx 注册回调时传入的上下文指针
+ * @param buf 组播数据指针，仅在回调期间有效
+ * @param len 收到的数据长度
+ * @param info 接收信息（通道号、内核时间戳、取出时间），仅在回调期间有效
+ */
+typedef void (*mc_data_cb_t)(void *ctx, const char *buf, int len, const mdp_recv_info_t *info);
 
-/************* 协议定义 结束 *************/
 
+struct mmsghdr;
+struct msghdr;
+struct iovec;
+class jnl_queue_t;
+class pkt_ring_t;
+struct feed_stats_t;
 
 /**
  * @brief 组播接收客户端
@@ -74,141 +57,236 @@ public:
      *
      * @param bind_if 本地绑定IP
      * @param recv_buf_len 接收缓冲区大小，默认2048Kb
+     * @param recv_batch 单次系统调用最多接收的报文数，1：逐个recvfrom；
+     *                   大于1：使用recvmmsg批量接收，最大MC_MAX_RECV_BATCH
      *
      * @return 0：初始化成功；其他：错误码
      */
-    int init(const char *bind_if, const int recv_buf_len = 2048);
+    int init(const char *bind_if, const int recv_buf_len = 2048, const int recv_batch = 1);
 
     /**
-     * @brief 循环接收组播消息
+     * @brief 设置忙轮询接收模式，需在init()之前调用，默认为阻塞接收
+     *
+     * 开启后socket为非阻塞，接收线程持续轮询，省去每个报文的唤醒和上下文切换，
+     * 代价是独占一个CPU核心；同时设置SO_BUSY_POLL/SO_PREFER_BUSY_POLL，
+     * 让内核在接收调用中直接轮询网卡队列（超过net.core.busy_read需CAP_NET_ADMIN）。
+     *
+     * @param enable 是否开启
+     * @param busy_poll_us 内核忙轮询时间(us)，0表示只在用户态轮询
+     * @param idle_backoff_ms 连续空闲超过该时间后退避到epoll阻塞等待（如午休），
+     *                        收到报文后恢复轮询；0表示始终轮询
      */
-    void loop();
+    void set_busy_poll(bool enable, int busy_poll_us = 50, int idle_backoff_ms = 1000);
 
-/****** 报文处理函数 ******/
-private:
     /**
-     * @brief 处理收到的组播数据
+     * @brief 设置AF_PACKET内存映射接收环（TPACKET_V3），需在init()之前调用
      *
-     * @param buf 组播数据指针
-     * @param len 收到的数据长度
+     * 开启后在init()的本地绑定IP所在网卡上直接从接收环读取组播帧，剥离以太网/IP/UDP头后
+     * 把接收环中的UDP负载直接交给数据回调，不经过socket复制。UDP socket仍加入组播组，
+     * 但挂接丢弃全部报文的过滤器。需要CAP_NET_RAW；可与set_busy_poll()同时使用。
      *
-     * @return 0：处理成功；-1：处理失败
+     * @param enable 是否开启
+     * @param block_size 块大小，页大小的整数倍
+     * @param block_num 块个数
+     * @param retire_ms 块超时(ms)，行情稀疏时单个报文最多延迟该时间
      */
-    int process_data(const char* buf, int len);
+    void set_packet_ring(bool enable, uint32 block_size = 1 << 20, uint32 block_num = 64, uint32 retire_ms = 1);
 
     /**
-     * @brief 处理合约索引消息
-     *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
-     * @param msg_idx 当前处理消息在包内位置
+     * @brief 循环接收组播消息，直到调用stop()
      */
-    void on_instrument_idx(const char *p_data, uint16 msg_len, int msg_idx);
+    void loop();
 
     /**
-     * @brief 处理初始行情消息
+     * @brief 通知接收循环退出，可在其他线程中调用
      *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
+     * 关闭socket读方向以唤醒阻塞中的接收调用，loop()随后返回
      */
-    void on_instrument_init(const char *p_data, uint16 msg_len);
+    void stop();
 
     /**
-     * @brief 处理单腿行情消息
+     * @brief 设置组播数据回调，需在loop()之前调用
      *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
+     * @param cb 回调函数，如mdp_decoder_t<handler_t>::data_cb
+     * @param ctx 回调上下文，如解码器指针
      */
-    void on_instrument(const char *p_data, uint16 msg_len);
+    void set_data_cb(mc_data_cb_t cb, void *ctx);
 
     /**
-     * @brief 处理组合行情消息
+     * @brief 设置报文录制队列，需在loop()之前调用
+     *
+     * 设置后每个收到的UDP包连同接收时间被复制到队列，由jnl_writer_t的写盘线程落盘
      *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
+     * @param recorder 录制队列，NULL表示不录制
      */
-    void on_cmbtype(const char *p_data, uint16 msg_len);
+    void set_recorder(jnl_queue_t *recorder);
 
     /**
-     * @brief 处理交易所告示消息
+     * @brief 设置通道健康计数，需在loop()之前调用
      *
-     * @param p_data msg数据指针
+     * 接收线程累计收包数、字节数、超时、出错及内核丢包数（SO_RXQ_OVFL），
+     * 消息数和格式错误由解码器计入同一对象（mdp_decoder_t::set_stats）
+     *
+     * @param stats 计数对象，NULL表示不统计
      */
-    void on_bulletine(const char *p_data);
+    void set_stats(feed_stats_t *stats);
 
     /**
-     * @brief 处理做市商报价请求消息
-     *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
+     * @brief 设置通道号，随接收信息传给数据回调
      */
-    void on_quot_req(const char *p_data);
+    void set_channel_id(uint16 channel_id);
 
     /**
-     * @brief 处理交易系统状态消息
+     * @brief 是否取得了内核接收时间戳（init()中开启SO_TIMESTAMPING或SO_TIMESTAMPNS）
+     */
+    bool has_kernel_ts() const { return m_ts_enabled; }
+
+    /**
+     * @brief 处理一个收到的UDP包：解析控制消息中的时间戳和丢包数、计数、录制后调用数据回调
      *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
+     * 内部接收循环和外部接收引擎（如uring_engine_t）共用
+     *
+     * @param buf UDP负载
+     * @param len 负载长度
+     * @param msg 携带控制消息的msghdr
+     * @param info 接收信息，调用前需填好取出时间
      */
-    void on_trade_status(const char *p_data);
+    void deliver(const char *buf, int len, struct msghdr *msg, mdp_recv_info_t &info);
 
     /**
-     * @brief 处理深度行情消息
+     * @brief socket描述符，init()之前为-1
+     */
+    int get_fd() const { return m_mc_fd; }
+
+    /**
+     * @brief 是否从AF_PACKET接收环接收，此时socket挂接了丢弃全部报文的过滤器
+     */
+    bool has_packet_ring() const { return m_ring != NULL; }
+
+    /**
+     * @brief 获取组播地址描述，如"239.26.1.1:23001"
+     */
+    std::string get_name() const;
+
+    /**
+     * @brief 获取批量接收统计
      *
-     * @param p_data msg数据指针
-     * @param msg_len msg长度
+     * @param recv_calls 接收系统调用次数（不含超时及出错）
+     * @param recv_dgrams 收到的报文总数
      */
-    void on_depth(const char* p_data, uint16 msg_len);
+    void get_batch_stats(unsigned long long &recv_calls, unsigned long long &recv_dgrams) const;
 
-/****** 工具函数 ******/
+    /**
+     * @brief 打印每次系统调用收取报文数的分布
+     */
+    void print_batch_stats() const;
+
+/****** 接收函数 ******/
 private:
     /**
-     * @brief 调整字节序获取uint16数值
-     *
-     * @param tbuf 数据指针
-     *
-     * @return uint16数值
+     * @brief 逐个报文接收（recvfrom）
      */
-    uint16 read_uint16(const char *tbuf);
+    void loop_single();
 
     /**
-     * @brief 调整字节序获取uint32数值
-     *
-     * @param tbuf 数据指针
-     *
-     * @return uint32数值
+     * @brief 批量报文接收（recvmmsg）
      */
-    uint32 read_uint32(const char *tbuf);
+    void loop_batch();
 
     /**
-     * @brief 从给定buf中获取item索引及值
-     *
-     * @param p_buf 数据指针
-     * @param fld_idx 字段索引的引用
-     * @param value 字段对应数值
+     * @brief 开启内核软件接收时间戳(CLOCK_REALTIME)，优先SO_TIMESTAMPING，失败时退回SO_TIMESTAMPNS
+     */
+    void enable_timestamp();
+
+    /**
+     * @brief 把通道名称和通道号写入健康计数
+     */
+    void fill_stats_info();
+
+    /**
+     * @brief 从接收环读取
+     */
+    void loop_ring();
+
+    /**
+     * @brief 在本地绑定IP所在网卡上打开接收环，并让UDP socket丢弃全部报文
      *
-     * @return 数据长度
+     * @return 0：成功；-1：失败
      */
-    int get_int_value(const char* p_buf, int &fld_idx, int &value);
+    int init_packet_ring(const char *bind_if);
 
     /**
-     * @brief 从buf中解析深度行情数值
+     * @brief 开启忙轮询：非阻塞socket、SO_BUSY_POLL及退避用的epoll
      *
-     * @param p_buf 数据指针
-     * @param fld_idx 字段索引的引用
-     * @param price 价格的引用
-     * @param qty 定单手数的引用
-     * @param ord_cnt 定单个数的引用
+     * @return 0：成功；-1：失败
+     */
+    int init_busy_poll();
+
+    /**
+     * @brief 忙轮询模式下没有报文可读时调用：空闲不久时原地等待，空闲过久时阻塞在epoll上
+     */
+    void on_idle();
+
+    /**
+     * @brief 解析控制消息：接收时间戳写入info.kernel_ns（没有时为0），内核丢包数写入计数
+     */
+    void read_cmsg(struct msghdr *msg, mdp_recv_info_t &info);
+
+    /**
+     * @brief 记录收到一个UDP包
+     */
+    void count_packet(int recv_len, const mdp_recv_info_t &info);
+
+    /**
+     * @brief 分配批量接收所需的缓冲区环
      *
-     * @return 数据长度
+     * @return 0：成功；-1：失败
      */
-    int get_dep_orderbook(const char* p_buf, int &fld_idx, int &price, int &qty, int &ord_cnt);
+    int alloc_batch_ring();
+
+    /**
+     * @brief 释放批量接收缓冲区环
+     */
+    void free_batch_ring();
 
 private:
     std::string m_mc_ip;     ///<组播IP地址
     unsigned int m_mc_port;  ///<组播端口号
     int m_mc_fd;             ///<组播socket文件描述符
-    char m_recv_buf[4096];   ///<接收缓冲区
+    char m_recv_buf[MC_RECV_BUF_LEN];   ///<接收缓冲区
+    char m_ctrl_buf[MC_CTRL_BUF_LEN];   ///<控制消息缓冲区
+    std::atomic<bool> m_stop;            ///<接收循环退出标志
+
+    mc_data_cb_t m_data_cb;              ///<组播数据回调
+    void *m_data_ctx;                    ///<回调上下文
+    jnl_queue_t *m_recorder;             ///<报文录制队列
+    feed_stats_t *m_stats;               ///<通道健康计数
+    uint16 m_channel_id;                 ///<通道号
+
+    bool m_use_ring;                     ///<是否使用AF_PACKET接收环
+    uint32 m_ring_block_size;            ///<接收环块大小
+    uint32 m_ring_block_num;             ///<接收环块个数
+    uint32 m_ring_retire_ms;             ///<接收环块超时
+    pkt_ring_t *m_ring;                  ///<AF_PACKET接收环
+
+    bool m_busy_poll;                    ///<是否忙轮询接收
+    int m_busy_poll_us;                  ///<内核忙轮询时间(us)
+    int m_idle_backoff_ms;               ///<空闲多久后退避到epoll
+    int m_epoll_fd;                      ///<退避等待用的epoll
+    uint64_t m_idle_backoff_tsc;         ///<退避阈值对应的rdtsc计数
+    uint64_t m_idle_start_tsc;           ///<本次空闲开始时的rdtsc，0表示未空闲
+    unsigned long long m_idle_waits;     ///<退避到epoll的次数
+    bool m_ts_enabled;                   ///<是否开启了内核接收时间戳
+
+    int m_recv_batch;                    ///<单次系统调用最多接收的报文数
+    char (*m_batch_buf)[MC_RECV_BUF_LEN];  ///<批量接收缓冲区环
+    struct mmsghdr *m_batch_msgs;        ///<recvmmsg消息描述
+    struct iovec *m_batch_iovs;          ///<每个缓冲区对应的iovec
+    char (*m_batch_ctrl)[MC_CTRL_BUF_LEN];  ///<每个报文的控制消息缓冲区
+
+    unsigned long long m_recv_calls;     ///<接收系统调用次数
+    unsigned long long m_recv_dgrams;    ///<收到的报文总数
+    unsigned long long m_batch_hist[MC_MAX_RECV_BATCH + 1];  ///<单次调用收取报文数的分布
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <sched.h>
+#include <string.h>
+
+#include "mc_runner.h"
+
+mc_runner_t::mc_runner_t()
+{
+    m_started = false;
+}
+
+mc_runner_t::~mc_runner_t()
+{
+    stop();
+    join();
+}
+
+int mc_runner_t::add_channel(mc_client_t *client, int cpu_id, int rt_priority)
+{
+    return add_thread(client, NULL, cpu_id, rt_priority);
+}
+
+int mc_runner_t::add_engine(uring_engine_t *engine, int cpu_id, int rt_priority)
+{
+    return add_thread(NULL, engine, cpu_id, rt_priority);
+}
+
+int mc_runner_t::add_thread(mc_client_t *client, uring_engine_t *engine, int cpu_id, int rt_priority)
+{
+    if (m_started || (client == NULL && engine == NULL))
+    {
+        printf("add channel failed: runner started or client is null!\n");
+        return -1;
+    }
+
+    if (rt_priority < 0 || rt_priority > 99)
+    {
+        printf("invalid SCHED_FIFO priority: %d\n", rt_priority);
+        return -1;
+    }
+
+    channel_t channel;
+    memset(&channel, 0, sizeof(channel));
+    channel.client = client;
+    channel.engine = engine;
+    channel.cpu_id = cpu_id;
+    channel.rt_priority = rt_priority;
+    channel.started = false;
+    m_channels.push_back(channel);
+
+    return 0;
+}
+
+int mc_runner_t::start()
+{
+    if (m_started)
+    {
+        printf("runner has been started!\n");
+        return -1;
+    }
+    m_started = true;
+
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        int res = pthread_create(&m_channels[i].thread, NULL, thread_main, &m_channels[i]);
+        if (res != 0)
+        {
+            printf("create receive thread for %s failed: %s\n",
+                    get_name(m_channels[i]).c_str(), strerror(res));
+            stop();
+            join();
+            return -1;
+        }
+        m_channels[i].started = true;
+    }
+
+    return 0;
+}
+
+void mc_runner_t::stop()
+{
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        if (!m_channels[i].started)
+            continue;
+
+        if (m_channels[i].client != NULL)
+            m_channels[i].client->stop();
+        else
+            m_channels[i].engine->stop();
+    }
+}
+
+void mc_runner_t::join()
+{
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        if (m_channels[i].started)
+        {
+            pthread_join(m_channels[i].thread, NULL);
+            m_channels[i].started = false;
+        }
+    }
+}
+
+void *mc_runner_t::thread_main(void *arg)
+{
+    channel_t *channel = (channel_t *)arg;
+    std::string name = get_name(*channel);
+
+    if (channel->cpu_id >= 0)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(channel->cpu_id, &cpu_set);
+
+        int res = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (res != 0)
+            printf("[%s] bind cpu %d failed: %s\n", name.c_str(), channel->cpu_id, strerror(res));
+        else
+            printf("[%s] receive thread bound to cpu %d\n", name.c_str(), channel->cpu_id);
+    }
+
+    if (channel->rt_priority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = channel->rt_priority;
+
+        int res = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (res != 0)
+            printf("[%s] set SCHED_FIFO priority %d failed: %s\n", name.c_str(), channel->rt_priority, strerror(res));
+        else
+            printf("[%s] receive thread running with SCHED_FIFO priority %d\n", name.c_str(), channel->rt_priority);
+    }
+
+    if (channel->client != NULL)
+        channel->client->loop();
+    else
+        channel->engine->loop();
+
+    printf("[%s] receive thread exit\n", name.c_str());
+    return NULL;
+}
+
+std::string mc_runner_t::get_name(const channel_t &channel)
+{
+    return channel.client != NULL ? channel.client->get_name() : channel.engine->get_name();
+}
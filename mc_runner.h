@@ -0,0 +1,99 @@
+#ifndef MC_RUNNER_H_
+#define MC_RUNNER_H_
+
+#include <pthread.h>
+#include <vector>
+
+#include "mc_client.h"
+#include "uring_engine.h"
+
+/**
+ * @brief 多通道接收调度器
+ *
+ * 为每个组播通道(mc_client_t)或多通道接收引擎(uring_engine_t)创建独立的接收线程，
+ * 可分别绑定CPU核心并设置SCHED_FIFO实时优先级，各线程互不阻塞。
+ */
+class mc_runner_t
+{
+public:
+    mc_runner_t();
+
+    /**
+     * @brief 析构函数，未停止的线程会被停止并回收
+     */
+    ~mc_runner_t();
+
+    /**
+     * @brief 添加接收通道，需在start()之前调用
+     *
+     * @param client 已完成init()的组播客户端，生命周期由调用方管理
+     * @param cpu_id 接收线程绑定的CPU核心，-1表示不绑定
+     * @param rt_priority SCHED_FIFO优先级(1~99)，0表示使用普通调度
+     *
+     * @return 0：成功；-1：参数错误或已启动
+     */
+    int add_channel(mc_client_t *client, int cpu_id = -1, int rt_priority = 0);
+
+    /**
+     * @brief 添加多通道接收引擎，引擎中的通道不应再通过add_channel()添加，需在start()之前调用
+     *
+     * @param engine 已完成init()的接收引擎，生命周期由调用方管理
+     * @param cpu_id 接收线程绑定的CPU核心，-1表示不绑定
+     * @param rt_priority SCHED_FIFO优先级(1~99)，0表示使用普通调度
+     *
+     * @return 0：成功；-1：参数错误或已启动
+     */
+    int add_engine(uring_engine_t *engine, int cpu_id = -1, int rt_priority = 0);
+
+    /**
+     * @brief 启动所有通道的接收线程
+     *
+     * @return 0：成功；-1：创建线程失败（已启动的线程会被停止）
+     */
+    int start();
+
+    /**
+     * @brief 通知所有通道退出接收循环
+     */
+    void stop();
+
+    /**
+     * @brief 等待所有接收线程退出
+     */
+    void join();
+
+private:
+    /**
+     * @brief 通道配置及线程句柄
+     */
+    struct channel_t
+    {
+        mc_client_t *client;  ///< 组播客户端，与engine二选一
+        uring_engine_t *engine;  ///< 多通道接收引擎
+        int cpu_id;           ///< 绑定的CPU核心
+        int rt_priority;      ///< SCHED_FIFO优先级
+        pthread_t thread;     ///< 接收线程
+        bool started;         ///< 线程是否已创建
+    };
+
+    /**
+     * @brief 接收线程入口：设置亲和性及调度策略后进入loop()
+     */
+    static void *thread_main(void *arg);
+
+    /**
+     * @brief 添加线程配置
+     */
+    int add_thread(mc_client_t *client, uring_engine_t *engine, int cpu_id, int rt_priority);
+
+    /**
+     * @brief 线程名称，用于日志
+     */
+    static std::string get_name(const channel_t &channel);
+
+private:
+    std::vector<channel_t> m_channels;  ///< 通道列表
+    bool m_started;                     ///< 是否已启动
+};
+
+#endif
@@ -0,0 +1,424 @@
+#ifndef MDP_DECODER_H_
+#define MDP_DECODER_H_
+
+#include "mdp_handler.h"
+#include "mdp_view.h"
+#include "latency_hist.h"
+#include "feed_stats.h"
+#include "subscription.h"
+
+/**
+ * @brief 行情解码器
+ *
+ * 将组播数据解码为类型化事件并交给处理器，解码过程不做任何输出。
+ * 处理器类型为模板参数，接口见mdp_null_handler_t。
+ */
+template <typename handler_t>
+class mdp_decoder_t
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param handler 事件处理器，生命周期由调用方管理
+     */
+    explicit mdp_decoder_t(handler_t &handler)
+        : m_handler(handler), m_latency(NULL), m_stats(NULL), m_sub(NULL)
+    {
+    }
+
+    /**
+     * @brief 处理收到的组播数据
+     *
+     * @param buf 组播数据指针
+     * @param len 收到的数据长度
+     * @param info 接收信息，设置了延迟统计时用于计算各阶段延迟，可为NULL
+     *
+     * @return 0：处理成功；-1：未知报文类型或长度不合法，其后的数据被丢弃
+     */
+    int process_data(const char* buf, int len, const mdp_recv_info_t *info = NULL);
+
+    /**
+     * @brief 供mc_client_t::set_data_cb()使用的回调，ctx为解码器指针
+     */
+    static void data_cb(void *ctx, const char *buf, int len, const mdp_recv_info_t *info)
+    {
+        ((mdp_decoder_t *)ctx)->process_data(buf, len, info);
+    }
+
+    /**
+     * @brief 设置延迟统计，之后每个消息处理完成时多读一次rdtsc
+     *
+     * @param latency 延迟统计，NULL表示不统计
+     */
+    void set_latency(latency_stats_t *latency) { m_latency = latency; }
+
+    /**
+     * @brief 设置通道健康计数，累计各类型消息数、未知类型和长度不合法的UDP包
+     *
+     * @param stats 计数对象，通常与mc_client_t::set_stats()为同一个，NULL表示不统计
+     */
+    void set_stats(feed_stats_t *stats) { m_stats = stats; }
+
+    /**
+     * @brief 设置合约订阅，之后未订阅合约的行情消息只读取合约索引即跳过，不交给处理器
+     *
+     * 合约索引消息先更新订阅位图再交给处理器；订阅对象只应由本解码器的线程使用
+     *
+     * @param sub 订阅，NULL表示处理所有合约
+     */
+    void set_subscription(subscription_t *sub) { m_sub = sub; }
+
+    handler_t &get_handler() { return m_handler; }
+
+/****** 报文处理函数 ******/
+private:
+    /**
+     * @brief 处理合约索引消息
+     *
+     * @param msg 消息视图
+     * @param msg_idx 当前处理消息在包内位置
+     */
+    void on_instrument_idx(const mdp_msg_view_t &msg, int msg_idx);
+
+    /**
+     * @brief 处理初始行情消息
+     *
+     * @param msg 消息视图
+     */
+    void on_instrument_init(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 处理单腿行情消息
+     *
+     * @param msg 消息视图
+     */
+    void on_instrument(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 处理组合行情消息
+     *
+     * @param msg 消息视图
+     */
+    void on_cmbtype(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 处理交易所告示消息
+     *
+     * @param msg 消息视图
+     */
+    void on_bulletine(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 处理做市商报价请求消息
+     *
+     * @param msg 消息视图
+     */
+    void on_quot_req(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 处理交易系统状态消息
+     *
+     * @param msg 消息视图
+     */
+    void on_trade_status(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 处理深度行情消息
+     *
+     * @param msg 消息视图
+     */
+    void on_depth(const mdp_msg_view_t &msg);
+
+    /**
+     * @brief 解析“价格精度+合约索引+字段列表”格式的消息体
+     *
+     * @param msg 消息视图
+     * @param price_size 价格精度的引用
+     * @param ins_idx 合约索引的引用
+     * @param fld 字段集合
+     */
+    void decode_fields(const mdp_msg_view_t &msg, uint16 &price_size, uint16 &ins_idx, mdp_fields_t &fld);
+
+    /**
+     * @brief 各类型消息体的最小长度，不足时视为格式错误
+     *
+     * @param msg_type 报文类型
+     * @param msg_idx 消息在包内位置（合约索引的首个消息带交易日）
+     */
+    static int min_msg_len(uint8 msg_type, int msg_idx)
+    {
+        switch (msg_type)
+        {
+        case PACKAGE_INSTRUMENT_IDX:  return msg_idx == 0 ? 7 : 3;
+        case PACKAGE_INSTRUMENT_INIT:
+        case PACKAGE_INSTRUMENT:
+        case PACKAGE_CMBTYPE:
+        case PACKAGE_BULLETINE:
+        case PACKAGE_DEPTH:           return 4;
+        case PACKAGE_QUOT_REQ:        return 14;
+        case PACKAGE_TRADE_STATUS:    return 1;
+        default:                      return 0;
+        }
+    }
+
+    /**
+     * @brief 记录一个长度不合法的UDP包
+     *
+     * @return -1
+     */
+    int on_malformed()
+    {
+        if (m_stats != NULL)
+            feed_stats_t::add(m_stats->malformed);
+        return -1;
+    }
+
+private:
+    handler_t &m_handler;         ///< 事件处理器
+    latency_stats_t *m_latency;   ///< 延迟统计
+    feed_stats_t *m_stats;        ///< 通道健康计数
+    subscription_t *m_sub;        ///< 合约订阅
+};
+
+template <typename handler_t>
+int mdp_decoder_t<handler_t>::process_data(const char* buf, int len, const mdp_recv_info_t *info)
+{
+    bool timed = m_latency != NULL && info != NULL;
+    uint64_t decode_tsc = timed ? rdtsc() : 0;
+    uint64_t done_tsc = 0;
+
+    // 可能存在一个UDP包中含有多个数据包，报文头、消息头和长度越界由视图在迭代时检查
+    mdp_datagram_view_t dgram(buf, len);
+    for (const mdp_pkg_view_t &pkg : dgram)
+    {
+        int i = 0;  // 当前消息在包内位置
+        for (const mdp_msg_view_t &msg : pkg)
+        {
+            if (msg.len() < min_msg_len(pkg.type(), i))
+                return on_malformed();
+
+            // 未订阅合约只读取价格精度和合约索引（或询价消息头和合约索引）
+            if (m_sub != NULL && subscription_t::is_filtered_type(pkg.type()) && !m_sub->has(msg.read_u16(2)))
+            {
+                if (m_stats != NULL)
+                {
+                    feed_stats_t::add(m_stats->msgs[pkg.type()]);
+                    feed_stats_t::add(m_stats->filtered);
+                }
+                i++;
+                continue;
+            }
+
+            switch (pkg.type())
+            {
+            case PACKAGE_INSTRUMENT_IDX:   //合约索引信息消息
+                on_instrument_idx(msg, i);
+                break;
+            case PACKAGE_INSTRUMENT_INIT:  //初始行情消息
+                on_instrument_init(msg);
+                break;
+            case PACKAGE_INSTRUMENT:       //单腿行情消息
+                on_instrument(msg);
+                break;
+            case PACKAGE_CMBTYPE:          //组合行情消息
+                on_cmbtype(msg);
+                break;
+            case PACKAGE_BULLETINE:        //交易所告示消息
+                on_bulletine(msg);
+                break;
+            case PACKAGE_QUOT_REQ:         //做市商报价请求消息
+                on_quot_req(msg);
+                break;
+            case PACKAGE_TRADE_STATUS:     //交易系统状态消息
+                on_trade_status(msg);
+                break;
+            case PACKAGE_DEPTH:            //深度行情消息
+                on_depth(msg);
+                break;
+            default:
+                if (m_stats != NULL)
+                    feed_stats_t::add(m_stats->unknown_types);
+                m_handler.on_unknown(pkg.type());
+                return -1;
+            }
+
+            if (m_stats != NULL)
+                feed_stats_t::add(m_stats->msgs[pkg.type()]);
+
+            if (timed)
+            {
+                done_tsc = rdtsc();
+                m_latency->record_msg(pkg.type(), *info, done_tsc);
+            }
+
+            i++;
+        }
+
+        if (dgram.malformed())
+            break;
+    }
+
+    if (dgram.malformed())
+        return on_malformed();
+
+    if (done_tsc != 0)
+        m_latency->record_datagram(*info, decode_tsc, done_tsc);
+
+    return 0;
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_instrument_idx(const mdp_msg_view_t &msg, int msg_idx)
+{
+    mdp_idx_event_t ev;
+    int data_pos = 0;
+
+    ev.msg_idx = msg_idx;
+    ev.trade_date = 0;
+
+    // 交易日（仅在第一个msg中存在）
+    if (msg_idx == 0)
+    {
+        ev.trade_date = msg.read_u32(data_pos);
+        data_pos += 4;
+    }
+
+    // 合约类型
+    ev.ins_type = msg.data()[data_pos];
+    data_pos += 1;
+
+    // 合约索引
+    ev.ins_idx = msg.read_u16(data_pos);
+    data_pos += 2;
+
+    // 合约编码
+    int id_len = msg.len() - data_pos;
+    if (id_len < 0)
+        id_len = 0;
+    if (id_len > MDP_INS_ID_LEN - 1)
+        id_len = MDP_INS_ID_LEN - 1;
+    memcpy(ev.ins_id, msg.data() + data_pos, id_len);
+    ev.ins_id[id_len] = '\0';
+
+    if (m_sub != NULL)
+        m_sub->on_instrument_idx(ev);
+
+    m_handler.on_instrument_idx(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::decode_fields(const mdp_msg_view_t &msg,
+        uint16 &price_size, uint16 &ins_idx, mdp_fields_t &fld)
+{
+    price_size = msg.read_u16(0);  // 价格精度
+    ins_idx = msg.read_u16(2);     // 合约索引
+
+    fld.mask = 0;
+    for (mdp_field_t f : msg.fields(4))
+    {
+        fld.mask |= 1u << f.fld_idx;
+        fld.value[f.fld_idx] = f.value;
+    }
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_instrument_init(const mdp_msg_view_t &msg)
+{
+    mdp_init_event_t ev;
+    decode_fields(msg, ev.price_size, ev.ins_idx, ev.fld);
+
+    m_handler.on_instrument_init(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_instrument(const mdp_msg_view_t &msg)
+{
+    mdp_tick_event_t ev;
+    decode_fields(msg, ev.price_size, ev.ins_idx, ev.fld);
+
+    // 总成交金额，long long保证左移26位时不溢出
+    long long trade_val_part1 = ev.fld.has(TICK_FLD_TRADE_VAL1) ? ev.fld.value[TICK_FLD_TRADE_VAL1] : 0;
+    long long trade_val_part2 = ev.fld.has(TICK_FLD_TRADE_VAL2) ? ev.fld.value[TICK_FLD_TRADE_VAL2] : 0;
+    ev.trade_val = (trade_val_part1 << 26) | trade_val_part2;
+
+    m_handler.on_instrument(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_cmbtype(const mdp_msg_view_t &msg)
+{
+    mdp_cmb_event_t ev;
+    decode_fields(msg, ev.price_size, ev.ins_idx, ev.fld);
+
+    m_handler.on_cmbtype(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_bulletine(const mdp_msg_view_t &msg)
+{
+    mdp_bulletine_event_t ev;
+
+    // 广播消息头(2字节)之后为广播消息序号
+    ev.msg_seq = msg.read_u16(2);
+
+    // 广播内容
+    ev.text = msg.data() + 4;
+    ev.text_len = msg.len() - 4;
+
+    m_handler.on_bulletine(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_quot_req(const mdp_msg_view_t &msg)
+{
+    mdp_quot_req_event_t ev;
+
+    // 询价消息头(2字节)之后为询价合约索引
+    ev.ins_idx = msg.read_u16(2);
+
+    // 当前交易日期、询价号
+    ev.trade_date = mdp_field_t::read(msg.data() + 4).value;
+    ev.req_no = mdp_field_t::read(msg.data() + 8).value;
+
+    // 询价方向（0-买；1-卖；2-其他）
+    ev.direction = msg.data()[12];
+
+    // 询价来源（0-会员；1-交易所）
+    ev.request_by = msg.data()[13];
+
+    m_handler.on_quot_req(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_trade_status(const mdp_msg_view_t &msg)
+{
+    mdp_trade_status_event_t ev;
+
+    // 交易状态
+    ev.trade_status = msg.data()[0];
+
+    m_handler.on_trade_status(ev);
+}
+
+template <typename handler_t>
+void mdp_decoder_t<handler_t>::on_depth(const mdp_msg_view_t &msg)
+{
+    mdp_depth_event_t ev;
+
+    ev.price_size = msg.read_u16(0);  // 价格精度
+    ev.ins_idx = msg.read_u16(2);     // 合约索引
+
+    ev.mask = 0;
+    for (mdp_depth_field_t f : msg.depth_fields(4))
+    {
+        ev.mask |= 1u << f.fld_idx;
+        ev.entry[f.fld_idx].price = f.price;
+        ev.entry[f.fld_idx].qty = f.qty;
+        ev.entry[f.fld_idx].ord_cnt = f.ord_cnt;
+    }
+
+    m_handler.on_depth(ev);
+}
+
+#endif
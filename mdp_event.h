@@ -0,0 +1,173 @@
+#ifndef MDP_EVENT_H_
+#define MDP_EVENT_H_
+
+#include <stdint.h>
+
+#include "mdp_protocol.h"
+#include "mdp_price.h"
+
+#define MDP_FIELD_NUM   32  ///< 字段索引占5位，最多32个字段
+#define MDP_INS_ID_LEN  20  ///< 合约编码最大长度（含结尾'\0'）
+
+///< 初始行情字段索引
+#define INIT_FLD_LAST_CLOSE     1   ///< 昨收盘价
+#define INIT_FLD_LAST_CLEAR     2   ///< 昨结算价
+#define INIT_FLD_LAST_HOLDING   3   ///< 昨持仓
+#define INIT_FLD_LIMIT_UP       4   ///< 涨停价
+#define INIT_FLD_LIMIT_DOWN     5   ///< 跌停价
+#define INIT_FLD_ALL_MASK       ((1u << INIT_FLD_LAST_CLOSE) | (1u << INIT_FLD_LAST_CLEAR) | (1u << INIT_FLD_LAST_HOLDING) \
+        | (1u << INIT_FLD_LIMIT_UP) | (1u << INIT_FLD_LIMIT_DOWN))  ///< 全部初始行情字段的位图
+
+///< 单腿行情字段索引
+#define TICK_FLD_OPEN           1   ///< 开盘价
+#define TICK_FLD_HIGH           2   ///< 最高价
+#define TICK_FLD_LOW            3   ///< 最低价
+#define TICK_FLD_LAST           4   ///< 最新价
+#define TICK_FLD_VOLUME         9   ///< 成交量
+#define TICK_FLD_TIME_SEC       16  ///< 秒级时间戳
+#define TICK_FLD_TIME_USEC      18  ///< 微秒级时间戳
+#define TICK_FLD_TRADE_VAL1     19  ///< 总成交金额(part1)
+#define TICK_FLD_TRADE_VAL2     20  ///< 总成交金额(part2)
+#define TICK_FLD_LIFE_HIGH      21  ///< 历史最高价
+#define TICK_FLD_LIFE_LOW       22  ///< 历史最低价
+
+///< 组合行情字段索引
+#define CMB_FLD_BID             1   ///< 买价
+#define CMB_FLD_ASK             2   ///< 卖价
+#define CMB_FLD_BID_LOT         3   ///< 买量
+#define CMB_FLD_ASK_LOT         4   ///< 卖量
+#define CMB_FLD_TIME_SEC        7   ///< 秒级时间戳
+#define CMB_FLD_TIME_USEC       8   ///< 微秒级时间戳
+
+///< 深度行情字段索引：1,3,5,7,9为买一~买五；2,4,6,8,10为卖一~卖五
+#define DEPTH_LEVEL_NUM         5
+#define DEPTH_FLD_BID(level)    ((level) * 2 + 1)   ///< level从0开始
+#define DEPTH_FLD_ASK(level)    ((level) * 2 + 2)   ///< level从0开始
+
+/**
+ * @brief 单个UDP包的接收信息，随数据回调一起传给解码器
+ */
+struct mdp_recv_info_t
+{
+    uint16 channel_id;      ///< 通道号
+    uint64_t kernel_ns;     ///< 内核软件接收时间戳，CLOCK_REALTIME，0表示不可用
+    uint64_t dequeue_ns;    ///< 用户态取出报文时的系统时钟(ns)
+    uint64_t dequeue_tsc;   ///< 用户态取出报文时的rdtsc
+};
+
+/**
+ * @brief 按字段索引存放的增量字段集合，mask中置位的字段本次有更新
+ */
+struct mdp_fields_t
+{
+    uint32 mask;                ///< 本次出现的字段位图，第fld_idx位对应value[fld_idx]
+    int value[MDP_FIELD_NUM];   ///< 字段值，仅mask置位的有效
+
+    bool has(int fld_idx) const { return (mask >> fld_idx) & 1; }
+};
+
+/**
+ * @brief 深度行情单个档位
+ */
+struct mdp_depth_entry_t
+{
+    int price;    ///< 价格
+    int qty;      ///< 委托量
+    int ord_cnt;  ///< 订单个数
+};
+
+/**
+ * @brief 合约索引事件(0x05)
+ */
+struct mdp_idx_event_t
+{
+    int msg_idx;                    ///< 消息在包内的位置
+    uint32 trade_date;              ///< 交易日，仅msg_idx为0时有效
+    uint8 ins_type;                 ///< 合约类型
+    uint16 ins_idx;                 ///< 合约索引
+    char ins_id[MDP_INS_ID_LEN];    ///< 合约编码
+};
+
+/**
+ * @brief 初始行情事件(0x06)，字段见INIT_FLD_*
+ */
+struct mdp_init_event_t
+{
+    uint16 price_size;  ///< 价格精度
+    uint16 ins_idx;     ///< 合约索引
+    mdp_fields_t fld;   ///< 字段
+
+    price_t price(int fld_idx) const { return price_t(fld.value[fld_idx], price_size); }
+};
+
+/**
+ * @brief 单腿行情事件(0x10)，字段见TICK_FLD_*
+ */
+struct mdp_tick_event_t
+{
+    uint16 price_size;  ///< 价格精度
+    uint16 ins_idx;     ///< 合约索引
+    mdp_fields_t fld;   ///< 字段
+    long long trade_val;  ///< 由part1/part2合成的总成交金额（未除价格精度），两部分都未出现时为0
+
+    price_t price(int fld_idx) const { return price_t(fld.value[fld_idx], price_size); }
+    price_t turnover() const { return price_t(trade_val, price_size); }
+};
+
+/**
+ * @brief 组合行情事件(0x11)，字段见CMB_FLD_*
+ */
+struct mdp_cmb_event_t
+{
+    uint16 price_size;  ///< 价格精度
+    uint16 ins_idx;     ///< 合约索引
+    mdp_fields_t fld;   ///< 字段
+
+    price_t price(int fld_idx) const { return price_t(fld.value[fld_idx], price_size); }
+};
+
+/**
+ * @brief 交易所告示事件(0x12)
+ */
+struct mdp_bulletine_event_t
+{
+    uint16 msg_seq;     ///< 广播消息序号
+    const char *text;   ///< 广播内容，直接指向接收缓冲区
+    int text_len;       ///< 广播内容长度
+};
+
+/**
+ * @brief 做市商报价请求事件(0x13)
+ */
+struct mdp_quot_req_event_t
+{
+    uint16 ins_idx;     ///< 询价合约索引
+    int trade_date;     ///< 当前交易日期
+    int req_no;         ///< 询价号
+    uint8 direction;    ///< 询价方向（0-买；1-卖；2-其他）
+    uint8 request_by;   ///< 询价来源（0-会员；1-交易所）
+};
+
+/**
+ * @brief 交易系统状态事件(0x14)
+ */
+struct mdp_trade_status_event_t
+{
+    uint8 trade_status;  ///< 交易状态
+};
+
+/**
+ * @brief 深度行情事件(0x20)，档位见DEPTH_FLD_BID/DEPTH_FLD_ASK
+ */
+struct mdp_depth_event_t
+{
+    uint16 price_size;                      ///< 价格精度
+    uint16 ins_idx;                         ///< 合约索引
+    uint32 mask;                            ///< 本次出现的档位位图
+    mdp_depth_entry_t entry[MDP_FIELD_NUM]; ///< 按字段索引存放的档位
+
+    bool has(int fld_idx) const { return (mask >> fld_idx) & 1; }
+    price_t price(int fld_idx) const { return price_t(entry[fld_idx].price, price_size); }
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef MDP_HANDLER_H_
+#define MDP_HANDLER_H_
+
+#include "mdp_event.h"
+
+/**
+ * @brief 空处理器，定义解码器回调接口
+ *
+ * 处理器作为mdp_decoder_t的模板参数，调用在编译期绑定并可内联，不经过虚函数。
+ * 自定义处理器可继承本类，只实现（隐藏）关心的事件。
+ */
+struct mdp_null_handler_t
+{
+    void on_instrument_idx(const mdp_idx_event_t &) {}
+    void on_instrument_init(const mdp_init_event_t &) {}
+    void on_instrument(const mdp_tick_event_t &) {}
+    void on_cmbtype(const mdp_cmb_event_t &) {}
+    void on_bulletine(const mdp_bulletine_event_t &) {}
+    void on_quot_req(const mdp_quot_req_event_t &) {}
+    void on_trade_status(const mdp_trade_status_event_t &) {}
+    void on_depth(const mdp_depth_event_t &) {}
+
+    /**
+     * @brief 未知报文类型，解码器随后放弃该UDP包的剩余部分
+     */
+    void on_unknown(uint8) {}
+};
+
+/**
+ * @brief 处理器组合，将每个事件依次转发给两个处理器
+ *
+ * 可嵌套使用以组合多个处理器，例如
+ * mdp_handler_pair_t<ins_table_t, mdp_handler_pair_t<A, B> >
+ */
+template <typename first_t, typename second_t>
+class mdp_handler_pair_t
+{
+public:
+    mdp_handler_pair_t(first_t &first, second_t &second)
+        : m_first(first), m_second(second)
+    {
+    }
+
+    void on_instrument_idx(const mdp_idx_event_t &ev) { m_first.on_instrument_idx(ev); m_second.on_instrument_idx(ev); }
+    void on_instrument_init(const mdp_init_event_t &ev) { m_first.on_instrument_init(ev); m_second.on_instrument_init(ev); }
+    void on_instrument(const mdp_tick_event_t &ev) { m_first.on_instrument(ev); m_second.on_instrument(ev); }
+    void on_cmbtype(const mdp_cmb_event_t &ev) { m_first.on_cmbtype(ev); m_second.on_cmbtype(ev); }
+    void on_bulletine(const mdp_bulletine_event_t &ev) { m_first.on_bulletine(ev); m_second.on_bulletine(ev); }
+    void on_quot_req(const mdp_quot_req_event_t &ev) { m_first.on_quot_req(ev); m_second.on_quot_req(ev); }
+    void on_trade_status(const mdp_trade_status_event_t &ev) { m_first.on_trade_status(ev); m_second.on_trade_status(ev); }
+    void on_depth(const mdp_depth_event_t &ev) { m_first.on_depth(ev); m_second.on_depth(ev); }
+    void on_unknown(uint8 msg_type) { m_first.on_unknown(msg_type); m_second.on_unknown(msg_type); }
+
+private:
+    first_t &m_first;
+    second_t &m_second;
+};
+
+#endif
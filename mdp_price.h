@@ -0,0 +1,135 @@
+#ifndef MDP_PRICE_H_
+#define MDP_PRICE_H_
+
+#include <stdio.h>
+
+#include "mdp_protocol.h"
+
+/**
+ * @brief 定点价格：原始整数+价格精度，实际价格为raw / price_size
+ *
+ * 行情中的价格字段、成交金额均为整数，价格精度来自消息头。解码、盘口和状态表
+ * 只保存原始整数，比较和加减乘都按整数精确计算（精度不同时先化为公分母），
+ * 只有消费方调用to_double()或format()时才换算，避免热路径上的除法和
+ * 与涨跌停价比较时的舍入误差。
+ */
+struct price_t
+{
+    long long raw;      ///< 原始整数
+    uint32 price_size;  ///< 价格精度（除数），0视为1
+
+    price_t() : raw(0), price_size(1) {}
+    price_t(long long value, uint32 size) : raw(value), price_size(size) {}
+
+    /**
+     * @brief 换算为浮点数，即(double)raw / price_size
+     */
+    double to_double() const { return (double)raw / divisor(price_size); }
+
+    /**
+     * @brief 精确比较
+     *
+     * @return 负数：小于；0：相等；正数：大于
+     */
+    int compare(const price_t &other) const
+    {
+        if (price_size == other.price_size)
+            return raw < other.raw ? -1 : (raw > other.raw ? 1 : 0);
+
+        // 交叉相乘，成交金额（约2^52）乘以精度可能超出64位
+        __int128 lhs = (__int128)raw * divisor(other.price_size);
+        __int128 rhs = (__int128)other.raw * divisor(price_size);
+        return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+    }
+
+    bool operator==(const price_t &other) const { return compare(other) == 0; }
+    bool operator!=(const price_t &other) const { return compare(other) != 0; }
+    bool operator<(const price_t &other) const { return compare(other) < 0; }
+    bool operator<=(const price_t &other) const { return compare(other) <= 0; }
+    bool operator>(const price_t &other) const { return compare(other) > 0; }
+    bool operator>=(const price_t &other) const { return compare(other) >= 0; }
+
+    price_t operator-() const { return price_t(-raw, price_size); }
+    price_t operator+(const price_t &other) const { return add(other, 1); }
+    price_t operator-(const price_t &other) const { return add(other, -1); }
+
+    /**
+     * @brief 乘以整数（如价格乘手数），精度不变
+     */
+    price_t operator*(long long n) const { return price_t(raw * n, price_size); }
+
+    /**
+     * @brief 换算到指定精度，只在能整除时成功
+     *
+     * @param size 目标精度
+     * @param out 换算结果
+     *
+     * @return true：精确换算；false：目标精度下无法精确表示
+     */
+    bool rescale(uint32 size, price_t &out) const
+    {
+        unsigned long long from = divisor(price_size);
+        unsigned long long to = divisor(size);
+        if (to % from == 0)
+        {
+            out = price_t(raw * (long long)(to / from), size);
+            return true;
+        }
+        if (from % to == 0 && raw % (long long)(from / to) == 0)
+        {
+            out = price_t(raw / (long long)(from / to), size);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 格式化为十进制字符串，精度为10的幂时按整数精确输出，否则按to_double()输出
+     *
+     * @return 写入的字符数（同snprintf）
+     */
+    int format(char *buf, int len) const
+    {
+        int digits = 0;
+        unsigned long long size = divisor(price_size);
+        while (size % 10 == 0)
+        {
+            size /= 10;
+            digits++;
+        }
+        if (size != 1)
+            return snprintf(buf, len, "%f", to_double());
+
+        unsigned long long pow10 = divisor(price_size);
+        unsigned long long mag = raw < 0 ? 0ULL - (unsigned long long)raw : (unsigned long long)raw;
+        if (digits == 0)
+            return snprintf(buf, len, "%s%llu", raw < 0 ? "-" : "", mag);
+        return snprintf(buf, len, "%s%llu.%0*llu", raw < 0 ? "-" : "", mag / pow10, digits, mag % pow10);
+    }
+
+private:
+    static unsigned long long divisor(uint32 size) { return size == 0 ? 1 : size; }
+
+    /**
+     * @brief 加减，精度不同时化为最小公倍数精度
+     */
+    price_t add(const price_t &other, int sign) const
+    {
+        if (price_size == other.price_size)
+            return price_t(raw + sign * other.raw, price_size);
+
+        unsigned long long a = divisor(price_size);
+        unsigned long long b = divisor(other.price_size);
+        unsigned long long x = a, y = b;
+        while (y != 0)
+        {
+            unsigned long long t = x % y;
+            x = y;
+            y = t;
+        }
+        unsigned long long lcm = a / x * b;
+        return price_t(raw * (long long)(lcm / a) + sign * other.raw * (long long)(lcm / b), (uint32)lcm);
+    }
+};
+
+#endif
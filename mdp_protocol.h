@@ -0,0 +1,129 @@
+#ifndef MDP_PROTOCOL_H_
+#define MDP_PROTOCOL_H_
+
+#include <memory.h>
+#include <arpa/inet.h>
+
+typedef unsigned char uint8;   //8位无符号整数
+typedef unsigned short uint16; //16位无符号整数
+typedef unsigned int uint32;   //32位无符号整数
+
+#define FIELD_VALUE_BIT 0x3FFFFFF
+
+/************* 协议定义 开始 *************/
+///<  消息类型定义
+#define	PACKAGE_INSTRUMENT_IDX		    0x05    ///< 合约索引
+#define	PACKAGE_INSTRUMENT_INIT		    0x06    ///< 初始行情
+#define	PACKAGE_INSTRUMENT		        0x10    ///< 单腿行情
+#define	PACKAGE_CMBTYPE	    		    0x11    ///< 组合行情
+#define	PACKAGE_BULLETINE				0x12    ///< 交易所告示
+#define	PACKAGE_QUOT_REQ		        0x13    ///< 报价请求
+#define	PACKAGE_TRADE_STATUS			0x14    ///< 交易状态
+#define	PACKAGE_DEPTH       			0x20    ///< 深度行情
+
+#define PKG_HEAD_LEN 4   ///< 报文头长度
+#define MSG_HEAD_LEN 2   ///< 消息头长度
+
+#pragma pack(push, 1)
+
+// 报文头
+typedef struct
+{
+    uint8 msg_type;   ///< 报文的类型，0x01-0xff
+    uint8 msg_num;    ///< 报文中消息个数，最大为255
+    uint16 pkg_len;   ///< 报文的长度，不包含4字节报头，高字节在前
+    char pkg_data[0]; ///< 数据正文
+} pkg_head_t;         ///< 报文头
+
+// 消息头
+typedef struct
+{
+    uint16 msg_len;   ///< 消息长度，不包含2字节消息头，高字节在前
+    char msg_data[0]; ///< 消息正文
+} msg_head_t;         ///< 消息头
+
+#pragma pack(pop)
+
+/************* 协议定义 结束 *************/
+
+
+/****** 工具函数 ******/
+
+/**
+ * @brief 调整字节序获取uint16数值
+ *
+ * @param tbuf 数据指针
+ *
+ * @return uint16数值
+ */
+static inline uint16 read_uint16(const char *tbuf)
+{
+    const unsigned char *buf = (const unsigned char *)tbuf;
+    return (buf[0] << 8) + buf[1];
+}
+
+/**
+ * @brief 调整字节序获取uint32数值
+ *
+ * @param tbuf 数据指针
+ *
+ * @return uint32数值
+ */
+static inline uint32 read_uint32(const char *tbuf)
+{
+    const unsigned char *buf = (const unsigned char *)tbuf;
+    return ((uint32)buf[0] << 24) + (buf[1] << 16) + (buf[2] << 8) + buf[3];
+}
+
+/**
+ * @brief 从给定buf中获取item索引及值
+ *
+ * @param p_buf 数据指针
+ * @param fld_idx 字段索引的引用
+ * @param value 字段对应数值
+ *
+ * @return 数据长度
+ */
+static inline int get_int_value(const char* p_buf, int &fld_idx, int &value)
+{
+    uint32 temp = 0;
+    memcpy(&temp, p_buf, 4);
+    temp = ntohl(temp);
+
+    int sign = temp >> 31;           // 符号位(B31)
+    fld_idx = (temp >> 26) & 0x1F;   // item索引(B30-B26)
+
+    value = temp & FIELD_VALUE_BIT;  // 数值部分(B25-B0)
+    value *= (0 == sign ? 1 : -1);
+
+    return 4;
+}
+
+/**
+ * @brief 从buf中解析深度行情数值
+ *
+ * @param p_buf 数据指针
+ * @param fld_idx 字段索引的引用
+ * @param price 价格的引用
+ * @param qty 定单手数的引用
+ * @param ord_cnt 定单个数的引用
+ *
+ * @return 数据长度
+ */
+static inline int get_dep_orderbook(const char* p_buf, int &fld_idx, int &price, int &qty, int &ord_cnt)
+{
+    // 获取价格(低位4字节的B0~B31)
+    get_int_value(p_buf, fld_idx, price);
+
+    // 获取委托量和订单个数（从高位4字节获取）
+    uint32 temp = 0;
+    memcpy(&temp, &p_buf[4], 4);
+    temp = ntohl(temp);
+
+    qty = temp >> 12;         // 委托量(B31-B12)
+    ord_cnt = temp & 0x0FFF;  // 订单个数(B11-B0)
+
+    return 8;
+}
+
+#endif
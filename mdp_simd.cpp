@@ -0,0 +1,250 @@
+#include "mdp_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MDP_SIMD_X86
+#endif
+
+typedef void (*int_values_fn_t)(const char *, int, int *, int *);
+typedef void (*dep_orderbooks_fn_t)(const char *, int, int *, int *, int *, int *);
+
+/****** 标量实现 ******/
+
+static void get_int_values_scalar(const char *p_buf, int count, int *fld_idx, int *value)
+{
+    for (int i = 0; i < count; i++)
+        get_int_value(p_buf + i * 4, fld_idx[i], value[i]);
+}
+
+static void get_dep_orderbooks_scalar(const char *p_buf, int count, int *fld_idx, int *price, int *qty, int *ord_cnt)
+{
+    for (int i = 0; i < count; i++)
+        get_dep_orderbook(p_buf + i * 8, fld_idx[i], price[i], qty[i], ord_cnt[i]);
+}
+
+#ifdef MDP_SIMD_X86
+
+/****** SSSE3实现，每次4个字 ******/
+
+/**
+ * @brief 拆分已转为主机字节序的字段字：索引(B30-B26)，数值(B25-B0)按符号位(B31)取负
+ */
+__attribute__((target("ssse3"), always_inline))
+static inline void unpack_words_sse(__m128i words, __m128i &idx, __m128i &val)
+{
+    __m128i sign = _mm_srai_epi32(words, 31);
+    __m128i mag = _mm_and_si128(words, _mm_set1_epi32(FIELD_VALUE_BIT));
+    idx = _mm_and_si128(_mm_srli_epi32(words, 26), _mm_set1_epi32(0x1F));
+    val = _mm_sub_epi32(_mm_xor_si128(mag, sign), sign);
+}
+
+/**
+ * @brief 解码4个4字节字段
+ *
+ * 强制内联，AVX2实现处理尾部时按VEX编码生成，避免与传统SSE指令混用时的状态切换开销
+ */
+__attribute__((target("ssse3"), always_inline))
+static inline void get_int_values_x4(const char *p_buf, int *fld_idx, int *value)
+{
+    const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    __m128i words = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p_buf), bswap);
+    __m128i idx, val;
+    unpack_words_sse(words, idx, val);
+    _mm_storeu_si128((__m128i *)fld_idx, idx);
+    _mm_storeu_si128((__m128i *)value, val);
+}
+
+/**
+ * @brief 解码4个8字节深度字段
+ */
+__attribute__((target("ssse3"), always_inline))
+static inline void get_dep_orderbooks_x4(const char *p_buf, int *fld_idx, int *price, int *qty, int *ord_cnt)
+{
+    const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    // 每个深度字段为价格字+数量字，4个字段拆成价格字和数量字两个向量
+    __m128 lo = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p_buf), bswap));
+    __m128 hi = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p_buf + 16)), bswap));
+    __m128i price_words = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i qty_words = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+
+    __m128i idx, val;
+    unpack_words_sse(price_words, idx, val);
+    _mm_storeu_si128((__m128i *)fld_idx, idx);
+    _mm_storeu_si128((__m128i *)price, val);
+
+    // 委托量(B31-B12)，订单个数(B11-B0)
+    _mm_storeu_si128((__m128i *)qty, _mm_srli_epi32(qty_words, 12));
+    _mm_storeu_si128((__m128i *)ord_cnt, _mm_and_si128(qty_words, _mm_set1_epi32(0x0FFF)));
+}
+
+__attribute__((target("ssse3")))
+static void get_int_values_sse(const char *p_buf, int count, int *fld_idx, int *value)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        get_int_values_x4(p_buf + i * 4, fld_idx + i, value + i);
+    get_int_values_scalar(p_buf + i * 4, count - i, fld_idx + i, value + i);
+}
+
+__attribute__((target("ssse3")))
+static void get_dep_orderbooks_sse(const char *p_buf, int count, int *fld_idx, int *price, int *qty, int *ord_cnt)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        get_dep_orderbooks_x4(p_buf + i * 8, fld_idx + i, price + i, qty + i, ord_cnt + i);
+    get_dep_orderbooks_scalar(p_buf + i * 8, count - i, fld_idx + i, price + i, qty + i, ord_cnt + i);
+}
+
+/****** AVX2实现，每次8个字 ******/
+
+__attribute__((target("avx2"), always_inline))
+static inline void unpack_words_avx2(__m256i words, __m256i &idx, __m256i &val)
+{
+    __m256i sign = _mm256_srai_epi32(words, 31);
+    __m256i mag = _mm256_and_si256(words, _mm256_set1_epi32(FIELD_VALUE_BIT));
+    idx = _mm256_and_si256(_mm256_srli_epi32(words, 26), _mm256_set1_epi32(0x1F));
+    val = _mm256_sub_epi32(_mm256_xor_si256(mag, sign), sign);
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i bswap_mask_avx2()
+{
+    return _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+}
+
+__attribute__((target("avx2")))
+static void get_int_values_avx2(const char *p_buf, int count, int *fld_idx, int *value)
+{
+    const __m256i bswap = bswap_mask_avx2();
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i words = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(p_buf + i * 4)), bswap);
+        __m256i idx, val;
+        unpack_words_avx2(words, idx, val);
+        _mm256_storeu_si256((__m256i *)(fld_idx + i), idx);
+        _mm256_storeu_si256((__m256i *)(value + i), val);
+    }
+    if (i + 4 <= count)
+    {
+        get_int_values_x4(p_buf + i * 4, fld_idx + i, value + i);
+        i += 4;
+    }
+    get_int_values_scalar(p_buf + i * 4, count - i, fld_idx + i, value + i);
+}
+
+__attribute__((target("avx2")))
+static void get_dep_orderbooks_avx2(const char *p_buf, int count, int *fld_idx, int *price, int *qty, int *ord_cnt)
+{
+    const __m256i bswap = bswap_mask_avx2();
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // shuffle_ps按128位通道拆分，结果为[0 1 4 5 | 2 3 6 7]，再按64位重排恢复顺序
+        __m256 lo = _mm256_castsi256_ps(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(p_buf + i * 8)), bswap));
+        __m256 hi = _mm256_castsi256_ps(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(p_buf + i * 8 + 32)), bswap));
+        __m256i price_words = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i qty_words = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m256i idx, val;
+        unpack_words_avx2(price_words, idx, val);
+        _mm256_storeu_si256((__m256i *)(fld_idx + i), idx);
+        _mm256_storeu_si256((__m256i *)(price + i), val);
+
+        _mm256_storeu_si256((__m256i *)(qty + i), _mm256_srli_epi32(qty_words, 12));
+        _mm256_storeu_si256((__m256i *)(ord_cnt + i), _mm256_and_si256(qty_words, _mm256_set1_epi32(0x0FFF)));
+    }
+    if (i + 4 <= count)
+    {
+        get_dep_orderbooks_x4(p_buf + i * 8, fld_idx + i, price + i, qty + i, ord_cnt + i);
+        i += 4;
+    }
+    get_dep_orderbooks_scalar(p_buf + i * 8, count - i, fld_idx + i, price + i, qty + i, ord_cnt + i);
+}
+
+#endif
+
+/****** 运行时选择 ******/
+
+/**
+ * @brief CPU支持的最高级别
+ */
+static mdp_simd_level_t detect_simd_level()
+{
+#ifdef MDP_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return MDP_SIMD_AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return MDP_SIMD_SSE;
+#endif
+    return MDP_SIMD_SCALAR;
+}
+
+static mdp_simd_level_t s_level = MDP_SIMD_SCALAR;
+static int_values_fn_t s_int_values = get_int_values_scalar;
+static dep_orderbooks_fn_t s_dep_orderbooks = get_dep_orderbooks_scalar;
+
+// 程序启动时选择CPU支持的最高级别
+static mdp_simd_level_t s_init_level = set_simd_level(MDP_SIMD_AVX2);
+
+void get_int_values(const char *p_buf, int count, int *fld_idx, int *value)
+{
+    s_int_values(p_buf, count, fld_idx, value);
+}
+
+void get_dep_orderbooks(const char *p_buf, int count, int *fld_idx, int *price, int *qty, int *ord_cnt)
+{
+    s_dep_orderbooks(p_buf, count, fld_idx, price, qty, ord_cnt);
+}
+
+mdp_simd_level_t get_simd_level()
+{
+    return s_level;
+}
+
+mdp_simd_level_t set_simd_level(mdp_simd_level_t level)
+{
+    mdp_simd_level_t supported = detect_simd_level();
+    if (level > supported)
+        level = supported;
+
+    switch (level)
+    {
+#ifdef MDP_SIMD_X86
+    case MDP_SIMD_AVX2:
+        s_int_values = get_int_values_avx2;
+        s_dep_orderbooks = get_dep_orderbooks_avx2;
+        break;
+    case MDP_SIMD_SSE:
+        s_int_values = get_int_values_sse;
+        s_dep_orderbooks = get_dep_orderbooks_sse;
+        break;
+#endif
+    default:
+        level = MDP_SIMD_SCALAR;
+        s_int_values = get_int_values_scalar;
+        s_dep_orderbooks = get_dep_orderbooks_scalar;
+        break;
+    }
+
+    s_level = level;
+    return level;
+}
+
+const char *get_simd_name(mdp_simd_level_t level)
+{
+    switch (level)
+    {
+    case MDP_SIMD_AVX2:  return "avx2";
+    case MDP_SIMD_SSE:   return "sse";
+    default:             return "scalar";
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MDP_SIMD_H_
+#define MDP_SIMD_H_
+
+#include "mdp_protocol.h"
+
+/**
+ * @brief 批量字段解码使用的指令集
+ */
+enum mdp_simd_level_t
+{
+    MDP_SIMD_SCALAR = 0,  ///< 逐个字段调用get_int_value()/get_dep_orderbook()
+    MDP_SIMD_SSE = 1,     ///< SSSE3，每次4个字（pshufb字节序转换）
+    MDP_SIMD_AVX2 = 2     ///< AVX2，每次8个字
+};
+
+/**
+ * @brief 批量解码连续的4字节字段，结果与逐个调用get_int_value()一致
+ *
+ * 首次调用时按CPU支持的指令集选择实现（AVX2 > SSSE3 > 标量），
+ * 输入不要求对齐，尾部不足一个向量的字段走标量路径。
+ *
+ * @param p_buf 第一个字段位置
+ * @param count 字段个数，调用方保证p_buf之后有count*4字节
+ * @param fld_idx 字段索引输出数组，至少count个
+ * @param value 字段值输出数组，至少count个
+ */
+void get_int_values(const char *p_buf, int count, int *fld_idx, int *value);
+
+/**
+ * @brief 批量解码连续的8字节深度字段，结果与逐个调用get_dep_orderbook()一致
+ *
+ * @param p_buf 第一个字段位置
+ * @param count 字段个数，调用方保证p_buf之后有count*8字节
+ * @param fld_idx 档位字段索引输出数组
+ * @param price 价格输出数组
+ * @param qty 委托量输出数组
+ * @param ord_cnt 订单个数输出数组
+ */
+void get_dep_orderbooks(const char *p_buf, int count, int *fld_idx, int *price, int *qty, int *ord_cnt);
+
+/**
+ * @brief 当前使用的指令集
+ */
+mdp_simd_level_t get_simd_level();
+
+/**
+ * @brief 指定指令集，超出CPU支持范围时降为支持的最高级别，用于测试和性能对比
+ *
+ * @return 实际使用的指令集
+ */
+mdp_simd_level_t set_simd_level(mdp_simd_level_t level);
+
+/**
+ * @brief 指令集名称
+ */
+const char *get_simd_name(mdp_simd_level_t level);
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef MDP_VIEW_H_
+#define MDP_VIEW_H_
+
+#include "mdp_protocol.h"
+
+/**
+ * 直接建立在接收缓冲区上的只读视图，不拷贝数据，可用于range-for：
+ *
+ *     mdp_datagram_view_t dgram(buf, len);
+ *     for (const mdp_pkg_view_t &pkg : dgram)
+ *     {
+ *         for (const mdp_msg_view_t &msg : pkg)
+ *         {
+ *             for (mdp_field_t fld : msg.fields(4))
+ *                 ...
+ *         }
+ *         if (dgram.malformed())
+ *             break;
+ *     }
+ *
+ * 报文头、消息头和长度在迭代时检查，越界时迭代提前结束并置位malformed()，
+ * 字段迭代只覆盖消息内完整的字段，末尾不足一个字段的字节被忽略。
+ * 视图只在缓冲区有效期内可用。
+ */
+
+/**
+ * @brief 4字节字段(fld_idx, value)
+ */
+struct mdp_field_t
+{
+    enum { size = 4 };  ///< 编码长度
+
+    int fld_idx;  ///< 字段索引
+    int value;    ///< 字段值
+
+    static mdp_field_t read(const char *p_buf)
+    {
+        mdp_field_t fld;
+        get_int_value(p_buf, fld.fld_idx, fld.value);
+        return fld;
+    }
+};
+
+/**
+ * @brief 8字节深度字段(fld_idx, price, qty, ord_cnt)
+ */
+struct mdp_depth_field_t
+{
+    enum { size = 8 };  ///< 编码长度
+
+    int fld_idx;  ///< 档位字段索引
+    int price;    ///< 价格
+    int qty;      ///< 委托量
+    int ord_cnt;  ///< 订单个数
+
+    static mdp_depth_field_t read(const char *p_buf)
+    {
+        mdp_depth_field_t fld;
+        get_dep_orderbook(p_buf, fld.fld_idx, fld.price, fld.qty, fld.ord_cnt);
+        return fld;
+    }
+};
+
+/**
+ * @brief 字段迭代器，field_t为mdp_field_t或mdp_depth_field_t
+ */
+template <typename field_t>
+class mdp_field_iter_t
+{
+public:
+    explicit mdp_field_iter_t(const char *pos) : m_pos(pos) {}
+
+    field_t operator*() const { return field_t::read(m_pos); }
+    mdp_field_iter_t &operator++() { m_pos += field_t::size; return *this; }
+    bool operator==(const mdp_field_iter_t &other) const { return m_pos == other.m_pos; }
+    bool operator!=(const mdp_field_iter_t &other) const { return m_pos != other.m_pos; }
+
+private:
+    const char *m_pos;  ///< 当前字段位置
+};
+
+/**
+ * @brief 消息体中连续排列的字段
+ */
+template <typename field_t>
+class mdp_field_range_t
+{
+public:
+    typedef mdp_field_iter_t<field_t> iterator;
+
+    /**
+     * @param data 第一个字段的位置
+     * @param len 字段区长度，不足一个字段的尾部被忽略，小于等于0时为空
+     */
+    mdp_field_range_t(const char *data, int len)
+        : m_begin(data), m_end(data + (len > 0 ? len / field_t::size * field_t::size : 0))
+    {
+    }
+
+    iterator begin() const { return iterator(m_begin); }
+    iterator end() const { return iterator(m_end); }
+
+    /**
+     * @brief 字段个数
+     */
+    int size() const { return (int)(m_end - m_begin) / field_t::size; }
+
+private:
+    const char *m_begin;  ///< 第一个字段
+    const char *m_end;    ///< 最后一个完整字段之后
+};
+
+/**
+ * @brief 消息视图，不含2字节消息头
+ */
+class mdp_msg_view_t
+{
+public:
+    mdp_msg_view_t(const char *data, uint16 len) : m_data(data), m_len(len) {}
+
+    /**
+     * @brief 消息体
+     */
+    const char *data() const { return m_data; }
+
+    /**
+     * @brief 消息体长度
+     */
+    uint16 len() const { return m_len; }
+
+    /**
+     * @brief 读取消息体pos处的uint16/uint32，调用方保证pos在消息体内（见解码器中的最小长度检查）
+     */
+    uint16 read_u16(int pos) const { return read_uint16(m_data + pos); }
+    uint32 read_u32(int pos) const { return read_uint32(m_data + pos); }
+
+    /**
+     * @brief 从pos开始的4字节字段
+     */
+    mdp_field_range_t<mdp_field_t> fields(int pos) const
+    {
+        return mdp_field_range_t<mdp_field_t>(m_data + pos, m_len - pos);
+    }
+
+    /**
+     * @brief 从pos开始的8字节深度字段
+     */
+    mdp_field_range_t<mdp_depth_field_t> depth_fields(int pos) const
+    {
+        return mdp_field_range_t<mdp_depth_field_t>(m_data + pos, m_len - pos);
+    }
+
+private:
+    const char *m_data;  ///< 消息体
+    uint16 m_len;        ///< 消息体长度
+};
+
+/**
+ * @brief 报文内的消息迭代器，最多迭代msg_num个消息
+ */
+class mdp_msg_iter_t
+{
+public:
+    /**
+     * @param pos 第一个消息头位置，NULL为结束迭代器
+     * @param end 报文结束位置
+     * @param msg_num 报文头中的消息个数
+     * @param bad 格式错误标志，消息头或长度越界时置true
+     */
+    mdp_msg_iter_t(const char *pos, const char *end, int msg_num, bool *bad)
+        : m_pos(pos), m_end(end), m_left(msg_num), m_bad(bad), m_msg(NULL, 0)
+    {
+        load();
+    }
+
+    const mdp_msg_view_t &operator*() const { return m_msg; }
+    const mdp_msg_view_t *operator->() const { return &m_msg; }
+
+    mdp_msg_iter_t &operator++()
+    {
+        m_pos = m_msg.data() + m_msg.len();
+        m_left--;
+        load();
+        return *this;
+    }
+
+    bool operator==(const mdp_msg_iter_t &other) const { return m_pos == other.m_pos; }
+    bool operator!=(const mdp_msg_iter_t &other) const { return m_pos != other.m_pos; }
+
+private:
+    /**
+     * @brief 解析当前位置的消息头，消息个数用完或到达报文末尾时结束
+     */
+    void load()
+    {
+        if (m_pos == NULL)
+            return;
+
+        if (m_left <= 0 || m_pos >= m_end)
+        {
+            m_pos = NULL;
+            return;
+        }
+
+        // 消息头和消息长度必须落在报文内
+        int msg_total = m_end - m_pos >= MSG_HEAD_LEN ? read_uint16(m_pos) : 0;
+        if (msg_total < MSG_HEAD_LEN || msg_total > m_end - m_pos)
+        {
+            *m_bad = true;
+            m_pos = NULL;
+            return;
+        }
+
+        m_msg = mdp_msg_view_t(m_pos + MSG_HEAD_LEN, msg_total - MSG_HEAD_LEN);
+    }
+
+private:
+    const char *m_pos;      ///< 当前消息头，NULL表示结束
+    const char *m_end;      ///< 报文结束位置
+    int m_left;             ///< 剩余消息个数（含当前）
+    bool *m_bad;            ///< 格式错误标志
+    mdp_msg_view_t m_msg;   ///< 当前消息
+};
+
+/**
+ * @brief 报文视图，由mdp_datagram_view_t迭代得到
+ */
+class mdp_pkg_view_t
+{
+public:
+    typedef mdp_msg_iter_t iterator;
+
+    mdp_pkg_view_t(const pkg_head_t *head, bool *bad) : m_head(head), m_bad(bad) {}
+
+    /**
+     * @brief 报文类型
+     */
+    uint8 type() const { return m_head->msg_type; }
+
+    /**
+     * @brief 报文头中的消息个数
+     */
+    int msg_num() const { return m_head->msg_num; }
+
+    /**
+     * @brief 报文正文长度，不含报文头
+     */
+    int len() const { return read_uint16((const char *)&m_head->pkg_len); }
+
+    /**
+     * @brief 报文正文
+     */
+    const char *data() const { return m_head->pkg_data; }
+
+    iterator begin() const { return iterator(data(), data() + len(), msg_num(), m_bad); }
+    iterator end() const { return iterator(NULL, NULL, 0, m_bad); }
+
+private:
+    const pkg_head_t *m_head;  ///< 报文头
+    bool *m_bad;               ///< 所属UDP包的格式错误标志
+};
+
+/**
+ * @brief UDP包内的报文迭代器
+ */
+class mdp_pkg_iter_t
+{
+public:
+    /**
+     * @param pos 当前报文头位置，NULL为结束迭代器
+     * @param end UDP包结束位置
+     * @param bad 格式错误标志，报文头或长度越界时置true
+     */
+    mdp_pkg_iter_t(const char *pos, const char *end, bool *bad)
+        : m_pos(pos), m_end(end), m_bad(bad), m_pkg(NULL, bad)
+    {
+        load();
+    }
+
+    const mdp_pkg_view_t &operator*() const { return m_pkg; }
+    const mdp_pkg_view_t *operator->() const { return &m_pkg; }
+
+    mdp_pkg_iter_t &operator++()
+    {
+        m_pos = m_pkg.data() + m_pkg.len();
+        load();
+        return *this;
+    }
+
+    bool operator==(const mdp_pkg_iter_t &other) const { return m_pos == other.m_pos; }
+    bool operator!=(const mdp_pkg_iter_t &other) const { return m_pos != other.m_pos; }
+
+private:
+    /**
+     * @brief 解析当前位置的报文头，到达UDP包末尾或已发现格式错误时结束
+     */
+    void load()
+    {
+        if (m_pos == NULL)
+            return;
+
+        if (m_pos >= m_end || *m_bad)
+        {
+            m_pos = NULL;
+            return;
+        }
+
+        // 报文头和报文长度必须落在UDP包内
+        if (m_end - m_pos < PKG_HEAD_LEN
+                || read_uint16(m_pos + 2) > m_end - m_pos - PKG_HEAD_LEN)
+        {
+            *m_bad = true;
+            m_pos = NULL;
+            return;
+        }
+
+        m_pkg = mdp_pkg_view_t((const pkg_head_t *)m_pos, m_bad);
+    }
+
+private:
+    const char *m_pos;      ///< 当前报文头，NULL表示结束
+    const char *m_end;      ///< UDP包结束位置
+    bool *m_bad;            ///< 格式错误标志
+    mdp_pkg_view_t m_pkg;   ///< 当前报文
+};
+
+/**
+ * @brief UDP包视图，一个UDP包可能含有多个报文
+ */
+class mdp_datagram_view_t
+{
+public:
+    typedef mdp_pkg_iter_t iterator;
+
+    mdp_datagram_view_t(const char *buf, int len) : m_buf(buf), m_len(len), m_bad(false) {}
+
+    iterator begin() { m_bad = false; return iterator(m_buf, m_buf + m_len, &m_bad); }
+    iterator end() { return iterator(NULL, NULL, &m_bad); }
+
+    /**
+     * @brief 迭代过程中是否发现报文头、消息头或长度越界，发现后其后的数据不再迭代
+     */
+    bool malformed() const { return m_bad; }
+
+private:
+    const char *m_buf;  ///< UDP包
+    int m_len;          ///< UDP包长度
+    bool m_bad;         ///< 格式错误标志
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "order_book.h"
+
+book_table_t::book_table_t()
+{
+    m_books = NULL;
+    m_own_mem = false;
+    m_trade_date = 0;
+}
+
+book_table_t::~book_table_t()
+{
+    if (m_books != NULL && m_own_mem)
+        munmap(m_books, mem_size());
+}
+
+int book_table_t::init()
+{
+    if (m_books != NULL)
+    {
+        printf("order book table has been initialized!\n");
+        return -1;
+    }
+
+    // 匿名映射内存初始为0，MAP_POPULATE预先建立页表，避免行情到来时缺页
+    void *mem = mmap(NULL, mem_size(), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap order book table");
+        return -1;
+    }
+
+    m_books = (book_slot_t *)mem;
+    m_own_mem = true;
+    return 0;
+}
+
+int book_table_t::init(void *mem)
+{
+    if (m_books != NULL || mem == NULL)
+    {
+        printf("order book table has been initialized or memory is null!\n");
+        return -1;
+    }
+
+    m_books = (book_slot_t *)mem;
+    m_own_mem = false;
+    return 0;
+}
+
+void book_table_t::clear()
+{
+    // 表可能在共享内存中被其他进程读取，逐个经顺序锁清空，不能整体memset把序号归零
+    for (int i = 0; i < INS_TABLE_SIZE; i++)
+        m_books[i].book.reset();
+}
+
+void book_table_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    // 交易日切换后合约索引重新编排，旧盘口全部作废
+    if (ev.msg_idx == 0 && ev.trade_date != m_trade_date)
+    {
+        if (m_trade_date != 0)
+            clear();
+        m_trade_date = ev.trade_date;
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef ORDER_BOOK_H_
+#define ORDER_BOOK_H_
+
+#include "ins_table.h"
+
+/**
+ * @brief 五档盘口，买卖两侧的价格、委托量、订单个数分别连续存放
+ */
+struct order_book_t
+{
+    uint16 price_size;                  ///< 价格精度
+
+    int bid_price[DEPTH_LEVEL_NUM];     ///< 买一~买五价格
+    int bid_qty[DEPTH_LEVEL_NUM];       ///< 买一~买五委托量
+    int bid_ord_cnt[DEPTH_LEVEL_NUM];   ///< 买一~买五订单个数
+
+    int ask_price[DEPTH_LEVEL_NUM];     ///< 卖一~卖五价格
+    int ask_qty[DEPTH_LEVEL_NUM];       ///< 卖一~卖五委托量
+    int ask_ord_cnt[DEPTH_LEVEL_NUM];   ///< 卖一~卖五订单个数
+
+    price_t bid(int level) const { return price_t(bid_price[level], price_size); }
+    price_t ask(int level) const { return price_t(ask_price[level], price_size); }
+};
+
+/**
+ * @brief 顺序锁保护的盘口，连同序号恰好占两个缓存行
+ */
+struct alignas(CACHE_LINE_SIZE) book_slot_t
+{
+    seqlock_t<order_book_t> book;
+};
+
+/**
+ * @brief 最优买卖价
+ */
+struct book_top_t
+{
+    uint16 price_size;  ///< 价格精度
+    int bid_price;      ///< 买一价
+    int bid_qty;        ///< 买一量
+    int ask_price;      ///< 卖一价
+    int ask_qty;        ///< 卖一量
+
+    price_t bid() const { return price_t(bid_price, price_size); }
+    price_t ask() const { return price_t(ask_price, price_size); }
+};
+
+/**
+ * @brief 五档盘口表
+ *
+ * 以ins_idx为下标的定长数组，作为解码器处理器使用：每条深度消息按字段索引
+ * 1~10原地更新对应档位，未出现的档位保持不变。表只应由一个解码线程写入；
+ * 每个盘口由顺序锁保护，get_top()/get_depth()可在任意线程调用，读到的总是
+ * 某条深度消息处理完毕后的完整盘口，写线程从不等待读者。
+ */
+class book_table_t : public mdp_null_handler_t
+{
+public:
+    book_table_t();
+    ~book_table_t();
+
+    /**
+     * @brief 分配并预先映射表内存
+     *
+     * @return 0：成功；-1：失败
+     */
+    int init();
+
+    /**
+     * @brief 使用外部内存（如共享内存）作为表存储，内存由调用方释放
+     *
+     * @param mem 至少mem_size()字节、按缓存行对齐且初始为0的内存
+     *
+     * @return 0：成功；-1：失败
+     */
+    int init(void *mem);
+
+    /**
+     * @brief 表存储所需的内存大小
+     */
+    static size_t mem_size() { return sizeof(book_slot_t) * INS_TABLE_SIZE; }
+
+    /**
+     * @brief 清空所有盘口，逐个经顺序锁写入，其他线程或进程可同时读取
+     */
+    void clear();
+
+    /**
+     * @brief 获取合约盘口，不加保护地访问数据只限写线程自身
+     *
+     * @param ins_idx 合约索引
+     */
+    const order_book_t &get(uint16 ins_idx) const { return m_books[ins_idx].book.data(); }
+
+    /**
+     * @brief 读取最优买卖价的一致快照，可在任意线程调用
+     *
+     * @param ins_idx 合约索引
+     * @param top 输出的最优买卖价
+     *
+     * @return 已处理的深度消息数，0表示尚无盘口
+     */
+    uint32 get_top(uint16 ins_idx, book_top_t &top) const
+    {
+        uint32 seq = m_books[ins_idx].book.read_with([&top](const order_book_t &book)
+        {
+            top.price_size = book.price_size;
+            top.bid_price = book.bid_price[0];
+            top.bid_qty = book.bid_qty[0];
+            top.ask_price = book.ask_price[0];
+            top.ask_qty = book.ask_qty[0];
+        });
+        return seq / 2;
+    }
+
+    /**
+     * @brief 复制完整五档盘口的一致快照，可在任意线程调用
+     *
+     * @param ins_idx 合约索引
+     * @param book 输出的盘口
+     *
+     * @return 已处理的深度消息数，0表示尚无盘口
+     */
+    uint32 get_depth(uint16 ins_idx, order_book_t &book) const
+    {
+        return m_books[ins_idx].book.read_with([&book](const order_book_t &data) { book = data; }) / 2;
+    }
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+
+    void on_depth(const mdp_depth_event_t &ev)
+    {
+        seqlock_t<order_book_t> &lock = m_books[ev.ins_idx].book;
+        apply_depth(lock.begin_write(), ev);
+        lock.end_write();
+    }
+
+    /**
+     * @brief 将深度消息中出现的档位写入盘口
+     */
+    static void apply_depth(order_book_t &book, const mdp_depth_event_t &ev)
+    {
+        // 只处理买一~卖五对应的字段1~10
+        uint32 mask = ev.mask & (((1u << (DEPTH_LEVEL_NUM * 2)) - 1) << 1);
+        while (mask != 0)
+        {
+            int fld_idx = __builtin_ctz(mask);
+            int level = (fld_idx - 1) >> 1;
+            const mdp_depth_entry_t &entry = ev.entry[fld_idx];
+
+            if (fld_idx & 1)
+            {
+                book.bid_price[level] = entry.price;
+                book.bid_qty[level] = entry.qty;
+                book.bid_ord_cnt[level] = entry.ord_cnt;
+            }
+            else
+            {
+                book.ask_price[level] = entry.price;
+                book.ask_qty[level] = entry.qty;
+                book.ask_ord_cnt[level] = entry.ord_cnt;
+            }
+            mask &= mask - 1;
+        }
+
+        book.price_size = ev.price_size;
+    }
+
+private:
+    book_slot_t *m_books;     ///< 盘口数组，共INS_TABLE_SIZE项
+    bool m_own_mem;           ///< 表内存是否由本对象分配
+    uint32 m_trade_date;      ///< 当前交易日
+};
+
+#endif
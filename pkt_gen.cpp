@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pkt_gen.h"
+
+static const char *s_products[] = {"SR", "CF", "TA", "MA", "RM", "OI", "FG", "SA", "UR", "AP", "PK", "SF", "SM", "ZC"};
+
+pkt_gen_t::pkt_gen_t(uint64_t seed, int ins_num)
+{
+    m_state = seed == 0 ? 0x9E3779B97F4A7C15ULL : seed;
+    m_ins_num = ins_num < 1 ? 1 : (ins_num > PKT_GEN_MAX_INS ? PKT_GEN_MAX_INS : ins_num);
+    m_next_ins = 0;
+    m_trade_date = 20241016;
+    m_seq = 0;
+
+    memset(m_ins, 0, sizeof(m_ins));
+    int product_num = sizeof(s_products) / sizeof(s_products[0]);
+    for (int i = 0; i < m_ins_num; i++)
+    {
+        ins_state_t &ins = m_ins[i];
+        const char *product = s_products[i % product_num];
+        int month = 501 + (i / product_num) % 12;
+
+        // 前面为期货，其余为期权
+        if (i < product_num * 12)
+        {
+            snprintf(ins.ins_id, sizeof(ins.ins_id), "%s%d", product, month);
+            ins.ins_type = 1;
+        }
+        else
+        {
+            snprintf(ins.ins_id, sizeof(ins.ins_id), "%s%d%c%d", product, month,
+                    (i & 1) ? 'C' : 'P', 1000 + (i % 50) * 100);
+            ins.ins_type = 2;
+        }
+
+        ins.last = next_range(1000, 20000) * 100;
+        ins.time_sec = 90000;
+    }
+}
+
+uint32 pkt_gen_t::next()
+{
+    // xorshift64*
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return (uint32)((m_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+int pkt_gen_t::put_field(char *buf, int fld_idx, int value)
+{
+    uint32 sign = value < 0 ? 1 : 0;
+    uint32 abs_value = value < 0 ? -value : value;
+    uint32 word = htonl((sign << 31) | ((uint32)fld_idx << 26) | (abs_value & FIELD_VALUE_BIT));
+    memcpy(buf, &word, 4);
+    return 4;
+}
+
+int pkt_gen_t::put_depth(char *buf, int fld_idx, int price, int qty, int ord_cnt)
+{
+    put_field(buf, fld_idx, price);
+    uint32 word = htonl(((uint32)qty << 12) | (ord_cnt & 0x0FFF));
+    memcpy(buf + 4, &word, 4);
+    return 8;
+}
+
+static int put_uint16(char *buf, uint16 value)
+{
+    buf[0] = value >> 8;
+    buf[1] = value & 0xFF;
+    return 2;
+}
+
+static int put_uint32(char *buf, uint32 value)
+{
+    put_uint16(buf, value >> 16);
+    put_uint16(buf + 2, value & 0xFFFF);
+    return 4;
+}
+
+/**
+ * @brief HHMMSS加一秒，逐级进位，过235959回到000000
+ */
+static int next_second(int hhmmss)
+{
+    int hour = hhmmss / 10000, minute = hhmmss / 100 % 100, second = hhmmss % 100 + 1;
+    if (second == 60)
+    {
+        second = 0;
+        if (++minute == 60)
+        {
+            minute = 0;
+            if (++hour == 24)
+                hour = 0;
+        }
+    }
+    return hour * 10000 + minute * 100 + second;
+}
+
+int pkt_gen_t::build_msg(char *buf, uint8 msg_type, int msg_idx, int ins_idx)
+{
+    ins_state_t &ins = m_ins[ins_idx];
+    int pos = 0;
+
+    switch (msg_type)
+    {
+    case PACKAGE_INSTRUMENT_IDX:
+    {
+        if (msg_idx == 0)
+            pos += put_uint32(buf + pos, m_trade_date);
+        buf[pos++] = ins.ins_type;
+        pos += put_uint16(buf + pos, ins_idx);
+        int id_len = strlen(ins.ins_id);
+        memcpy(buf + pos, ins.ins_id, id_len);
+        pos += id_len;
+        break;
+    }
+    case PACKAGE_INSTRUMENT_INIT:
+        pos += put_uint16(buf + pos, 100);
+        pos += put_uint16(buf + pos, ins_idx);
+        pos += put_field(buf + pos, INIT_FLD_LAST_CLOSE, ins.last);
+        pos += put_field(buf + pos, INIT_FLD_LAST_CLEAR, ins.last);
+        pos += put_field(buf + pos, INIT_FLD_LAST_HOLDING, next_range(0, 500000));
+        pos += put_field(buf + pos, INIT_FLD_LIMIT_UP, ins.last + ins.last / 10);
+        pos += put_field(buf + pos, INIT_FLD_LIMIT_DOWN, ins.last - ins.last / 10);
+        break;
+    case PACKAGE_INSTRUMENT:
+    {
+        // 价格随机游走，时间递增，成交量和成交金额累加
+        ins.last += next_range(-5, 5) * 100;
+        if (ins.last < 100)
+            ins.last = 100;
+        int qty = next_range(0, 20);
+        ins.volume += qty;
+        ins.trade_val += (long long)qty * ins.last * 10;
+        ins.time_usec += next_range(1000, 500000);
+        if (ins.time_usec >= 1000000)
+        {
+            ins.time_usec -= 1000000;
+            ins.time_sec = next_second(ins.time_sec);
+        }
+
+        pos += put_uint16(buf + pos, 100);
+        pos += put_uint16(buf + pos, ins_idx);
+        pos += put_field(buf + pos, TICK_FLD_LAST, ins.last);
+        pos += put_field(buf + pos, 5, ins.last - 100);                     // 买价
+        pos += put_field(buf + pos, 6, ins.last + 100);                     // 卖价
+        pos += put_field(buf + pos, 7, next_range(1, 500));                 // 买量
+        pos += put_field(buf + pos, 8, next_range(1, 500));                 // 卖量
+        pos += put_field(buf + pos, TICK_FLD_VOLUME, ins.volume);
+        pos += put_field(buf + pos, 10, next_range(10000, 500000));         // 持仓量
+        if ((next() & 3) == 0)
+            pos += put_field(buf + pos, TICK_FLD_HIGH, ins.last + 200);
+        if ((next() & 3) == 0)
+            pos += put_field(buf + pos, TICK_FLD_LOW, ins.last - 200);
+        pos += put_field(buf + pos, TICK_FLD_TIME_SEC, ins.time_sec);
+        pos += put_field(buf + pos, TICK_FLD_TIME_USEC, ins.time_usec);
+        pos += put_field(buf + pos, TICK_FLD_TRADE_VAL1, (int)((ins.trade_val >> 26) & FIELD_VALUE_BIT));
+        pos += put_field(buf + pos, TICK_FLD_TRADE_VAL2, (int)(ins.trade_val & FIELD_VALUE_BIT));
+        break;
+    }
+    case PACKAGE_CMBTYPE:
+        pos += put_uint16(buf + pos, 100);
+        pos += put_uint16(buf + pos, ins_idx);
+        pos += put_field(buf + pos, CMB_FLD_BID, next_range(-500, 500) * 100);
+        pos += put_field(buf + pos, CMB_FLD_ASK, next_range(-500, 500) * 100);
+        pos += put_field(buf + pos, CMB_FLD_BID_LOT, next_range(1, 100));
+        pos += put_field(buf + pos, CMB_FLD_ASK_LOT, next_range(1, 100));
+        pos += put_field(buf + pos, CMB_FLD_TIME_SEC, ins.time_sec);
+        pos += put_field(buf + pos, CMB_FLD_TIME_USEC, ins.time_usec);
+        break;
+    case PACKAGE_BULLETINE:
+    {
+        static const char text[] = "Exchange bulletin: trading hours unchanged.";
+        pos += put_uint16(buf + pos, 0);
+        pos += put_uint16(buf + pos, m_seq++);
+        memcpy(buf + pos, text, sizeof(text));
+        pos += sizeof(text);
+        break;
+    }
+    case PACKAGE_QUOT_REQ:
+        pos += put_uint16(buf + pos, 0);
+        pos += put_uint16(buf + pos, ins_idx);
+        pos += put_field(buf + pos, 1, m_trade_date);
+        pos += put_field(buf + pos, 2, m_seq++);
+        buf[pos++] = next() % 3;
+        buf[pos++] = next() % 2;
+        break;
+    case PACKAGE_TRADE_STATUS:
+        buf[pos++] = next() % 8;
+        break;
+    case PACKAGE_DEPTH:
+    {
+        pos += put_uint16(buf + pos, 100);
+        pos += put_uint16(buf + pos, ins_idx);
+
+        // 多数更新只涉及前几档
+        int levels = (next() & 1) ? DEPTH_LEVEL_NUM : next_range(1, DEPTH_LEVEL_NUM);
+        for (int level = 0; level < levels; level++)
+        {
+            pos += put_depth(buf + pos, DEPTH_FLD_BID(level), ins.last - (level + 1) * 100,
+                    next_range(1, 2000), next_range(1, 50));
+            pos += put_depth(buf + pos, DEPTH_FLD_ASK(level), ins.last + (level + 1) * 100,
+                    next_range(1, 2000), next_range(1, 50));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return pos;
+}
+
+int pkt_gen_t::build_datagram(char *buf, int buf_len, uint8 msg_type, int pkg_num, int msg_num)
+{
+    char msg_buf[1024];
+    int offset = 0;
+
+    for (int p = 0; p < pkg_num; p++)
+    {
+        int pkg_start = offset;
+        int pkg_pos = offset + PKG_HEAD_LEN;
+        int count = 0;
+
+        for (int m = 0; m < msg_num && m < 255; m++)
+        {
+            int ins_idx = m_next_ins;
+            m_next_ins = (m_next_ins + 1) % m_ins_num;
+
+            int msg_len = build_msg(msg_buf, msg_type, m, ins_idx);
+            if (pkg_pos + MSG_HEAD_LEN + msg_len > buf_len)
+                break;
+
+            put_uint16(buf + pkg_pos, msg_len + MSG_HEAD_LEN);
+            memcpy(buf + pkg_pos + MSG_HEAD_LEN, msg_buf, msg_len);
+            pkg_pos += MSG_HEAD_LEN + msg_len;
+            count++;
+        }
+
+        if (count == 0)
+            break;
+
+        buf[pkg_start] = msg_type;
+        buf[pkg_start + 1] = count;
+        put_uint16(buf + pkg_start + 2, pkg_pos - pkg_start - PKG_HEAD_LEN);
+        offset = pkg_pos;
+    }
+
+    return offset;
+}
+
+int pkt_gen_t::build_mixed(char *buf, int buf_len, int ins_per_pkg)
+{
+    // 单腿行情和深度行情使用同一组合约
+    int start_ins = m_next_ins;
+    int len = build_datagram(buf, buf_len, PACKAGE_INSTRUMENT, 1, ins_per_pkg);
+    m_next_ins = start_ins;
+    len += build_datagram(buf + len, buf_len - len, PACKAGE_DEPTH, 1, ins_per_pkg);
+    return len;
+}
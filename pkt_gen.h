@@ -0,0 +1,104 @@
+#ifndef PKT_GEN_H_
+#define PKT_GEN_H_
+
+#include <stdint.h>
+
+#include "mdp_event.h"
+
+#define PKT_GEN_MAX_INS     4096    ///< 最多模拟的合约个数
+
+/**
+ * @brief 模拟行情报文生成器
+ *
+ * 按协议格式生成各类报文（0x05/0x06/0x10/0x11/0x12/0x13/0x14/0x20），
+ * 价格在基准价附近随机游走，成交量单调递增。随机数序列只由种子决定，
+ * 相同种子在任何机器上生成完全相同的报文，便于性能对比和回归测试。
+ */
+class pkt_gen_t
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param seed 随机种子
+     * @param ins_num 模拟的合约个数，合约索引为0 ~ ins_num-1
+     */
+    pkt_gen_t(uint64_t seed, int ins_num = 500);
+
+    /**
+     * @brief 生成一个UDP包
+     *
+     * @param buf 输出缓冲区
+     * @param buf_len 缓冲区长度
+     * @param msg_type 报文类型，PACKAGE_*
+     * @param pkg_num UDP包中的报文个数
+     * @param msg_num 每个报文中的消息个数（合约索引报文的交易日只在首个消息中）
+     *
+     * @return 生成的数据长度，缓冲区不足时返回已写入的完整报文长度
+     */
+    int build_datagram(char *buf, int buf_len, uint8 msg_type, int pkg_num, int msg_num);
+
+    /**
+     * @brief 生成混合UDP包：单腿行情报文后跟对应合约的深度行情报文，模拟五档通道
+     *
+     * @param buf 输出缓冲区
+     * @param buf_len 缓冲区长度
+     * @param ins_per_pkg 每个报文包含的合约个数
+     *
+     * @return 生成的数据长度
+     */
+    int build_mixed(char *buf, int buf_len, int ins_per_pkg);
+
+    /**
+     * @brief 交易日
+     */
+    uint32 get_trade_date() const { return m_trade_date; }
+
+    /**
+     * @brief 合约个数
+     */
+    int get_ins_num() const { return m_ins_num; }
+
+    /**
+     * @brief 合约编码
+     */
+    const char *get_ins_id(int ins_idx) const { return m_ins[ins_idx].ins_id; }
+
+private:
+    /**
+     * @brief 模拟的合约状态
+     */
+    struct ins_state_t
+    {
+        char ins_id[MDP_INS_ID_LEN];    ///< 合约编码
+        uint8 ins_type;                 ///< 合约类型
+        int last;                       ///< 最新价
+        int volume;                     ///< 累计成交量
+        long long trade_val;            ///< 累计成交金额
+        int time_sec;                   ///< 秒级时间HHMMSS
+        int time_usec;                  ///< 微秒
+    };
+
+    uint32 next();
+    int next_range(int lo, int hi) { return lo + (int)(next() % (uint32)(hi - lo + 1)); }
+
+    /**
+     * @brief 生成一条消息（不含消息头）
+     *
+     * @return 消息长度
+     */
+    int build_msg(char *buf, uint8 msg_type, int msg_idx, int ins_idx);
+
+    int put_field(char *buf, int fld_idx, int value);
+    int put_depth(char *buf, int fld_idx, int price, int qty, int ord_cnt);
+
+private:
+    uint64_t m_state;                   ///< 随机数状态
+    int m_ins_num;                      ///< 合约个数
+    int m_next_ins;                     ///< 下一个生成消息的合约
+    uint32 m_trade_date;                ///< 交易日
+    uint16 m_seq;                       ///< 告示及询价序号
+    ins_state_t m_ins[PKT_GEN_MAX_INS]; ///< 合约状态
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <linux/filter.h>
+
+#include "pkt_ring.h"
+
+pkt_ring_t::pkt_ring_t()
+{
+    m_fd = -1;
+    m_map = NULL;
+    m_map_size = 0;
+    m_block_size = 0;
+    m_block_num = 0;
+    m_block_idx = 0;
+    m_drops = 0;
+}
+
+pkt_ring_t::~pkt_ring_t()
+{
+    close();
+}
+
+int pkt_ring_t::open(const char *if_name, const char *mc_ip, unsigned int mc_port,
+        uint32 block_size, uint32 block_num, uint32 retire_ms)
+{
+    if (m_fd >= 0)
+    {
+        printf("packet ring has been opened!\n");
+        return -1;
+    }
+
+    unsigned int if_index = if_nametoindex(if_name);
+    if (if_index == 0)
+    {
+        perror("find packet ring interface");
+        return -1;
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (block_size == 0 || block_size % page_size != 0 || block_num == 0)
+    {
+        printf("invalid packet ring block size %u or block number %u\n", block_size, block_num);
+        return -1;
+    }
+
+    m_fd = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_IP));
+    if (m_fd < 0)
+    {
+        perror("create packet socket");
+        return -2;
+    }
+
+    // 先挂过滤再绑定网卡，避免绑定后、过滤前的帧进入接收环
+    if (attach_filter(inet_addr(mc_ip), mc_port) != 0)
+    {
+        close();
+        return -3;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+    {
+        perror("set TPACKET_V3");
+        close();
+        return -3;
+    }
+
+    // 不设置PACKET_TIMESTAMP，帧头中为内核软件时间戳(CLOCK_REALTIME)，与SO_TIMESTAMPING路径同源；
+    // 网卡原始硬件时间戳来自网卡时钟，未必与系统时钟同步
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = block_size;
+    req.tp_block_nr = block_num;
+    req.tp_frame_size = TPACKET_ALIGNMENT << 7;
+    req.tp_frame_nr = (uint64_t)block_size * block_num / req.tp_frame_size;
+    req.tp_retire_blk_tov = retire_ms;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+    {
+        perror("set PACKET_RX_RING");
+        close();
+        return -4;
+    }
+
+    m_map_size = (uint64_t)block_size * block_num;
+    void *mem = mmap(NULL, m_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, 0);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap packet ring");
+        m_map_size = 0;
+        close();
+        return -5;
+    }
+
+    m_map = (char *)mem;
+    m_block_size = block_size;
+    m_block_num = block_num;
+    m_block_idx = 0;
+    m_drops = 0;
+
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    addr.sll_ifindex = if_index;
+    if (::bind(m_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("bind packet socket");
+        close();
+        return -6;
+    }
+
+    printf("Packet ring on %s: %u blocks x %u bytes, retire %u ms\n", if_name, block_num, block_size, retire_ms);
+    return 0;
+}
+
+void pkt_ring_t::close()
+{
+    if (m_map != NULL)
+        munmap(m_map, m_map_size);
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_map = NULL;
+    m_map_size = 0;
+    m_fd = -1;
+}
+
+int pkt_ring_t::attach_filter(uint32 mc_addr, uint16 mc_port)
+{
+    // 偏移基于以太网帧：12 类型，14+9 协议，14+6 分片，14+16 目的地址，14+IP头长+2 目的端口
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETHERTYPE_IP, 0, 10),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 8),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 30),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ntohl(mc_addr), 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, mc_port, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0x40000),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+    if (setsockopt(m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0)
+    {
+        perror("attach packet filter");
+        return -1;
+    }
+
+    return 0;
+}
+
+uint64_t pkt_ring_t::read_drops()
+{
+    // 每次读取后内核清零，这里累加
+    struct tpacket_stats_v3 st;
+    socklen_t len = sizeof(st);
+    if (m_fd >= 0 && getsockopt(m_fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) == 0)
+        m_drops += st.tp_drops;
+    return m_drops;
+}
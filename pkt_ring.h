@@ -0,0 +1,145 @@
+#ifndef PKT_RING_H_
+#define PKT_RING_H_
+
+#include <stdint.h>
+#include <linux/if_packet.h>
+
+#include "mdp_protocol.h"
+
+#define PKT_RING_BLOCK_SIZE  (1 << 20)  ///< 默认块大小
+#define PKT_RING_BLOCK_NUM   64         ///< 默认块个数
+#define PKT_RING_RETIRE_MS   1          ///< 默认块超时(ms)，未写满的块最迟在该时间后交给用户态
+
+/**
+ * @brief AF_PACKET TPACKET_V3内存映射接收环
+ *
+ * 在指定网卡上接收发往某个组播地址和端口的UDP帧，过滤由内核中的BPF程序完成。
+ * 内核把帧直接写入与用户态共享的环形块，用户态按块读取，读取时不再有复制。
+ * TPACKET_V3以块为单位交给用户态：块写满或超过retire_ms后才可读，
+ * 行情稀疏时单个报文的延迟上限为retire_ms。
+ */
+class pkt_ring_t
+{
+public:
+    pkt_ring_t();
+    ~pkt_ring_t();
+
+    /**
+     * @brief 创建AF_PACKET socket，挂接BPF过滤并映射接收环
+     *
+     * @param if_name 网卡名，如"eth0"、"lo"
+     * @param mc_ip 组播组IP
+     * @param mc_port 组播端口
+     * @param block_size 块大小，必须为页大小的整数倍
+     * @param block_num 块个数
+     * @param retire_ms 块超时(ms)
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int open(const char *if_name, const char *mc_ip, unsigned int mc_port,
+            uint32 block_size = PKT_RING_BLOCK_SIZE, uint32 block_num = PKT_RING_BLOCK_NUM,
+            uint32 retire_ms = PKT_RING_RETIRE_MS);
+
+    /**
+     * @brief 关闭socket并解除映射
+     */
+    void close();
+
+    /**
+     * @brief socket描述符，用于poll等待块就绪
+     */
+    int get_fd() const { return m_fd; }
+
+    /**
+     * @brief 当前块是否已交给用户态
+     */
+    bool block_ready() const
+    {
+        return (__atomic_load_n(&current()->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) != 0;
+    }
+
+    /**
+     * @brief 遍历当前块中的每个UDP负载后把块还给内核，调用前block_ready()须为true
+     *
+     * @param visit 访问函数，形如visit(const char *payload, int len, uint64_t kernel_ns)，
+     *              payload直接指向接收环，仅在调用期间有效；kernel_ns为内核软件时间戳(CLOCK_REALTIME)
+     *
+     * @return 块中交给visit的报文数
+     */
+    template <typename visitor_t>
+    int consume_block(visitor_t &visit);
+
+    /**
+     * @brief 累计的内核丢包数（环满时丢弃），读取PACKET_STATISTICS并累加
+     */
+    uint64_t read_drops();
+
+    /**
+     * @brief 当前块在丢包后交给用户态（TP_STATUS_LOSING），可用于触发read_drops()
+     */
+    bool block_losing() const
+    {
+        return (current()->hdr.bh1.block_status & TP_STATUS_LOSING) != 0;
+    }
+
+private:
+    struct tpacket_block_desc *current() const
+    {
+        return (struct tpacket_block_desc *)(m_map + (uint64_t)m_block_idx * m_block_size);
+    }
+
+    /**
+     * @brief 挂接BPF：IPv4/UDP、目的地址和端口匹配、非分片
+     */
+    int attach_filter(uint32 mc_addr, uint16 mc_port);
+
+private:
+    int m_fd;                   ///< AF_PACKET socket
+    char *m_map;                ///< 接收环映射地址
+    uint64_t m_map_size;        ///< 映射大小
+    uint32 m_block_size;        ///< 块大小
+    uint32 m_block_num;         ///< 块个数
+    uint32 m_block_idx;         ///< 下一个要读取的块
+    uint64_t m_drops;           ///< 累计丢包数
+};
+
+template <typename visitor_t>
+int pkt_ring_t::consume_block(visitor_t &visit)
+{
+    struct tpacket_block_desc *block = current();
+    uint32 pkt_num = block->hdr.bh1.num_pkts;
+    const char *p = (const char *)block + block->hdr.bh1.offset_to_first_pkt;
+    int count = 0;
+
+    for (uint32 i = 0; i < pkt_num; i++)
+    {
+        const struct tpacket3_hdr *hdr = (const struct tpacket3_hdr *)p;
+        const struct sockaddr_ll *sll = (const struct sockaddr_ll *)(p + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+        // 回环网卡上发出的帧也会被抓到，只处理收到的帧
+        if (sll->sll_pkttype != PACKET_OUTGOING)
+        {
+            // BPF已保证为IPv4/UDP且首部完整，这里只剥离以太网、IP和UDP头
+            const unsigned char *ip = (const unsigned char *)p + hdr->tp_net;
+            uint32 ihl = (ip[0] & 0x0F) * 4;
+            const unsigned char *udp = ip + ihl;
+            int udp_len = ((udp[4] << 8) | udp[5]) - 8;
+            int avail = (int)hdr->tp_snaplen - (int)(hdr->tp_net - hdr->tp_mac) - (int)ihl - 8;
+            if (udp_len > 0 && udp_len <= avail)
+            {
+                visit((const char *)udp + 8, udp_len, (uint64_t)hdr->tp_sec * 1000000000ULL + hdr->tp_nsec);
+                count++;
+            }
+        }
+
+        p += hdr->tp_next_offset;
+    }
+
+    // 块状态写回后内核即可复用该块，之前对块内数据的读取必须已完成
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    m_block_idx = (m_block_idx + 1) % m_block_num;
+
+    return count;
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include <stdio.h>
+
+#include "print_handler.h"
+
+void print_handler_t::print_banner(uint8 msg_type)
+{
+    printf("------------------ 报文类型：0x%02x ------------------\n", msg_type);
+}
+
+void print_handler_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    print_banner(PACKAGE_INSTRUMENT_IDX);
+
+    // 交易日（仅在第一个msg中存在）
+    if (ev.msg_idx == 0)
+        printf("trade date = %u\n", ev.trade_date);
+
+    printf("Type = %d\n", ev.ins_type);
+    printf("Index = %u\n", ev.ins_idx);
+    printf("InstrumentId = %s\n", ev.ins_id);
+}
+
+void print_handler_t::on_instrument_init(const mdp_init_event_t &ev)
+{
+    print_banner(PACKAGE_INSTRUMENT_INIT);
+
+    printf("price_size = %u\n", ev.price_size);
+    printf("ins_idx = %u\n", ev.ins_idx);
+
+    for (int fld_idx = 0; fld_idx < MDP_FIELD_NUM; fld_idx++)
+    {
+        if (!ev.fld.has(fld_idx))
+            continue;
+
+        int value = ev.fld.value[fld_idx];
+        switch (fld_idx)
+        {
+        case INIT_FLD_LAST_CLOSE:
+            printf("last close price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case INIT_FLD_LAST_CLEAR:
+            printf("last clear price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case INIT_FLD_LAST_HOLDING:
+            printf("last holding = %d\n", value);
+            break;
+        case INIT_FLD_LIMIT_UP:
+            printf("limit up price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case INIT_FLD_LIMIT_DOWN:
+            printf("limit down price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        default:
+            printf("item: %d, value: %d\n", fld_idx, value);
+            break;
+        }
+    }
+}
+
+void print_handler_t::on_instrument(const mdp_tick_event_t &ev)
+{
+    print_banner(PACKAGE_INSTRUMENT);
+
+    printf("price_size = %u\n", ev.price_size);
+    printf("ins_idx = %u\n", ev.ins_idx);
+
+    for (int fld_idx = 0; fld_idx < MDP_FIELD_NUM; fld_idx++)
+    {
+        if (!ev.fld.has(fld_idx))
+            continue;
+
+        int value = ev.fld.value[fld_idx];
+        switch (fld_idx)
+        {
+        case TICK_FLD_OPEN:
+            printf("open price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case TICK_FLD_HIGH:
+            printf("high price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case TICK_FLD_LOW:
+            printf("low price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case TICK_FLD_LAST:
+            printf("last price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case TICK_FLD_VOLUME:
+            printf("volume = %d\n", value);
+            break;
+        case TICK_FLD_TIME_SEC:
+            printf("time sec = %06d\n", value);
+            break;
+        case TICK_FLD_TIME_USEC:
+            printf("time usec = %06d\n", value);
+            break;
+        case TICK_FLD_TRADE_VAL1:
+            printf("trade value(part1) = %d\n", value);
+            break;
+        case TICK_FLD_TRADE_VAL2:
+            printf("trade value(part2) = %d\n", value);
+            break;
+        case TICK_FLD_LIFE_HIGH:
+            printf("life high price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case TICK_FLD_LIFE_LOW:
+            printf("life low price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        default:
+            printf("item: %d, value: %d\n", fld_idx, value);
+            break;
+        }
+    }
+
+    // 总成交金额
+    if (ev.trade_val != 0)
+        printf("trade value(sum) = %lf\n", ev.turnover().to_double());
+}
+
+void print_handler_t::on_cmbtype(const mdp_cmb_event_t &ev)
+{
+    print_banner(PACKAGE_CMBTYPE);
+
+    printf("price_size = %u\n", ev.price_size);
+    printf("ins_idx = %u\n", ev.ins_idx);
+
+    for (int fld_idx = 0; fld_idx < MDP_FIELD_NUM; fld_idx++)
+    {
+        if (!ev.fld.has(fld_idx))
+            continue;
+
+        int value = ev.fld.value[fld_idx];
+        switch (fld_idx)
+        {
+        case CMB_FLD_BID:
+            printf("bid price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case CMB_FLD_ASK:
+            printf("ask price = %f\n", ev.price(fld_idx).to_double());
+            break;
+        case CMB_FLD_BID_LOT:
+            printf("bid lot = %d\n", value);
+            break;
+        case CMB_FLD_ASK_LOT:
+            printf("ask lot = %d\n", value);
+            break;
+        case CMB_FLD_TIME_SEC:
+            printf("time sec = %d\n", value);
+            break;
+        case CMB_FLD_TIME_USEC:
+            printf("time usec = %d\n", value);
+            break;
+        default:
+            printf("item: %d, value: %d\n", fld_idx, value);
+            break;
+        }
+    }
+}
+
+void print_handler_t::on_bulletine(const mdp_bulletine_event_t &ev)
+{
+    print_banner(PACKAGE_BULLETINE);
+
+    printf("bulletine seq = %u\n", ev.msg_seq);
+    printf("bulletine context: %.*s\n", ev.text_len, ev.text);
+}
+
+void print_handler_t::on_quot_req(const mdp_quot_req_event_t &ev)
+{
+    print_banner(PACKAGE_QUOT_REQ);
+
+    printf("Index = %u\n", ev.ins_idx);
+    printf("trade date = %d\n", ev.trade_date);
+    printf("req no = %d\n", ev.req_no);
+    printf("direction = %d\n", ev.direction);
+    printf("request_by = %d\n", ev.request_by);
+}
+
+void print_handler_t::on_trade_status(const mdp_trade_status_event_t &ev)
+{
+    print_banner(PACKAGE_TRADE_STATUS);
+
+    printf("trade status = %d\n", ev.trade_status);
+}
+
+void print_handler_t::on_depth(const mdp_depth_event_t &ev)
+{
+    print_banner(PACKAGE_DEPTH);
+
+    printf("price_size = %u\n", ev.price_size);
+    printf("ins_idx = %u\n", ev.ins_idx);
+
+    for (int fld_idx = 0; fld_idx < MDP_FIELD_NUM; fld_idx++)
+    {
+        if (!ev.has(fld_idx))
+            continue;
+
+        const mdp_depth_entry_t &entry = ev.entry[fld_idx];
+        if (fld_idx >= DEPTH_FLD_BID(0) && fld_idx <= DEPTH_FLD_ASK(DEPTH_LEVEL_NUM - 1))
+        {
+            printf("%sDepth%d = %f %sSize%d = %d OrdCnt%d = %d\n",
+                    fld_idx % 2 == 1 ? "Bid" : "Ask", (fld_idx + 1) / 2, ev.price(fld_idx).to_double(),
+                    fld_idx % 2 == 1 ? "Bid" : "Ask", (fld_idx + 1) / 2, entry.qty,
+                    (fld_idx + 1) / 2, entry.ord_cnt);
+        }
+        else
+        {
+            printf("item: %d, value: %d\n", fld_idx, entry.price);
+        }
+    }
+}
+
+void print_handler_t::on_unknown(uint8 msg_type)
+{
+    printf("unknown package type: 0x%02x\n", msg_type);
+}
@@ -0,0 +1,31 @@
+#ifndef PRINT_HANDLER_H_
+#define PRINT_HANDLER_H_
+
+#include "mdp_handler.h"
+
+/**
+ * @brief 打印处理器，将解码后的事件逐字段输出到标准输出
+ *
+ * 仅用于调试和核对行情，控制台输出远慢于解码本身。
+ */
+class print_handler_t : public mdp_null_handler_t
+{
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+    void on_instrument_init(const mdp_init_event_t &ev);
+    void on_instrument(const mdp_tick_event_t &ev);
+    void on_cmbtype(const mdp_cmb_event_t &ev);
+    void on_bulletine(const mdp_bulletine_event_t &ev);
+    void on_quot_req(const mdp_quot_req_event_t &ev);
+    void on_trade_status(const mdp_trade_status_event_t &ev);
+    void on_depth(const mdp_depth_event_t &ev);
+    void on_unknown(uint8 msg_type);
+
+private:
+    /**
+     * @brief 打印报文类型分隔行
+     */
+    void print_banner(uint8 msg_type);
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "quote_merge.h"
+
+quote_merger_t::quote_merger_t()
+    : m_trade_date(0)
+{
+    m_quotes = NULL;
+    m_quote_cb = NULL;
+    m_quote_ctx = NULL;
+    for (int i = 0; i < QUOTE_SOURCE_NUM; i++)
+    {
+        m_emitted[i] = 0;
+        m_suppressed[i] = 0;
+    }
+}
+
+quote_merger_t::~quote_merger_t()
+{
+    if (m_quotes != NULL)
+        munmap(m_quotes, sizeof(seqlock_t<merged_quote_t>) * INS_TABLE_SIZE);
+}
+
+int quote_merger_t::init()
+{
+    if (m_quotes != NULL)
+    {
+        printf("quote merger has been initialized!\n");
+        return -1;
+    }
+
+    // 匿名映射内存初始为0，即顺序锁的初始状态
+    void *mem = mmap(NULL, sizeof(seqlock_t<merged_quote_t>) * INS_TABLE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap quote merger");
+        return -1;
+    }
+
+    m_quotes = (seqlock_t<merged_quote_t> *)mem;
+    for (int i = 0; i < QUOTE_SOURCE_NUM; i++)
+    {
+        m_inputs[i].m_merger = this;
+        m_inputs[i].m_source = i;
+    }
+    return 0;
+}
+
+void quote_merger_t::on_trade_date(uint32 trade_date)
+{
+    // 两个通道都会收到新交易日的索引，只由先到的一个清空
+    uint32 old_date = m_trade_date.load(std::memory_order_relaxed);
+    if (old_date == trade_date || !m_trade_date.compare_exchange_strong(old_date, trade_date))
+        return;
+    if (old_date == 0)
+        return;
+
+    for (int i = 0; i < INS_TABLE_SIZE; i++)
+    {
+        merged_quote_t &quote = m_quotes[i].lock_write();
+        memset((void *)&quote, 0, sizeof(quote));
+        m_quotes[i].end_write();
+    }
+}
+
+void quote_merger_t::commit(seqlock_t<merged_quote_t> &lock, merged_quote_t &quote, uint8 source, uint8 update)
+{
+    std::atomic<uint64_t> &counter = update != 0 ? m_emitted[source] : m_suppressed[source];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (update == 0)
+    {
+        lock.cancel_write();
+        return;
+    }
+
+    quote.seq++;
+    quote.source = source;
+    quote.update = update;
+
+    // 回调在锁外进行，避免另一通道等待回调
+    merged_quote_t copy;
+    if (m_quote_cb != NULL)
+        memcpy((void *)&copy, (const void *)&quote, sizeof(copy));
+    lock.end_write();
+
+    if (m_quote_cb != NULL)
+        m_quote_cb(m_quote_ctx, copy);
+}
+
+void quote_merger_t::on_tick(uint8 source, const mdp_tick_event_t &ev)
+{
+    const mdp_fields_t &fld = ev.fld;
+    long long time_us = to_time_us(fld, TICK_FLD_TIME_SEC, TICK_FLD_TIME_USEC);
+
+    seqlock_t<merged_quote_t> &lock = m_quotes[ev.ins_idx];
+    merged_quote_t &quote = lock.lock_write();
+
+    // 累计成交量不会减少，没有时间的消息也能据此识别过期
+    if (is_stale(time_us, quote) || (fld.has(TICK_FLD_VOLUME) && fld.value[TICK_FLD_VOLUME] < quote.volume))
+    {
+        commit(lock, quote, source, 0);
+        return;
+    }
+
+    bool changed = false;
+    if (fld.has(TICK_FLD_LAST))
+        changed |= update(quote.last, fld.value[TICK_FLD_LAST]);
+    if (fld.has(TICK_FLD_VOLUME))
+        changed |= update(quote.volume, fld.value[TICK_FLD_VOLUME]);
+    if (fld.has(TICK_FLD_TRADE_VAL1) || fld.has(TICK_FLD_TRADE_VAL2))
+        changed |= update(quote.trade_val, ev.trade_val);
+
+    // 时间本身不构成变化，只随成交一起更新
+    if (changed)
+    {
+        if (time_us >= 0)
+            quote.time_us = time_us;
+        quote.price_size = ev.price_size;
+        quote.ins_idx = ev.ins_idx;
+    }
+    commit(lock, quote, source, changed ? QUOTE_UPD_TRADE : 0);
+}
+
+void quote_merger_t::on_cmb(uint8 source, const mdp_cmb_event_t &ev)
+{
+    const mdp_fields_t &fld = ev.fld;
+    long long time_us = to_time_us(fld, CMB_FLD_TIME_SEC, CMB_FLD_TIME_USEC);
+
+    seqlock_t<merged_quote_t> &lock = m_quotes[ev.ins_idx];
+    merged_quote_t &quote = lock.lock_write();
+    if (is_stale(time_us, quote))
+    {
+        commit(lock, quote, source, 0);
+        return;
+    }
+
+    bool changed = false;
+    if (fld.has(CMB_FLD_BID))
+        changed |= update(quote.bid_price[0], fld.value[CMB_FLD_BID]);
+    if (fld.has(CMB_FLD_ASK))
+        changed |= update(quote.ask_price[0], fld.value[CMB_FLD_ASK]);
+    if (fld.has(CMB_FLD_BID_LOT))
+        changed |= update(quote.bid_qty[0], fld.value[CMB_FLD_BID_LOT]);
+    if (fld.has(CMB_FLD_ASK_LOT))
+        changed |= update(quote.ask_qty[0], fld.value[CMB_FLD_ASK_LOT]);
+
+    if (changed)
+    {
+        if (time_us >= 0)
+            quote.time_us = time_us;
+        quote.price_size = ev.price_size;
+        quote.ins_idx = ev.ins_idx;
+    }
+    commit(lock, quote, source, changed ? QUOTE_UPD_DEPTH : 0);
+}
+
+void quote_merger_t::on_depth(uint8 source, const mdp_depth_event_t &ev)
+{
+    seqlock_t<merged_quote_t> &lock = m_quotes[ev.ins_idx];
+    merged_quote_t &quote = lock.lock_write();
+
+    // 只处理买一~卖五对应的字段1~10
+    bool changed = false;
+    uint32 mask = ev.mask & (((1u << (DEPTH_LEVEL_NUM * 2)) - 1) << 1);
+    while (mask != 0)
+    {
+        int fld_idx = __builtin_ctz(mask);
+        int level = (fld_idx - 1) >> 1;
+        const mdp_depth_entry_t &entry = ev.entry[fld_idx];
+        if (fld_idx & 1)
+        {
+            changed |= update(quote.bid_price[level], entry.price);
+            changed |= update(quote.bid_qty[level], entry.qty);
+        }
+        else
+        {
+            changed |= update(quote.ask_price[level], entry.price);
+            changed |= update(quote.ask_qty[level], entry.qty);
+        }
+        mask &= mask - 1;
+    }
+
+    if (changed)
+    {
+        quote.price_size = ev.price_size;
+        quote.ins_idx = ev.ins_idx;
+    }
+    commit(lock, quote, source, changed ? QUOTE_UPD_DEPTH : 0);
+}
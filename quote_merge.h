@@ -0,0 +1,212 @@
+#ifndef QUOTE_MERGE_H_
+#define QUOTE_MERGE_H_
+
+#include "ins_table.h"
+
+#define QUOTE_SOURCE_NUM        2               ///< 合并的通道数（一档、五档）
+#define QUOTE_SESSION_GAP_US    3600000000LL    ///< 交易所时间回退超过该值视为跨日进入下一时段，否则视为过期
+
+#define QUOTE_UPD_TRADE         0x01            ///< 成交（最新价、成交量、成交金额）变化
+#define QUOTE_UPD_DEPTH         0x02            ///< 盘口变化
+
+/**
+ * @brief 合并后的行情：最新成交和五档盘口
+ *
+ * 组合合约（组合行情0x11）只有买一、卖一，放在第0档。
+ */
+struct merged_quote_t
+{
+    uint32 seq;                         ///< 合约的变化序号，每发出一次加1
+    uint16 price_size;                  ///< 价格精度
+    uint16 ins_idx;                     ///< 合约索引
+    uint8 source;                       ///< 本次变化来自的通道
+    uint8 update;                       ///< 本次变化的内容，QUOTE_UPD_*
+    long long time_us;                  ///< 交易所时间，当日微秒数，深度行情沿用该合约最近的时间
+    int last;                           ///< 最新价
+    int volume;                         ///< 累计成交量
+    long long trade_val;                ///< 累计成交金额（未除价格精度）
+    int bid_price[DEPTH_LEVEL_NUM];     ///< 买一~买五价格
+    int bid_qty[DEPTH_LEVEL_NUM];       ///< 买一~买五委托量
+    int ask_price[DEPTH_LEVEL_NUM];     ///< 卖一~卖五价格
+    int ask_qty[DEPTH_LEVEL_NUM];       ///< 卖一~卖五委托量
+
+    price_t last_price() const { return price_t(last, price_size); }
+    price_t bid(int level) const { return price_t(bid_price[level], price_size); }
+    price_t ask(int level) const { return price_t(ask_price[level], price_size); }
+    price_t turnover() const { return price_t(trade_val, price_size); }
+};
+
+/**
+ * @brief 合并行情回调，在产生该变化的解码线程中调用
+ */
+typedef void (*quote_cb_t)(void *ctx, const merged_quote_t &quote);
+
+class quote_merger_t;
+
+/**
+ * @brief 合并器的单通道输入，加入该通道的处理器组合
+ */
+class quote_merge_input_t : public mdp_null_handler_t
+{
+public:
+    quote_merge_input_t() : m_merger(NULL), m_source(0) {}
+
+/****** 处理器接口 ******/
+public:
+    inline void on_instrument_idx(const mdp_idx_event_t &ev);
+    inline void on_instrument(const mdp_tick_event_t &ev);
+    inline void on_cmbtype(const mdp_cmb_event_t &ev);
+    inline void on_depth(const mdp_depth_event_t &ev);
+
+private:
+    friend class quote_merger_t;
+
+    quote_merger_t *m_merger;  ///< 所属合并器，未初始化时为NULL
+    uint8 m_source;            ///< 通道序号
+};
+
+/**
+ * @brief 一档、五档行情合并
+ *
+ * 一档通道的单腿/组合行情与五档通道的深度行情按ins_idx合并为一个行情表，
+ * 每个合约一条记录，携带最新成交和完整五档盘口。两个通道各自的解码线程
+ * 通过input()取得的处理器写入，记录由顺序锁保护、写线程之间以lock_write()
+ * 互斥（只在两个通道同时处理同一合约时短暂自旋），读者从不阻塞写者。
+ *
+ * 单腿/组合行情按交易所时间（字段16/18、7/8）排序：早于记录时间的消息已被
+ * 另一通道更新过，直接丢弃；时间不早于记录时间但携带的值与记录相同的消息
+ * 为重复消息，同样丢弃。深度行情不带时间，只在盘口实际变化时发出，时间沿用
+ * 该合约最近一次成交行情的时间。每次实际变化调用一次回调，先到的通道生效。
+ */
+class quote_merger_t
+{
+public:
+    quote_merger_t();
+    ~quote_merger_t();
+
+    /**
+     * @brief 分配并预先映射行情表
+     *
+     * @return 0：成功；-1：失败
+     */
+    int init();
+
+    /**
+     * @brief 设置合并行情回调，需在解码线程启动前设置
+     */
+    void set_quote_cb(quote_cb_t cb, void *ctx)
+    {
+        m_quote_cb = cb;
+        m_quote_ctx = ctx;
+    }
+
+    /**
+     * @brief 通道输入
+     *
+     * @param source 通道序号，0为一档，1为五档
+     */
+    quote_merge_input_t &input(int source) { return m_inputs[source]; }
+
+    /**
+     * @brief 读取合约合并行情的一致快照，可在任意线程调用
+     *
+     * @return true：已有行情；false：尚无行情
+     */
+    bool read(uint16 ins_idx, merged_quote_t &quote) const
+    {
+        if (m_quotes == NULL)
+            return false;
+        m_quotes[ins_idx].read(quote);
+        return quote.seq != 0;
+    }
+
+    /**
+     * @brief 各通道发出的合并行情数
+     */
+    uint64_t get_emitted(int source) const { return m_emitted[source].load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 各通道因过期或重复被丢弃的消息数
+     */
+    uint64_t get_suppressed(int source) const { return m_suppressed[source].load(std::memory_order_relaxed); }
+
+private:
+    friend class quote_merge_input_t;
+
+    void on_trade_date(uint32 trade_date);
+    void on_tick(uint8 source, const mdp_tick_event_t &ev);
+    void on_cmb(uint8 source, const mdp_cmb_event_t &ev);
+    void on_depth(uint8 source, const mdp_depth_event_t &ev);
+
+    /**
+     * @brief 交易所时间转为当日微秒数，没有秒级时间时返回-1
+     */
+    static long long to_time_us(const mdp_fields_t &fld, int sec_fld, int usec_fld)
+    {
+        if (!fld.has(sec_fld))
+            return -1;
+        int hhmmss = fld.value[sec_fld];
+        long long day_sec = hhmmss / 10000 * 3600 + hhmmss / 100 % 100 * 60 + hhmmss % 100;
+        return day_sec * 1000000 + (fld.has(usec_fld) ? fld.value[usec_fld] : 0);
+    }
+
+    /**
+     * @brief 消息时间是否早于记录时间，跨日回绕不算过期
+     */
+    static bool is_stale(long long time_us, const merged_quote_t &quote)
+    {
+        return time_us >= 0 && time_us < quote.time_us && quote.time_us - time_us < QUOTE_SESSION_GAP_US;
+    }
+
+    /**
+     * @brief 更新一个字段，返回是否变化
+     */
+    template <typename T>
+    static bool update(T &field, T value)
+    {
+        if (field == value)
+            return false;
+        field = value;
+        return true;
+    }
+
+    /**
+     * @brief 结束写入并发出合并行情，未变化时放弃写入
+     */
+    void commit(seqlock_t<merged_quote_t> &lock, merged_quote_t &quote, uint8 source, uint8 update);
+
+private:
+    seqlock_t<merged_quote_t> *m_quotes;                ///< 以ins_idx为下标的合并行情，共INS_TABLE_SIZE项
+    quote_merge_input_t m_inputs[QUOTE_SOURCE_NUM];     ///< 各通道输入
+    std::atomic<uint32> m_trade_date;                   ///< 当前交易日
+    quote_cb_t m_quote_cb;                              ///< 合并行情回调
+    void *m_quote_ctx;                                  ///< 回调上下文
+    std::atomic<uint64_t> m_emitted[QUOTE_SOURCE_NUM];  ///< 各通道发出的合并行情数
+    std::atomic<uint64_t> m_suppressed[QUOTE_SOURCE_NUM];  ///< 各通道被丢弃的消息数
+};
+
+void quote_merge_input_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    if (m_merger != NULL && ev.msg_idx == 0)
+        m_merger->on_trade_date(ev.trade_date);
+}
+
+void quote_merge_input_t::on_instrument(const mdp_tick_event_t &ev)
+{
+    if (m_merger != NULL)
+        m_merger->on_tick(m_source, ev);
+}
+
+void quote_merge_input_t::on_cmbtype(const mdp_cmb_event_t &ev)
+{
+    if (m_merger != NULL)
+        m_merger->on_cmb(m_source, ev);
+}
+
+void quote_merge_input_t::on_depth(const mdp_depth_event_t &ev)
+{
+    if (m_merger != NULL)
+        m_merger->on_depth(m_source, ev);
+}
+
+#endif
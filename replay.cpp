@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "replay.h"
+#include "journal.h"
+#include "tsc_clock.h"
+
+#define PCAP_MAGIC_US       0xA1B2C3D4  ///< pcap，微秒时间戳
+#define PCAP_MAGIC_NS       0xA1B23C4D  ///< pcap，纳秒时间戳
+#define PCAPNG_SHB          0x0A0D0D0A  ///< pcapng节头块
+#define PCAPNG_IDB          0x00000001  ///< pcapng接口描述块
+#define PCAPNG_SPB          0x00000003  ///< pcapng简单包块
+#define PCAPNG_EPB          0x00000006  ///< pcapng增强包块
+#define PCAPNG_BYTE_ORDER   0x1A2B3C4D  ///< pcapng字节序标识
+
+#define LINKTYPE_NULL       0           ///< BSD loopback
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101         ///< 直接为IP包
+#define LINKTYPE_LINUX_SLL  113         ///< Linux cooked capture
+#define LINKTYPE_LINUX_SLL2 276         ///< Linux cooked capture v2
+
+/**
+ * @brief 按文件字节序读取整数
+ */
+static inline uint32 file_u32(const char *p, bool swap)
+{
+    uint32 v;
+    memcpy(&v, p, 4);
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+static inline uint16 file_u16(const char *p, bool swap)
+{
+    uint16 v;
+    memcpy(&v, p, 2);
+    return swap ? __builtin_bswap16(v) : v;
+}
+
+replay_t::replay_t()
+{
+    m_speed = 0;
+    m_stop = false;
+    m_paced = false;
+    m_first_ts = 0;
+    m_start_mono = 0;
+    m_dispatched = 0;
+    m_skipped = 0;
+}
+
+replay_t::~replay_t()
+{
+}
+
+int replay_t::add_channel(uint16 channel_id, const char *mc_ip, unsigned int mc_port, mc_data_cb_t cb, void *ctx)
+{
+    if (cb == NULL || mc_ip == NULL)
+    {
+        printf("add replay channel failed: invalid argument!\n");
+        return -1;
+    }
+
+    channel_t channel;
+    channel.channel_id = channel_id;
+    channel.mc_addr = inet_addr(mc_ip);
+    channel.mc_port = mc_port;
+    channel.cb = cb;
+    channel.ctx = ctx;
+    m_channels.push_back(channel);
+
+    return 0;
+}
+
+int replay_t::run(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("open replay file");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 4)
+    {
+        printf("replay file %s is empty\n", path);
+        close(fd);
+        return -2;
+    }
+
+    void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap replay file");
+        return -3;
+    }
+    madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+    const char *data = (const char *)mem;
+    uint64_t len = st.st_size;
+    uint32 magic = file_u32(data, false);
+
+    int res = 0;
+    if (len >= sizeof(jnl_file_header_t) && memcmp(data, JNL_MAGIC, 8) == 0)
+    {
+        res = run_journal(data, len);
+    }
+    else if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS
+            || magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS))
+    {
+        res = run_pcap(data, len);
+    }
+    else if (magic == PCAPNG_SHB)
+    {
+        res = run_pcapng(data, len);
+    }
+    else
+    {
+        printf("unknown replay file format: %s\n", path);
+        res = -4;
+    }
+
+    munmap(mem, len);
+    return res;
+}
+
+int replay_t::run_journal(const char *data, uint64_t len)
+{
+    const jnl_file_header_t *header = (const jnl_file_header_t *)data;
+    if (header->version != JNL_VERSION)
+    {
+        printf("unsupported journal version: %u\n", header->version);
+        return -5;
+    }
+
+    // 正常关闭的文件记录了有效长度；异常退出时扫描到空记录头为止
+    uint64_t end = header->data_len != 0 && header->data_len <= len ? header->data_len : len;
+    uint64_t pos = header->header_len;
+
+    while (pos + sizeof(jnl_record_head_t) <= end && !m_stop.load(std::memory_order_relaxed))
+    {
+        const jnl_record_head_t *rec = (const jnl_record_head_t *)(data + pos);
+        if (rec->recv_ns == 0 || pos + sizeof(jnl_record_head_t) + rec->len > end)
+            break;
+
+        const channel_t *channel = NULL;
+        for (size_t i = 0; i < m_channels.size(); i++)
+        {
+            if (m_channels[i].channel_id == rec->channel_id)
+            {
+                channel = &m_channels[i];
+                break;
+            }
+        }
+
+        if (channel != NULL)
+            dispatch(channel, data + pos + sizeof(jnl_record_head_t), rec->len, rec->recv_ns);
+        else
+            m_skipped++;
+
+        pos += (sizeof(jnl_record_head_t) + rec->len + JNL_ALIGN - 1) & ~(uint64_t)(JNL_ALIGN - 1);
+    }
+
+    return 0;
+}
+
+int replay_t::run_pcap(const char *data, uint64_t len)
+{
+    if (len < 24)
+        return -5;
+
+    uint32 magic = file_u32(data, false);
+    bool swap = (magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS);
+    bool nano = (file_u32(data, swap) == PCAP_MAGIC_NS);
+    uint32 link_type = file_u32(data + 20, swap) & 0x0FFFFFFF;
+
+    uint64_t pos = 24;
+    while (pos + 16 <= len && !m_stop.load(std::memory_order_relaxed))
+    {
+        uint32 ts_sec = file_u32(data + pos, swap);
+        uint32 ts_frac = file_u32(data + pos + 4, swap);
+        uint32 cap_len = file_u32(data + pos + 8, swap);
+        pos += 16;
+
+        if (pos + cap_len > len)
+            break;
+
+        uint64_t ts_ns = (uint64_t)ts_sec * 1000000000ULL + (nano ? ts_frac : (uint64_t)ts_frac * 1000);
+        dispatch_frame(link_type, data + pos, cap_len, ts_ns);
+        pos += cap_len;
+    }
+
+    return 0;
+}
+
+int replay_t::run_pcapng(const char *data, uint64_t len)
+{
+    // 每个节(SHB)有独立的字节序和接口列表
+    bool swap = false;
+    std::vector<uint32> if_link_type;
+    std::vector<uint64_t> if_ts_unit;  // 每个时间戳单位对应的ns，负指数时为0并用if_ts_div
+    std::vector<uint64_t> if_ts_div;
+
+    uint64_t pos = 0;
+    while (pos + 12 <= len && !m_stop.load(std::memory_order_relaxed))
+    {
+        uint32 block_type = file_u32(data + pos, swap);
+        if (block_type == PCAPNG_SHB)
+        {
+            uint32 byte_order = file_u32(data + pos + 8, false);
+            if (byte_order == PCAPNG_BYTE_ORDER)
+                swap = false;
+            else if (byte_order == __builtin_bswap32(PCAPNG_BYTE_ORDER))
+                swap = true;
+            else
+                return -5;
+
+            if_link_type.clear();
+            if_ts_unit.clear();
+            if_ts_div.clear();
+        }
+
+        uint32 block_len = file_u32(data + pos + 4, swap);
+        if (block_len < 12 || pos + block_len > len)
+            break;
+
+        const char *body = data + pos + 8;
+        uint32 body_len = block_len - 12;
+
+        if (block_type == PCAPNG_IDB && body_len >= 8)
+        {
+            uint64_t ts_unit = 1000;  // 默认微秒
+            uint64_t ts_div = 1;
+
+            // 选项中查找if_tsresol(9)
+            uint32 opt_pos = 8;
+            while (opt_pos + 4 <= body_len)
+            {
+                uint16 opt_code = file_u16(body + opt_pos, swap);
+                uint16 opt_len = file_u16(body + opt_pos + 2, swap);
+                if (opt_code == 0)
+                    break;
+                if (opt_code == 9 && opt_len >= 1 && opt_pos + 4 < body_len)
+                {
+                    // 指数超过uint64能表示的范围（2^63、10^19）时视为损坏，保留默认微秒
+                    uint8 resol = body[opt_pos + 4];
+                    int exp = resol & 0x7F;
+                    uint64_t units_per_sec = 1;
+                    if (exp > ((resol & 0x80) ? 63 : 19))
+                    {
+                        printf("invalid pcapng if_tsresol 0x%02x, using microseconds\n", resol);
+                        opt_pos += 4 + ((opt_len + 3) & ~3u);
+                        continue;
+                    }
+                    for (int i = 0; i < exp; i++)
+                        units_per_sec *= (resol & 0x80) ? 2 : 10;
+
+                    if (units_per_sec <= 1000000000ULL)
+                    {
+                        ts_unit = 1000000000ULL / units_per_sec;
+                        ts_div = 1;
+                    }
+                    else
+                    {
+                        ts_unit = 1;
+                        ts_div = units_per_sec / 1000000000ULL;
+                    }
+                }
+                opt_pos += 4 + ((opt_len + 3) & ~3u);
+            }
+
+            if_link_type.push_back(file_u16(body, swap));
+            if_ts_unit.push_back(ts_unit);
+            if_ts_div.push_back(ts_div);
+        }
+        else if (block_type == PCAPNG_EPB && body_len >= 20)
+        {
+            uint32 if_id = file_u32(body, swap);
+            uint64_t ts = ((uint64_t)file_u32(body + 4, swap) << 32) | file_u32(body + 8, swap);
+            uint32 cap_len = file_u32(body + 12, swap);
+
+            // body_len >= 20已确认，按减法比较，避免损坏的cap_len相加后回绕
+            if (if_id < if_link_type.size() && cap_len <= body_len - 20)
+                dispatch_frame(if_link_type[if_id], body + 20, cap_len, ts * if_ts_unit[if_id] / if_ts_div[if_id]);
+            else
+                m_skipped++;
+        }
+        else if (block_type == PCAPNG_SPB && body_len >= 4 && !if_link_type.empty())
+        {
+            // 简单包块没有时间戳，节奏回放时视为与上一个报文同时
+            uint32 cap_len = body_len - 4;
+            uint32 orig_len = file_u32(body, swap);
+            if (orig_len < cap_len)
+                cap_len = orig_len;
+            dispatch_frame(if_link_type[0], body + 4, cap_len, 0);
+        }
+
+        pos += block_len;
+    }
+
+    return 0;
+}
+
+void replay_t::dispatch_frame(uint32 link_type, const char *frame, uint32 len, uint64_t ts_ns)
+{
+    const unsigned char *p = (const unsigned char *)frame;
+    uint32 l3_off = 0;
+    uint16 ether_type = 0;
+
+    switch (link_type)
+    {
+    case LINKTYPE_ETHERNET:
+        if (len < 14)
+            break;
+        ether_type = (p[12] << 8) | p[13];
+        l3_off = 14;
+        while ((ether_type == 0x8100 || ether_type == 0x88A8) && len >= l3_off + 4)  // VLAN
+        {
+            ether_type = (p[l3_off + 2] << 8) | p[l3_off + 3];
+            l3_off += 4;
+        }
+        break;
+    case LINKTYPE_LINUX_SLL:
+        if (len < 16)
+            break;
+        ether_type = (p[14] << 8) | p[15];
+        l3_off = 16;
+        break;
+    case LINKTYPE_LINUX_SLL2:
+        if (len < 20)
+            break;
+        ether_type = (p[0] << 8) | p[1];
+        l3_off = 20;
+        break;
+    case LINKTYPE_RAW:
+        ether_type = 0x0800;
+        l3_off = 0;
+        break;
+    case LINKTYPE_NULL:
+        if (len < 4)
+            break;
+        ether_type = (p[0] == 2 || p[3] == 2) ? 0x0800 : 0;  // AF_INET，字节序不定
+        l3_off = 4;
+        break;
+    default:
+        break;
+    }
+
+    // 只处理不分片的IPv4 UDP报文
+    if (ether_type != 0x0800 || len < l3_off + 20)
+    {
+        m_skipped++;
+        return;
+    }
+
+    const unsigned char *ip = p + l3_off;
+    uint32 ihl = (ip[0] & 0x0F) * 4;
+    uint16 frag = ((ip[6] << 8) | ip[7]) & 0x3FFF;
+    if ((ip[0] >> 4) != 4 || ip[9] != 17 || frag != 0 || ihl < 20 || len < l3_off + ihl + 8)
+    {
+        m_skipped++;
+        return;
+    }
+
+    uint32 dst_addr;
+    memcpy(&dst_addr, ip + 16, 4);
+
+    const unsigned char *udp = ip + ihl;
+    uint16 dst_port = (udp[2] << 8) | udp[3];
+    uint32 udp_len = (udp[4] << 8) | udp[5];
+    uint32 avail = len - l3_off - ihl;
+    if (udp_len < 8 || udp_len > avail)
+    {
+        m_skipped++;
+        return;
+    }
+
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        if (m_channels[i].mc_addr == dst_addr && m_channels[i].mc_port == dst_port)
+        {
+            dispatch(&m_channels[i], (const char *)udp + 8, udp_len - 8, ts_ns);
+            return;
+        }
+    }
+
+    m_skipped++;
+}
+
+void replay_t::dispatch(const channel_t *channel, const char *buf, int len, uint64_t ts_ns)
+{
+    if (m_speed > 0 && ts_ns != 0)
+        pace(ts_ns);
+
+    // 录制时的接收时间作为内核时间戳，回放中没有排队延迟
+    mdp_recv_info_t info;
+    info.channel_id = channel->channel_id;
+    info.kernel_ns = ts_ns;
+    info.dequeue_ns = ts_ns;
+    info.dequeue_tsc = rdtsc();
+
+    channel->cb(channel->ctx, buf, len, &info);
+    m_dispatched++;
+}
+
+void replay_t::pace(uint64_t ts_ns)
+{
+    if (!m_paced)
+    {
+        m_paced = true;
+        m_first_ts = ts_ns;
+        m_start_mono = monotonic_ns();
+        return;
+    }
+
+    if (ts_ns <= m_first_ts)
+        return;
+
+    uint64_t target = m_start_mono + (uint64_t)((ts_ns - m_first_ts) / m_speed);
+    while (true)
+    {
+        uint64_t now = monotonic_ns();
+        if (now >= target || m_stop.load(std::memory_order_relaxed))
+            break;
+
+        // 距离目标较远时睡眠，临近时自旋以保持精度
+        uint64_t remain = target - now;
+        if (remain > 200000)
+        {
+            struct timespec ts;
+            ts.tv_sec = (remain - 100000) / 1000000000ULL;
+            ts.tv_nsec = (remain - 100000) % 1000000000ULL;
+            nanosleep(&ts, NULL);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "mc_client.h"
+
+/**
+ * @brief 离线回放
+ *
+ * 读取录制日志(jnl_writer_t生成)或pcap/pcapng抓包文件，把其中的组播报文按原有
+ * 顺序交给与实盘相同的数据回调（如mdp_decoder_t::data_cb），无需组播网络。
+ * 日志按通道号分发，抓包文件按UDP目的地址和端口分发。
+ * 支持尽快回放和按时间戳节奏回放（可设倍速）。
+ */
+class replay_t
+{
+public:
+    replay_t();
+    ~replay_t();
+
+    /**
+     * @brief 注册回放通道
+     *
+     * @param channel_id 录制日志中的通道号
+     * @param mc_ip 组播组IP，用于匹配抓包文件
+     * @param mc_port 组播端口，用于匹配抓包文件
+     * @param cb 数据回调
+     * @param ctx 回调上下文
+     *
+     * @return 0：成功；-1：参数错误
+     */
+    int add_channel(uint16 channel_id, const char *mc_ip, unsigned int mc_port, mc_data_cb_t cb, void *ctx);
+
+    /**
+     * @brief 设置回放速度
+     *
+     * @param speed 0：尽快回放；1.0：按原始节奏；大于1：按倍速加快
+     */
+    void set_speed(double speed) { m_speed = speed; }
+
+    /**
+     * @brief 回放一个文件，可依次调用以回放同一交易日滚动出的多个文件，节奏保持连续
+     *
+     * @param path 文件路径，格式根据文件头自动识别
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int run(const char *path);
+
+    /**
+     * @brief 通知回放提前结束，可在其他线程中调用
+     */
+    void stop() { m_stop.store(true); }
+
+    /**
+     * @brief 已分发的报文数
+     */
+    uint64_t get_dispatched() const { return m_dispatched; }
+
+    /**
+     * @brief 未匹配任何通道或格式无法识别而跳过的报文数
+     */
+    uint64_t get_skipped() const { return m_skipped; }
+
+private:
+    /**
+     * @brief 回放通道
+     */
+    struct channel_t
+    {
+        uint16 channel_id;  ///< 日志通道号
+        uint32 mc_addr;     ///< 组播地址（网络字节序）
+        uint16 mc_port;     ///< 组播端口
+        mc_data_cb_t cb;    ///< 数据回调
+        void *ctx;          ///< 回调上下文
+    };
+
+    int run_journal(const char *data, uint64_t len);
+    int run_pcap(const char *data, uint64_t len);
+    int run_pcapng(const char *data, uint64_t len);
+
+    /**
+     * @brief 解析链路层帧，取出UDP负载后分发
+     *
+     * @param link_type pcap链路类型
+     * @param frame 帧数据
+     * @param len 帧长度
+     * @param ts_ns 抓包时间(ns)
+     */
+    void dispatch_frame(uint32 link_type, const char *frame, uint32 len, uint64_t ts_ns);
+
+    /**
+     * @brief 按回放速度等待后调用通道回调
+     */
+    void dispatch(const channel_t *channel, const char *buf, int len, uint64_t ts_ns);
+
+    /**
+     * @brief 按回放速度等待到ts_ns对应的时刻
+     */
+    void pace(uint64_t ts_ns);
+
+private:
+    std::vector<channel_t> m_channels;  ///< 回放通道
+    double m_speed;                     ///< 回放速度
+    std::atomic<bool> m_stop;           ///< 停止标志
+
+    bool m_paced;                       ///< 是否已确定节奏基准
+    uint64_t m_first_ts;                ///< 第一个报文的时间戳(ns)
+    uint64_t m_start_mono;              ///< 回放开始的单调时钟(ns)
+
+    uint64_t m_dispatched;              ///< 已分发的报文数
+    uint64_t m_skipped;                 ///< 跳过的报文数
+};
+
+#endif
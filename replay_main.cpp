@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "replay.h"
+#include "mdp_decoder.h"
+#include "print_handler.h"
+#include "ins_table.h"
+#include "order_book.h"
+#include "bar_table.h"
+#include "tick_store.h"
+#include "quote_merge.h"
+
+/**
+ * 离线回放工具：将录制日志或抓包文件回放到解码器，统计解码速度
+ *
+ * 用法：mdp_replay [-s speed] [-v] [-f list] [-b intervals] [-t dir] [-q] file...
+ *   -s speed      回放速度，0表示尽快回放（默认），1表示原始节奏，2表示两倍速
+ *   -v            打印解码后的行情
+ *   -f list       只解码订阅的合约，逗号分隔，如"SR,CF505,#2"（品种、合约、合约类型）
+ *   -b intervals  按一档行情聚合K线并打印，周期秒数逗号分隔，如"1,60"
+ *   -t dir        将一档、五档行情按合约写入列存文件，目录结构见tick_store_t
+ *   -q            按合约合并一档成交和五档盘口并打印，过期和重复的消息不打印
+ */
+
+const uint16 channel_id1 = 1;               //一档行情通道号
+const char mc_ip1[] = "239.26.1.1";         //一档行情组播地址
+const unsigned int mc_port1 = 23001;        //一档行情组播端口
+
+const uint16 channel_id2 = 5;               //五档行情通道号
+const char mc_ip2[] = "239.27.1.1";         //五档行情组播地址
+const unsigned int mc_port2 = 23005;        //五档行情组播端口
+
+typedef mdp_handler_pair_t<ins_table_t, book_table_t> table_chain_t;
+typedef mdp_handler_pair_t<table_chain_t, bar_table_t> bar_chain_t;
+typedef mdp_handler_pair_t<bar_chain_t, tick_feed_t> store_chain_t;
+typedef mdp_handler_pair_t<store_chain_t, quote_merge_input_t> state_chain_t;
+typedef mdp_handler_pair_t<state_chain_t, print_handler_t> print_chain_t;
+typedef mdp_decoder_t<print_chain_t> print_decoder_t;
+typedef mdp_decoder_t<state_chain_t> state_decoder_t;
+
+/**
+ * @brief 打印已完成的K线，ctx为一档行情的合约表
+ */
+static void print_bar(void *ctx, uint16 ins_idx, int interval, const bar_t &bar)
+{
+    const ins_info_t &info = ((const ins_table_t *)ctx)->get(ins_idx).info.data();
+
+    char open[32], high[32], low[32], close[32], turnover[32];
+    bar.open_price().format(open, sizeof(open));
+    bar.high_price().format(high, sizeof(high));
+    bar.low_price().format(low, sizeof(low));
+    bar.close_price().format(close, sizeof(close));
+    bar.turnover().format(turnover, sizeof(turnover));
+    printf("bar %s %ds %02u:%02u:%02u open = %s high = %s low = %s close = %s volume = %d turnover = %s ticks = %u\n",
+            info.ins_id, interval, bar.start / 3600, bar.start / 60 % 60, bar.start % 60,
+            open, high, low, close, bar.volume, turnover, bar.tick_cnt);
+}
+
+/**
+ * @brief 打印合并行情，ctx为一档行情的合约表
+ */
+static void print_quote(void *ctx, const merged_quote_t &quote)
+{
+    const ins_info_t &info = ((const ins_table_t *)ctx)->get(quote.ins_idx).info.data();
+
+    char last[32], bid[32], ask[32];
+    quote.last_price().format(last, sizeof(last));
+    quote.bid(0).format(bid, sizeof(bid));
+    quote.ask(0).format(ask, sizeof(ask));
+    long long day_sec = quote.time_us / 1000000;
+    printf("quote %s %02lld:%02lld:%02lld.%06lld %s last = %s volume = %d bid = %s x %d ask = %s x %d seq = %u\n",
+            info.ins_id, day_sec / 3600, day_sec / 60 % 60, day_sec % 60, quote.time_us % 1000000,
+            quote.update & QUOTE_UPD_TRADE ? "trade" : "depth", last, quote.volume,
+            bid, quote.bid_qty[0], ask, quote.ask_qty[0], quote.seq);
+}
+
+int main(int argc, char *argv[])
+{
+    double speed = 0;
+    bool verbose = false;
+    const char *sub_list = NULL;
+    int intervals[BAR_MAX_INTERVAL_NUM];
+    int interval_num = 0;
+    const char *tick_dir = NULL;
+    bool merge_quotes = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:vf:b:t:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            speed = atof(optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'f':
+            sub_list = optarg;
+            break;
+        case 'b':
+            for (char *item = strtok(optarg, ","); item != NULL; item = strtok(NULL, ","))
+            {
+                if (interval_num == BAR_MAX_INTERVAL_NUM)
+                {
+                    printf("at most %d bar intervals\n", BAR_MAX_INTERVAL_NUM);
+                    return -1;
+                }
+                intervals[interval_num++] = atoi(item);
+            }
+            break;
+        case 't':
+            tick_dir = optarg;
+            break;
+        case 'q':
+            merge_quotes = true;
+            break;
+        default:
+            printf("usage: %s [-s speed] [-v] [-f list] [-b intervals] [-t dir] [-q] file...\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        printf("usage: %s [-s speed] [-v] [-f list] [-b intervals] [-t dir] [-q] file...\n", argv[0]);
+        return -1;
+    }
+
+    ins_table_t table1, table2;
+    book_table_t books1, books2;
+    if (table1.init() != 0 || table2.init() != 0 || books1.init() != 0 || books2.init() != 0)
+    {
+        return -2;
+    }
+
+    // K线只按一档行情聚合，五档通道的K线表不初始化，收到行情时直接返回
+    bar_table_t bars1, bars2;
+    if (interval_num > 0)
+    {
+        if (bars1.init(intervals, interval_num) != 0)
+        {
+            return -2;
+        }
+        bars1.set_bar_cb(print_bar, &table1);
+    }
+
+    // 不写列存时两个通道接入空队列，收到行情时直接返回
+    tick_store_t store;
+    tick_feed_t idle_feed1("l1", 0), idle_feed2("l5", 0);
+    tick_feed_t *feed1 = &idle_feed1, *feed2 = &idle_feed2;
+    if (tick_dir != NULL)
+    {
+        feed1 = store.add_feed("l1");
+        feed2 = store.add_feed("l5");
+        if (feed1 == NULL || feed2 == NULL || store.start(tick_dir) != 0)
+        {
+            return -2;
+        }
+    }
+
+    // 合并器未初始化时输入直接返回
+    quote_merger_t merger;
+    if (merge_quotes)
+    {
+        if (merger.init() != 0)
+        {
+            return -2;
+        }
+        merger.set_quote_cb(print_quote, &table1);
+    }
+
+    table_chain_t tables1(table1, books1), tables2(table2, books2);
+    bar_chain_t bar_chain1(tables1, bars1), bar_chain2(tables2, bars2);
+    store_chain_t store_chain1(bar_chain1, *feed1), store_chain2(bar_chain2, *feed2);
+    state_chain_t state1(store_chain1, merger.input(0)), state2(store_chain2, merger.input(1));
+    print_handler_t printer1, printer2;
+    print_chain_t print_chain1(state1, printer1), print_chain2(state2, printer2);
+    print_decoder_t print_decoder1(print_chain1), print_decoder2(print_chain2);
+    state_decoder_t state_decoder1(state1), state_decoder2(state2);
+
+    // 两个通道各自解析订阅位图
+    subscription_t sub1, sub2;
+    if (sub_list != NULL)
+    {
+        if (sub1.parse(sub_list) < 0 || sub2.parse(sub_list) < 0)
+        {
+            return -4;
+        }
+        print_decoder1.set_subscription(&sub1);
+        print_decoder2.set_subscription(&sub2);
+        state_decoder1.set_subscription(&sub1);
+        state_decoder2.set_subscription(&sub2);
+    }
+
+    replay_t replay;
+    replay.set_speed(speed);
+    if (verbose)
+    {
+        replay.add_channel(channel_id1, mc_ip1, mc_port1, &print_decoder_t::data_cb, &print_decoder1);
+        replay.add_channel(channel_id2, mc_ip2, mc_port2, &print_decoder_t::data_cb, &print_decoder2);
+    }
+    else
+    {
+        replay.add_channel(channel_id1, mc_ip1, mc_port1, &state_decoder_t::data_cb, &state_decoder1);
+        replay.add_channel(channel_id2, mc_ip2, mc_port2, &state_decoder_t::data_cb, &state_decoder2);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = optind; i < argc; i++)
+    {
+        if (replay.run(argv[i]) != 0)
+        {
+            return -3;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bars1.flush();
+    store.stop();
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("datagrams dispatched = %lu, skipped = %lu, elapsed = %.3f s, %.0f datagrams/s\n",
+            (unsigned long)replay.get_dispatched(), (unsigned long)replay.get_skipped(), elapsed,
+            elapsed > 0 ? replay.get_dispatched() / elapsed : 0.0);
+    printf("instruments: level 1 = %d, level 5 = %d\n", table1.get_count(), table2.get_count());
+    if (sub_list != NULL)
+        printf("subscribed: level 1 = %d, level 5 = %d\n", sub1.get_count(), sub2.get_count());
+    if (interval_num > 0)
+        printf("bars: instruments = %d, dropped = %lu\n", bars1.get_count(), (unsigned long)bars1.get_dropped());
+    if (merge_quotes)
+        printf("quotes: level 1 = %lu, level 5 = %lu, suppressed: level 1 = %lu, level 5 = %lu\n",
+                (unsigned long)merger.get_emitted(0), (unsigned long)merger.get_emitted(1),
+                (unsigned long)merger.get_suppressed(0), (unsigned long)merger.get_suppressed(1));
+
+    return 0;
+}
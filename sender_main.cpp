@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "pkt_gen.h"
+#include "tsc_clock.h"
+
+/**
+ * 模拟行情发送工具：向组播组发送pkt_gen_t生成的报文，用于在回环网卡或veth上本地测试接收
+ *
+ * 用法：mdp_sender [-g group] [-p port] [-i if_ip] [-n count] [-r pps] [-s seed]
+ */
+
+static void usage(const char *prog)
+{
+    printf("usage: %s [-g group] [-p port] [-i if_ip] [-n count] [-r pps] [-s seed]\n", prog);
+    printf("  -g group   组播地址，默认239.26.1.1\n");
+    printf("  -p port    组播端口，默认23001\n");
+    printf("  -i if_ip   发送网卡IP，默认127.0.0.1\n");
+    printf("  -n count   发送的UDP包个数，默认10000\n");
+    printf("  -r pps     每秒发送的UDP包个数，0表示不限速，默认10000\n");
+    printf("  -s seed    随机种子，默认1\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *group = "239.26.1.1";
+    int port = 23001;
+    const char *if_ip = "127.0.0.1";
+    long count = 10000;
+    long pps = 10000;
+    unsigned long long seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "g:p:i:n:r:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g': group = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 'i': if_ip = optarg; break;
+        case 'n': count = atol(optarg); break;
+        case 'r': pps = atol(optarg); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        perror("create socket");
+        return -2;
+    }
+
+    struct in_addr if_addr;
+    if_addr.s_addr = inet_addr(if_ip);
+    if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &if_addr, sizeof(if_addr)) != 0)
+    {
+        perror("set multicast interface");
+        return -2;
+    }
+
+    // 回环网卡上需要本机收到自己发出的组播
+    int loop = 1;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    struct sockaddr_in dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.sin_family = AF_INET;
+    dst.sin_addr.s_addr = inet_addr(group);
+    dst.sin_port = htons(port);
+
+    pkt_gen_t gen(seed);
+    char buf[1400];
+
+    // 先发送一轮合约索引，其后单腿+深度行情为主，夹杂其他类型
+    int len = gen.build_datagram(buf, sizeof(buf), PACKAGE_INSTRUMENT_IDX, 1, 50);
+    uint64_t start_ns = monotonic_ns();
+    long sent = 0;
+    for (long i = 0; i < count; i++)
+    {
+        if (i > 0)
+        {
+            uint32 kind = i % 100;
+            if (kind == 0)
+                len = gen.build_datagram(buf, sizeof(buf), PACKAGE_TRADE_STATUS, 1, 1);
+            else if (kind == 1)
+                len = gen.build_datagram(buf, sizeof(buf), PACKAGE_BULLETINE, 1, 1);
+            else if (kind < 5)
+                len = gen.build_datagram(buf, sizeof(buf), PACKAGE_QUOT_REQ, 1, 2);
+            else if (kind < 15)
+                len = gen.build_datagram(buf, sizeof(buf), PACKAGE_CMBTYPE, 1, 5);
+            else
+                len = gen.build_mixed(buf, sizeof(buf), 5);
+        }
+
+        if (sendto(fd, buf, len, 0, (struct sockaddr *)&dst, sizeof(dst)) == len)
+            sent++;
+
+        if (pps > 0)
+        {
+            uint64_t due_ns = start_ns + (uint64_t)((i + 1) * 1e9 / pps);
+            while (monotonic_ns() < due_ns)
+                ;
+        }
+    }
+
+    double secs = (monotonic_ns() - start_ns) / 1e9;
+    printf("sent %ld datagrams in %.3f s\n", sent, secs);
+    close(fd);
+    return 0;
+}
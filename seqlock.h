@@ -0,0 +1,151 @@
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <atomic>
+#include <memory.h>
+#include <stdint.h>
+
+/**
+ * @brief 自旋等待时让出流水线资源
+ */
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * @brief 单写多读顺序锁
+ *
+ * 写线程修改前后各递增一次序号（奇数表示正在写），从不加锁也不等待读者；
+ * 少数需要多个写线程的场合用lock_write()在写线程之间互斥；
+ * 读线程复制数据前后比较序号，发现被并发修改则重试。
+ * T必须可以按字节复制。全0内存即为合法的初始状态，可直接放在mmap/共享内存中。
+ */
+template <typename T>
+class seqlock_t
+{
+public:
+    seqlock_t() : m_seq(0) {}
+
+    /**
+     * @brief 开始写入，返回可直接修改的数据，仅限唯一的写线程调用
+     */
+    T &begin_write()
+    {
+        m_seq.store(m_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return m_data;
+    }
+
+    /**
+     * @brief 结束写入，之后读者可以读到完整数据
+     */
+    void end_write()
+    {
+        m_seq.store(m_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 多个写线程时代替begin_write()开始写入，写线程之间自旋互斥，读者不受影响
+     *
+     * 同一对象的所有写线程都必须使用lock_write()，写入结束调用end_write()或cancel_write()。
+     */
+    T &lock_write()
+    {
+        uint32_t seq = m_seq.load(std::memory_order_relaxed);
+        while ((seq & 1) || !m_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                    std::memory_order_relaxed))
+        {
+            cpu_relax();
+            seq = m_seq.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return m_data;
+    }
+
+    /**
+     * @brief 放弃本次写入，数据必须未被修改；序号恢复原值，读者视为没有发生写入
+     */
+    void cancel_write()
+    {
+        m_seq.store(m_seq.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 整体写入
+     */
+    void write(const T &data)
+    {
+        begin_write() = data;
+        end_write();
+    }
+
+    /**
+     * @brief 把数据清为全0，序号继续递增而不是归零，正在读取的读者会发现变化并重试
+     */
+    void reset()
+    {
+        memset((void *)&begin_write(), 0, sizeof(T));
+        end_write();
+    }
+
+    /**
+     * @brief 复制一份一致的数据，可在任意线程调用
+     *
+     * @param out 输出数据
+     */
+    void read(T &out) const
+    {
+        read_with([&out](const T &data) { memcpy((void *)&out, (const void *)&data, sizeof(T)); });
+    }
+
+    /**
+     * @brief 以一致的视图调用复制函数，可只复制需要的部分字段
+     *
+     * @param copy_fn 形如void(const T &)的函数，被并发修改时会重复调用，
+     *                只应复制数据，不应有其他副作用
+     *
+     * @return 读取时的序号，序号/2即写入次数
+     */
+    template <typename func_t>
+    uint32_t read_with(func_t copy_fn) const
+    {
+        uint32_t seq0, seq1;
+        do
+        {
+            seq0 = m_seq.load(std::memory_order_acquire);
+            while (seq0 & 1)
+            {
+                cpu_relax();
+                seq0 = m_seq.load(std::memory_order_acquire);
+            }
+
+            copy_fn(m_data);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq1 = m_seq.load(std::memory_order_relaxed);
+        } while (seq0 != seq1);
+
+        return seq0;
+    }
+
+    /**
+     * @brief 直接访问数据，仅限写线程自身使用
+     */
+    const T &data() const { return m_data; }
+
+    /**
+     * @brief 获取当前序号
+     */
+    uint32_t get_seq() const { return m_seq.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> m_seq;  ///< 序号，奇数表示写入中
+    T m_data;                     ///< 受保护的数据
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm_bus.h"
+
+#define SHM_PAGE_SIZE 4096
+
+/**
+ * @brief 按页对齐
+ */
+static uint64_t page_align(uint64_t size)
+{
+    return (size + SHM_PAGE_SIZE - 1) & ~(uint64_t)(SHM_PAGE_SIZE - 1);
+}
+
+/**
+ * @brief 各类型事件在shm_event_t中实际占用的长度，读取时只复制这部分
+ */
+static size_t shm_event_size(uint8 msg_type)
+{
+    size_t head = offsetof(shm_event_t, idx);
+    switch (msg_type)
+    {
+    case PACKAGE_INSTRUMENT_IDX:  return head + sizeof(mdp_idx_event_t);
+    case PACKAGE_INSTRUMENT_INIT: return head + sizeof(mdp_init_event_t);
+    case PACKAGE_INSTRUMENT:      return head + sizeof(mdp_tick_event_t);
+    case PACKAGE_CMBTYPE:         return head + sizeof(mdp_cmb_event_t);
+    case PACKAGE_QUOT_REQ:        return head + sizeof(mdp_quot_req_event_t);
+    case PACKAGE_TRADE_STATUS:    return head + sizeof(mdp_trade_status_event_t);
+    case PACKAGE_DEPTH:           return head + sizeof(mdp_depth_event_t);
+    default:                      return sizeof(shm_event_t);
+    }
+}
+
+shm_publisher_t::shm_publisher_t()
+{
+    m_base = NULL;
+    m_size = 0;
+    m_header = NULL;
+    m_ring = NULL;
+    m_ring_mask = 0;
+    m_write_pos = 0;
+}
+
+shm_publisher_t::~shm_publisher_t()
+{
+    if (m_base != NULL)
+        munmap(m_base, m_size);
+}
+
+int shm_publisher_t::init(const char *name, uint32 ring_size)
+{
+    if (m_base != NULL)
+    {
+        printf("shared memory bus has been created!\n");
+        return -1;
+    }
+
+    if (ring_size == 0 || (ring_size & (ring_size - 1)) != 0)
+    {
+        printf("shared memory ring size must be power of 2: %u\n", ring_size);
+        return -1;
+    }
+
+    // 删除旧区域后重建：仍映射旧区域的读者不受影响，可通过会话标识发现变化
+    if (shm_unlink(name) != 0 && errno != ENOENT)
+    {
+        perror("unlink shared memory");
+        return -2;
+    }
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        perror("create shared memory");
+        return -2;
+    }
+
+    uint64_t table_offset = page_align(sizeof(shm_header_t));
+    uint64_t book_offset = table_offset + page_align(ins_table_t::mem_size());
+    uint64_t ring_offset = book_offset + page_align(book_table_t::mem_size());
+    uint64_t total_size = ring_offset + page_align((uint64_t)ring_size * sizeof(shm_slot_t));
+
+    if (ftruncate(fd, total_size) != 0)
+    {
+        perror("resize shared memory");
+        close(fd);
+        shm_unlink(name);
+        return -3;
+    }
+
+    void *mem = mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap shared memory");
+        shm_unlink(name);
+        return -4;
+    }
+
+    m_name = name;
+    m_base = (char *)mem;
+    m_size = total_size;
+    m_header = (shm_header_t *)m_base;
+    m_ring = (shm_slot_t *)(m_base + ring_offset);
+    m_ring_mask = ring_size - 1;
+    m_write_pos = 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    m_header->version = SHM_BUS_VERSION;
+    m_header->ring_size = ring_size;
+    m_header->table_size = INS_TABLE_SIZE;
+    m_header->table_offset = table_offset;
+    m_header->book_offset = book_offset;
+    m_header->ring_offset = ring_offset;
+    m_header->total_size = total_size;
+    m_header->session_id = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    m_header->writer_pid = getpid();
+
+    // magic最后写入，读者看到magic即可认为布局信息完整
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = SHM_BUS_MAGIC;
+
+    printf("Shared memory bus %s created, size = %lu, ring size = %u\n",
+            name, (unsigned long)total_size, ring_size);
+    return 0;
+}
+
+void *shm_publisher_t::get_table_mem() const
+{
+    return m_base == NULL ? NULL : m_base + m_header->table_offset;
+}
+
+void *shm_publisher_t::get_book_mem() const
+{
+    return m_base == NULL ? NULL : m_base + m_header->book_offset;
+}
+
+void shm_publisher_t::on_bulletine(const mdp_bulletine_event_t &ev)
+{
+    if (m_ring == NULL)
+        return;
+
+    shm_event_t &slot_ev = begin_publish(PACKAGE_BULLETINE);
+    int text_len = ev.text_len < SHM_BULLETINE_LEN ? ev.text_len : SHM_BULLETINE_LEN;
+    slot_ev.bulletine.ev.msg_seq = ev.msg_seq;
+    slot_ev.bulletine.ev.text = NULL;
+    slot_ev.bulletine.ev.text_len = text_len;
+    memcpy(slot_ev.bulletine.text, ev.text, text_len);
+    end_publish();
+}
+
+shm_reader_t::shm_reader_t()
+{
+    m_base = NULL;
+    m_size = 0;
+    m_header = NULL;
+    m_ring = NULL;
+    m_ring_size = 0;
+    m_read_pos = 0;
+    m_lost = 0;
+    m_session_id = 0;
+    m_ino = 0;
+}
+
+shm_reader_t::~shm_reader_t()
+{
+    if (m_base != NULL)
+        munmap(m_base, m_size);
+}
+
+int shm_reader_t::open(const char *name, bool from_start)
+{
+    if (m_base != NULL)
+    {
+        printf("shared memory bus has been opened!\n");
+        return -1;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        perror("open shared memory");
+        return -2;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_header_t))
+    {
+        printf("shared memory %s is not ready\n", name);
+        ::close(fd);
+        return -4;
+    }
+
+    void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap shared memory");
+        return -3;
+    }
+
+    const shm_header_t *header = (const shm_header_t *)mem;
+    if (header->magic != SHM_BUS_MAGIC)
+    {
+        printf("shared memory %s is not ready\n", name);
+        munmap(mem, st.st_size);
+        return -4;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (header->version != SHM_BUS_VERSION || header->table_size != INS_TABLE_SIZE
+            || header->total_size != (uint64_t)st.st_size)
+    {
+        printf("shared memory %s layout mismatch, version = %u\n", name, header->version);
+        munmap(mem, st.st_size);
+        return -5;
+    }
+
+    m_base = (char *)mem;
+    m_size = st.st_size;
+    m_header = header;
+    m_ring = (const shm_slot_t *)(m_base + header->ring_offset);
+    m_ring_size = header->ring_size;
+    m_session_id = header->session_id;
+    m_name = name;
+    m_ino = st.st_ino;
+    m_lost = 0;
+
+    // 只读映射，两张表只会用到其中的读接口
+    m_table.init(m_base + header->table_offset);
+    m_books.init(m_base + header->book_offset);
+
+    uint64_t write_pos = m_header->write_pos.load(std::memory_order_acquire);
+    if (from_start)
+        m_read_pos = write_pos > m_ring_size ? write_pos - m_ring_size : 0;
+    else
+        m_read_pos = write_pos;
+
+    return 0;
+}
+
+int shm_reader_t::poll(shm_event_t &ev)
+{
+    const shm_slot_t &slot = m_ring[m_read_pos & (m_ring_size - 1)];
+    uint64_t expect = m_read_pos * 2 + 2;
+
+    uint64_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq < expect)
+        return 0;  // 尚未写入或正在写入
+
+    if (seq == expect)
+    {
+        uint8 msg_type = slot.ev.msg_type;
+        memcpy((void *)&ev, (const void *)&slot.ev, shm_event_size(msg_type));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == expect && ev.msg_type == msg_type)
+        {
+            if (msg_type == PACKAGE_BULLETINE)
+                ev.bulletine.ev.text = ev.bulletine.text;
+            m_read_pos++;
+            return 1;
+        }
+    }
+
+    // 槽位已被更新的事件覆盖，跳到落后最新位置半个环处继续，留出余量避免再次被追上；
+    // 读取位置不需要前移时只是读到正在改写的槽位，由调用方重试
+    uint64_t write_pos = m_header->write_pos.load(std::memory_order_acquire);
+    uint64_t new_pos = write_pos > m_ring_size / 2 ? write_pos - m_ring_size / 2 : 0;
+    if (new_pos <= m_read_pos)
+        return 0;
+
+    m_lost += new_pos - m_read_pos;
+    m_read_pos = new_pos;
+    return -1;
+}
+
+bool shm_reader_t::is_stale() const
+{
+    if (m_base == NULL)
+        return false;
+
+    int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return errno == ENOENT;
+
+    struct stat st;
+    bool stale = fstat(fd, &st) == 0 && st.st_ino != m_ino;
+    ::close(fd);
+    return stale;
+}
@@ -0,0 +1,246 @@
+#ifndef SHM_BUS_H_
+#define SHM_BUS_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <string>
+
+#include "ins_table.h"
+#include "order_book.h"
+
+#define SHM_BUS_MAGIC           0x455A435A  ///< "ZCZE"
+#define SHM_BUS_VERSION         1
+#define SHM_DEFAULT_RING_SIZE   16384       ///< 默认事件环槽位数，必须为2的幂
+#define SHM_BULLETINE_LEN       440         ///< 事件环中告示内容最大长度，超出部分截断
+
+/**
+ * @brief 共享内存区头部
+ *
+ * 区域布局：头部 | 合约表(ins_table_t) | 盘口表(book_table_t) | 事件环(shm_slot_t)
+ */
+struct alignas(CACHE_LINE_SIZE) shm_header_t
+{
+    uint32 magic;                       ///< 初始化完成后写入SHM_BUS_MAGIC
+    uint32 version;                     ///< 布局版本
+    uint32 ring_size;                   ///< 事件环槽位数
+    uint32 table_size;                  ///< 合约表容量
+    uint64_t table_offset;              ///< 合约表偏移
+    uint64_t book_offset;               ///< 盘口表偏移
+    uint64_t ring_offset;               ///< 事件环偏移
+    uint64_t total_size;                ///< 区域总大小
+    uint64_t session_id;                ///< 发布端创建区域的时间(ns)，发布端重启后变化
+    int writer_pid;                     ///< 发布进程号
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> write_pos;  ///< 下一个写入位置
+    std::atomic<uint32> trade_date;     ///< 当前交易日
+};
+
+/**
+ * @brief 事件环中的一条事件
+ */
+struct shm_event_t
+{
+    uint8 msg_type;     ///< 报文类型，PACKAGE_*
+    uint8 reserved[7];
+    union
+    {
+        mdp_idx_event_t idx;
+        mdp_init_event_t init;
+        mdp_tick_event_t tick;
+        mdp_cmb_event_t cmb;
+        mdp_quot_req_event_t quot_req;
+        mdp_trade_status_event_t trade_status;
+        mdp_depth_event_t depth;
+        struct
+        {
+            mdp_bulletine_event_t ev;        ///< ev.text在读出后指向text
+            char text[SHM_BULLETINE_LEN];    ///< 告示内容
+        } bulletine;
+    };
+};
+
+/**
+ * @brief 事件环槽位
+ *
+ * seq为pos*2+1表示位置pos正在写入，pos*2+2表示位置pos已写完。
+ */
+struct alignas(CACHE_LINE_SIZE) shm_slot_t
+{
+    std::atomic<uint64_t> seq;  ///< 槽位序号
+    shm_event_t ev;             ///< 事件
+};
+
+/**
+ * @brief 共享内存行情发布端
+ *
+ * 创建POSIX共享内存区，合约表和盘口表直接建在共享内存上（由调用方通过
+ * ins_table_t::init(get_table_mem())等方式挂接），本对象作为处理器把解码事件
+ * 写入广播事件环。每个区域只允许一个写线程，多个通道应分别创建区域。
+ */
+class shm_publisher_t : public mdp_null_handler_t
+{
+public:
+    shm_publisher_t();
+    ~shm_publisher_t();
+
+    /**
+     * @brief 创建共享内存区，已存在的同名区域会被删除重建
+     *
+     * @param name 共享内存名称，如"/czce_md_l1"
+     * @param ring_size 事件环槽位数，必须为2的幂
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int init(const char *name, uint32 ring_size = SHM_DEFAULT_RING_SIZE);
+
+    /**
+     * @brief 共享内存中合约表的存储区，供ins_table_t::init()使用
+     */
+    void *get_table_mem() const;
+
+    /**
+     * @brief 共享内存中盘口表的存储区，供book_table_t::init()使用
+     */
+    void *get_book_mem() const;
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev)
+    {
+        if (m_header != NULL && ev.msg_idx == 0)
+            m_header->trade_date.store(ev.trade_date, std::memory_order_release);
+        publish(PACKAGE_INSTRUMENT_IDX, &shm_event_t::idx, ev);
+    }
+    void on_instrument_init(const mdp_init_event_t &ev) { publish(PACKAGE_INSTRUMENT_INIT, &shm_event_t::init, ev); }
+    void on_instrument(const mdp_tick_event_t &ev) { publish(PACKAGE_INSTRUMENT, &shm_event_t::tick, ev); }
+    void on_cmbtype(const mdp_cmb_event_t &ev) { publish(PACKAGE_CMBTYPE, &shm_event_t::cmb, ev); }
+    void on_quot_req(const mdp_quot_req_event_t &ev) { publish(PACKAGE_QUOT_REQ, &shm_event_t::quot_req, ev); }
+    void on_trade_status(const mdp_trade_status_event_t &ev) { publish(PACKAGE_TRADE_STATUS, &shm_event_t::trade_status, ev); }
+    void on_depth(const mdp_depth_event_t &ev) { publish(PACKAGE_DEPTH, &shm_event_t::depth, ev); }
+    void on_bulletine(const mdp_bulletine_event_t &ev);
+
+private:
+    /**
+     * @brief 开始写入下一个槽位
+     */
+    shm_event_t &begin_publish(uint8 msg_type)
+    {
+        shm_slot_t &slot = m_ring[m_write_pos & m_ring_mask];
+        slot.seq.store(m_write_pos * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.ev.msg_type = msg_type;
+        return slot.ev;
+    }
+
+    /**
+     * @brief 结束写入，读者可见
+     */
+    void end_publish()
+    {
+        m_ring[m_write_pos & m_ring_mask].seq.store(m_write_pos * 2 + 2, std::memory_order_release);
+        m_write_pos++;
+        m_header->write_pos.store(m_write_pos, std::memory_order_release);
+    }
+
+    /**
+     * @brief 将事件复制到事件环，未初始化时不做任何事
+     */
+    template <typename event_t>
+    void publish(uint8 msg_type, event_t shm_event_t::*member, const event_t &ev)
+    {
+        if (m_ring == NULL)
+            return;
+        begin_publish(msg_type).*member = ev;
+        end_publish();
+    }
+
+private:
+    std::string m_name;         ///< 共享内存名称
+    char *m_base;               ///< 映射基址
+    size_t m_size;              ///< 映射大小
+    shm_header_t *m_header;     ///< 区域头部
+    shm_slot_t *m_ring;         ///< 事件环
+    uint64_t m_ring_mask;       ///< 槽位掩码
+    uint64_t m_write_pos;       ///< 下一个写入位置（写线程私有副本）
+};
+
+/**
+ * @brief 共享内存行情读取端
+ *
+ * 以只读方式映射发布端创建的区域。poll()从事件环中按序取出事件，
+ * read_*()/get_*()读取合约表和盘口的一致快照，均不产生系统调用。
+ * 每个读取端各自维护读取位置，互不影响，也不会阻塞发布端；
+ * 读取过慢被覆盖时丢弃中间事件并从最新位置附近继续。
+ */
+class shm_reader_t
+{
+public:
+    shm_reader_t();
+    ~shm_reader_t();
+
+    /**
+     * @brief 打开共享内存区，每个读取端对象只能打开一次
+     *
+     * @param name 共享内存名称
+     * @param from_start true：从事件环中最早仍有效的事件开始读；false：只读之后的新事件
+     *
+     * @return 0：成功；其他：错误码，发布端尚未完成初始化时返回-4，可稍后重试
+     */
+    int open(const char *name, bool from_start = false);
+
+    /**
+     * @brief 取出下一个事件
+     *
+     * @param ev 输出的事件，告示事件的text指向ev内部
+     *
+     * @return 1：取到事件；0：暂无新事件，或读取期间槽位正被改写，可再次调用；
+     *         -1：读取过慢已丢失事件，读取位置已前移
+     */
+    int poll(shm_event_t &ev);
+
+    /**
+     * @brief 累计丢失的事件数
+     */
+    uint64_t get_lost() const { return m_lost; }
+
+    /**
+     * @brief 当前交易日
+     */
+    uint32 get_trade_date() const { return m_header->trade_date.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 所映射区域的会话标识，打开后不再变化；发布端是否已重建区域用is_stale()检查
+     */
+    uint64_t get_session_id() const { return m_session_id; }
+
+    /**
+     * @brief 检查同名区域是否已被发布端删除或重建
+     *
+     * 发布端重启时删除旧区域后重新创建，仍映射旧区域的读者收不到任何新事件。
+     * 本函数按名称重新打开并比较区域的inode，有系统调用，应低频调用（如每秒一次）。
+     *
+     * @return true：映射的区域已失效，应使用新的读取端对象重新open()
+     */
+    bool is_stale() const;
+
+    bool read_info(uint16 ins_idx, ins_info_t &info) const { return m_table.read_info(ins_idx, info); }
+    bool read_l1(uint16 ins_idx, ins_l1_t &l1) const { return m_table.read_l1(ins_idx, l1); }
+    uint32 get_top(uint16 ins_idx, book_top_t &top) const { return m_books.get_top(ins_idx, top); }
+    uint32 get_depth(uint16 ins_idx, order_book_t &book) const { return m_books.get_depth(ins_idx, book); }
+
+private:
+    char *m_base;               ///< 映射基址
+    size_t m_size;              ///< 映射大小
+    const shm_header_t *m_header;  ///< 区域头部
+    const shm_slot_t *m_ring;   ///< 事件环
+    uint64_t m_ring_size;       ///< 槽位数
+    uint64_t m_read_pos;        ///< 下一个读取位置
+    uint64_t m_lost;            ///< 丢失的事件数
+    uint64_t m_session_id;      ///< 打开时的会话标识
+    std::string m_name;         ///< 共享内存名称
+    ino_t m_ino;                ///< 打开时区域的inode
+    ins_table_t m_table;        ///< 挂接在共享内存上的合约表（只读）
+    book_table_t m_books;       ///< 挂接在共享内存上的盘口表（只读）
+};
+
+#endif
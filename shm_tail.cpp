@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <signal.h>
+#include <time.h>
+
+#include "shm_bus.h"
+#include "symbol_index.h"
+
+/**
+ * 共享内存行情读取示例：统计每秒各类型事件数，可选打印指定合约的最新行情和盘口
+ *
+ * 用法：mdp_shm_tail <shm_name> [ins_idx|symbol]
+ */
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int)
+{
+    g_stop = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <shm_name> [ins_idx|symbol]\n", argv[0]);
+        return -1;
+    }
+
+    // 以数字开头的参数为合约索引，否则为合约编码，按共享表中的合约索引查找
+    const char *watch_symbol = argc > 2 && !isdigit((unsigned char)argv[2][0]) ? argv[2] : NULL;
+    int watch_idx = argc > 2 && watch_symbol == NULL ? atoi(argv[2]) : -1;
+    uint32 index_date = 0;
+
+    // 发布端重建区域后换用新的读取端对象
+    shm_reader_t *reader = new shm_reader_t();
+    if (reader->open(argv[1]) != 0)
+    {
+        delete reader;
+        return -2;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    unsigned long long type_cnt[256] = {0};
+    unsigned long long total = 0;
+    time_t last_sec = time(NULL);
+    shm_event_t ev;
+
+    while (!g_stop)
+    {
+        int res = reader->poll(ev);
+        if (res == 1)
+        {
+            type_cnt[ev.msg_type]++;
+            total++;
+        }
+        else if (res == 0)
+        {
+            cpu_relax();
+        }
+
+        time_t now = time(NULL);
+        if (now == last_sec)
+            continue;
+        last_sec = now;
+
+        printf("trade date = %u, events = %llu, lost = %llu |", reader->get_trade_date(),
+                total, (unsigned long long)reader->get_lost());
+        for (int i = 0; i < 256; i++)
+        {
+            if (type_cnt[i] != 0)
+                printf(" 0x%02x:%llu", i, type_cnt[i]);
+        }
+        printf("\n");
+
+        if (reader->is_stale())
+        {
+            shm_reader_t *fresh = new shm_reader_t();
+            if (fresh->open(argv[1], true) != 0)
+            {
+                delete fresh;
+                continue;
+            }
+            printf("publisher restarted, session %llu -> %llu\n",
+                    (unsigned long long)reader->get_session_id(), (unsigned long long)fresh->get_session_id());
+            delete reader;
+            reader = fresh;
+            watch_idx = watch_symbol != NULL ? -1 : watch_idx;
+        }
+
+        // 交易日切换后合约索引重新编排，按新交易日的索引重建查找表
+        if (watch_symbol != NULL && (watch_idx < 0 || index_date != reader->get_trade_date()))
+        {
+            index_date = reader->get_trade_date();
+            std::vector<symbol_index_t::entry_t> entries;
+            ins_info_t info;
+            for (int i = 0; i < INS_TABLE_SIZE; i++)
+            {
+                symbol_index_t::entry_t entry;
+                if (reader->read_info(i, info) && symbol_index_t::make_key(info.ins_id, entry.key))
+                {
+                    entry.ins_idx = i;
+                    entries.push_back(entry);
+                }
+            }
+
+            symbol_index_t index;
+            watch_idx = index.build(entries) == 0 ? index.find(watch_symbol) : -1;
+            if (watch_idx < 0)
+                printf("  %s not found in %d instruments\n", watch_symbol, index.get_count());
+        }
+
+        if (watch_idx >= 0)
+        {
+            ins_info_t info;
+            ins_l1_t l1;
+            book_top_t top;
+            if (reader->read_info(watch_idx, info) && reader->read_l1(watch_idx, l1))
+            {
+                reader->get_top(watch_idx, top);
+
+                // 按价格精度精确格式化，不经过浮点
+                char last[32], bid[32], ask[32];
+                l1.price(TICK_FLD_LAST).format(last, sizeof(last));
+                top.bid().format(bid, sizeof(bid));
+                top.ask().format(ask, sizeof(ask));
+                printf("  %s last = %s volume = %d bid = %s x %d ask = %s x %d\n", info.ins_id,
+                        last, l1.value[TICK_FLD_VOLUME], bid, top.bid_qty, ask, top.ask_qty);
+            }
+        }
+    }
+
+    delete reader;
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "feed_stats.h"
+
+/**
+ * 行情健康计数查看工具：按固定间隔打印各通道的收包速率、丢包和错误计数
+ *
+ * 用法：mdp_stats <shm_name> [interval_sec]
+ */
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int)
+{
+    g_stop = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <shm_name> [interval_sec]\n", argv[0]);
+        return -1;
+    }
+
+    int interval = argc > 2 ? atoi(argv[2]) : 1;
+    if (interval < 1)
+        interval = 1;
+
+    feed_stats_table_t table;
+    if (table.open(argv[1]) != 0)
+    {
+        return -2;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    unsigned long long last_packets[FEED_STATS_MAX_CHANNEL] = {0};
+    unsigned long long last_bytes[FEED_STATS_MAX_CHANNEL] = {0};
+    unsigned long long last_drops[FEED_STATS_MAX_CHANNEL] = {0};
+
+    while (!g_stop)
+    {
+        for (int i = 0; i < table.get_channel_num(); i++)
+        {
+            const feed_stats_t &stats = table.at(i);
+            unsigned long long packets = stats.packets.load(std::memory_order_relaxed);
+            unsigned long long bytes = stats.bytes.load(std::memory_order_relaxed);
+            unsigned long long drops = stats.rxq_drops.load(std::memory_order_relaxed);
+
+            printf("channel %u %-22s pps = %-8llu Bps = %-10llu new drops = %-6llu | ",
+                    stats.channel_id, stats.name,
+                    (packets - last_packets[i]) / interval,
+                    (bytes - last_bytes[i]) / interval,
+                    drops - last_drops[i]);
+            printf("packets = %llu, kernel drops = %llu, timeouts = %llu, errors = %llu, unknown = %llu, malformed = %llu\n",
+                    packets, drops,
+                    (unsigned long long)stats.timeouts.load(std::memory_order_relaxed),
+                    (unsigned long long)stats.recv_errors.load(std::memory_order_relaxed),
+                    (unsigned long long)stats.unknown_types.load(std::memory_order_relaxed),
+                    (unsigned long long)stats.malformed.load(std::memory_order_relaxed));
+
+            last_packets[i] = packets;
+            last_bytes[i] = bytes;
+            last_drops[i] = drops;
+        }
+
+        sleep(interval);
+    }
+
+    return 0;
+}
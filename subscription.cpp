@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "subscription.h"
+
+subscription_t::subscription_t()
+{
+    memset(m_type_mask, 0, sizeof(m_type_mask));
+    m_has_type = false;
+    memset(m_bits, 0, sizeof(m_bits));
+    memset(m_resolved, 0, sizeof(m_resolved));
+    m_trade_date = 0;
+    m_count = 0;
+}
+
+int subscription_t::add_symbol(const char *symbol)
+{
+    if (symbol == NULL || symbol[0] == '\0' || strlen(symbol) >= MDP_INS_ID_LEN)
+    {
+        printf("invalid subscription symbol: %s\n", symbol == NULL ? "(null)" : symbol);
+        return -1;
+    }
+
+    m_symbols.push_back(symbol);
+    return 0;
+}
+
+int subscription_t::add_product(const char *product)
+{
+    if (product == NULL || product[0] == '\0' || strlen(product) >= MDP_INS_ID_LEN)
+    {
+        printf("invalid subscription product: %s\n", product == NULL ? "(null)" : product);
+        return -1;
+    }
+
+    m_products.push_back(product);
+    return 0;
+}
+
+void subscription_t::add_type(uint8 ins_type)
+{
+    m_type_mask[ins_type >> 6] |= 1ULL << (ins_type & 63);
+    m_has_type = true;
+}
+
+int subscription_t::parse(const char *list)
+{
+    int count = 0;
+    const char *pos = list;
+    while (pos != NULL && *pos != '\0')
+    {
+        const char *end = strchr(pos, ',');
+        std::string item = end != NULL ? std::string(pos, end - pos) : std::string(pos);
+        pos = end != NULL ? end + 1 : NULL;
+
+        // 去掉首尾空白，空项忽略
+        size_t first = item.find_first_not_of(" \t");
+        if (first == std::string::npos)
+            continue;
+        item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+
+        int res = 0;
+        if (item[0] == '#')
+        {
+            char *type_end = NULL;
+            long ins_type = strtol(item.c_str() + 1, &type_end, 0);
+            if (type_end == item.c_str() + 1 || *type_end != '\0' || ins_type < 0 || ins_type > 255)
+                res = -1;
+            else
+                add_type((uint8)ins_type);
+        }
+        else
+        {
+            bool has_digit = false;
+            for (size_t i = 0; i < item.size(); i++)
+                has_digit = has_digit || isdigit((unsigned char)item[i]);
+            res = has_digit ? add_symbol(item.c_str()) : add_product(item.c_str());
+        }
+
+        if (res != 0)
+        {
+            printf("invalid subscription item: %s\n", item.c_str());
+            return -1;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+void subscription_t::clear()
+{
+    memset(m_bits, 0, sizeof(m_bits));
+    memset(m_resolved, 0, sizeof(m_resolved));
+    m_trade_date = 0;
+    m_count = 0;
+}
+
+void subscription_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    // 交易日切换后合约索引重新编排，按新的索引重新解析
+    if (ev.msg_idx == 0 && ev.trade_date != m_trade_date)
+    {
+        if (m_trade_date != 0)
+            clear();
+        m_trade_date = ev.trade_date;
+    }
+
+    uint64_t bit = 1ULL << (ev.ins_idx & 63);
+    uint64_t &resolved = m_resolved[ev.ins_idx >> 6];
+    if (resolved & bit)
+        return;
+    resolved |= bit;
+
+    if (match(ev.ins_id, ev.ins_type))
+    {
+        m_bits[ev.ins_idx >> 6] |= bit;
+        m_count++;
+    }
+}
+
+bool subscription_t::match(const char *ins_id, uint8 ins_type) const
+{
+    if (empty())
+        return true;
+
+    if ((m_type_mask[ins_type >> 6] >> (ins_type & 63)) & 1)
+        return true;
+
+    for (size_t i = 0; i < m_symbols.size(); i++)
+    {
+        if (m_symbols[i] == ins_id)
+            return true;
+    }
+
+    // 品种为合约编码开头的字母部分
+    size_t product_len = 0;
+    while (isalpha((unsigned char)ins_id[product_len]))
+        product_len++;
+
+    for (size_t i = 0; i < m_products.size(); i++)
+    {
+        if (m_products[i].size() == product_len && m_products[i].compare(0, product_len, ins_id, product_len) == 0)
+            return true;
+    }
+
+    return false;
+}
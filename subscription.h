@@ -0,0 +1,112 @@
+#ifndef SUBSCRIPTION_H_
+#define SUBSCRIPTION_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "mdp_event.h"
+
+#define SUB_INS_NUM     65536               ///< ins_idx为uint16，位图覆盖全部索引
+#define SUB_WORD_NUM    (SUB_INS_NUM / 64)  ///< 位图字数
+
+/**
+ * @brief 合约订阅
+ *
+ * 按合约编码、品种（合约编码开头的字母部分，如"SR"、"CF"）或合约类型订阅，
+ * 规则在收到合约索引(0x05)时解析为以ins_idx为下标的位图，解码器对单腿、组合、
+ * 深度、初始行情和询价消息只读取前4字节即可跳过未订阅合约。
+ * 未收到合约索引之前所有合约都视为未订阅；交易日切换时位图清空后重新解析。
+ * 位图由所属解码器的线程更新，每个解码器各用一个订阅对象。
+ */
+class subscription_t
+{
+public:
+    subscription_t();
+
+    /**
+     * @brief 订阅指定合约
+     *
+     * @param symbol 合约编码，如"SR501"
+     *
+     * @return 0：成功；-1：参数错误
+     */
+    int add_symbol(const char *symbol);
+
+    /**
+     * @brief 订阅品种的所有合约（含期权），合约编码开头的字母部分与之完全相同即匹配
+     *
+     * @param product 品种代码，如"SR"
+     *
+     * @return 0：成功；-1：参数错误
+     */
+    int add_product(const char *product);
+
+    /**
+     * @brief 订阅指定类型的所有合约
+     *
+     * @param ins_type 合约索引消息中的合约类型
+     */
+    void add_type(uint8 ins_type);
+
+    /**
+     * @brief 解析逗号分隔的订阅列表，如"SR,CF505,#2"
+     *
+     * 含数字的项为合约编码，纯字母的项为品种代码，"#"开头的项为合约类型
+     *
+     * @return 添加的规则数；-1：含无法解析的项
+     */
+    int parse(const char *list);
+
+    /**
+     * @brief 是否添加了订阅规则，没有规则时所有合约都匹配
+     */
+    bool empty() const { return m_symbols.empty() && m_products.empty() && !m_has_type; }
+
+    /**
+     * @brief 合约是否已订阅，解码热路径调用
+     */
+    bool has(uint16 ins_idx) const { return (m_bits[ins_idx >> 6] >> (ins_idx & 63)) & 1; }
+
+    /**
+     * @brief 已订阅的合约个数
+     */
+    int get_count() const { return m_count; }
+
+    /**
+     * @brief 报文类型是否按合约过滤，这些消息体的第3~4字节为合约索引
+     */
+    static bool is_filtered_type(uint8 msg_type)
+    {
+        return msg_type == PACKAGE_INSTRUMENT_INIT || msg_type == PACKAGE_INSTRUMENT
+            || msg_type == PACKAGE_CMBTYPE || msg_type == PACKAGE_QUOT_REQ || msg_type == PACKAGE_DEPTH;
+    }
+
+    /**
+     * @brief 按合约索引消息更新位图，由解码器在转发给处理器之前调用
+     */
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+
+    /**
+     * @brief 清空位图，订阅规则保留
+     */
+    void clear();
+
+private:
+    /**
+     * @brief 合约是否匹配任一规则
+     */
+    bool match(const char *ins_id, uint8 ins_type) const;
+
+private:
+    std::vector<std::string> m_symbols;   ///< 订阅的合约编码
+    std::vector<std::string> m_products;  ///< 订阅的品种代码
+    uint64_t m_type_mask[4];              ///< 订阅的合约类型位图
+    bool m_has_type;                      ///< 是否按合约类型订阅
+    uint64_t m_bits[SUB_WORD_NUM];        ///< 以ins_idx为下标的订阅位图
+    uint64_t m_resolved[SUB_WORD_NUM];    ///< 已解析过的ins_idx，合约索引重复广播时不再匹配
+    uint32 m_trade_date;                  ///< 位图对应的交易日
+    int m_count;                          ///< 已订阅的合约个数
+};
+
+#endif
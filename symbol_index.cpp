@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include "symbol_index.h"
+#include "tsc_clock.h"
+
+#define SYMBOL_MAX_SEED_TRY 16      ///< 换种子重试次数
+#define SYMBOL_MAX_DISP     65536   ///< 位移值上限（uint16）
+
+/**
+ * @brief 不小于n的最小2的幂
+ */
+static uint32 round_pow2(uint32 n)
+{
+    uint32 size = 1;
+    while (size < n)
+        size <<= 1;
+    return size;
+}
+
+static bool key_less(const symbol_index_t::entry_t &a, const symbol_index_t::entry_t &b)
+{
+    for (int i = 0; i < SYMBOL_KEY_WORDS; i++)
+    {
+        if (a.key.word[i] != b.key.word[i])
+            return a.key.word[i] < b.key.word[i];
+    }
+    return false;
+}
+
+symbol_index_t::symbol_index_t()
+{
+    // 空表：一个空槽、一个桶，查找总是落到空槽
+    m_slots.resize(1);
+    m_slots[0].key.word[0] = m_slots[0].key.word[1] = m_slots[0].key.word[2] = 0;
+    m_slots[0].ins_idx = 0;
+    m_disp.assign(1, 0);
+    m_slot_mask = 0;
+    m_bucket_mask = 0;
+    m_seed = 0;
+    m_count = 0;
+}
+
+int symbol_index_t::build(const std::vector<entry_t> &entries)
+{
+    // 按编码稳定排序后去重，相同编码保留最后一个
+    std::vector<entry_t> unique(entries);
+    std::stable_sort(unique.begin(), unique.end(), key_less);
+    size_t count = 0;
+    for (size_t i = 0; i < unique.size(); i++)
+    {
+        if (i + 1 < unique.size() && unique[i + 1].key == unique[i].key)
+            continue;
+        unique[count++] = unique[i];
+    }
+    unique.resize(count);
+
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < SYMBOL_MAX_SEED_TRY; i++)
+    {
+        if (try_build(unique, seed))
+            return 0;
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+
+    printf("symbol index build failed, count = %d\n", (int)unique.size());
+    return -1;
+}
+
+bool symbol_index_t::try_build(const std::vector<entry_t> &entries, uint64_t seed)
+{
+    uint32 count = entries.size();
+
+    // 装载率不超过约80%，平均每桶2个合约
+    uint32 slot_num = round_pow2(count + count / 4 + 1);
+    uint32 bucket_num = round_pow2(count / 2 + 1);
+
+    std::vector<uint64_t> hashes(count);
+    std::vector<std::vector<uint32> > buckets(bucket_num);
+    for (uint32 i = 0; i < count; i++)
+    {
+        hashes[i] = hash(entries[i].key, seed);
+        buckets[(hashes[i] >> 32) & (bucket_num - 1)].push_back(i);
+    }
+
+    // 大桶先放，空槽多时更容易找到位移值
+    std::vector<uint32> order(bucket_num);
+    for (uint32 b = 0; b < bucket_num; b++)
+        order[b] = b;
+    std::stable_sort(order.begin(), order.end(),
+            [&buckets](uint32 a, uint32 b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<slot_t> slots(slot_num);
+    std::vector<uint8> used(slot_num, 0);
+    std::vector<uint16> disp(bucket_num, 0);
+    std::vector<uint32> pos;
+    for (uint32 n = 0; n < bucket_num; n++)
+    {
+        const std::vector<uint32> &bucket = buckets[order[n]];
+        if (bucket.empty())
+            break;
+
+        uint32 d = 0;
+        for (; d < SYMBOL_MAX_DISP; d++)
+        {
+            pos.clear();
+            bool ok = true;
+            for (size_t k = 0; k < bucket.size() && ok; k++)
+            {
+                uint32 p = slot_pos(hashes[bucket[k]], d) & (slot_num - 1);
+                ok = !used[p] && std::find(pos.begin(), pos.end(), p) == pos.end();
+                pos.push_back(p);
+            }
+            if (ok)
+                break;
+        }
+        if (d == SYMBOL_MAX_DISP)
+            return false;
+
+        disp[order[n]] = d;
+        for (size_t k = 0; k < bucket.size(); k++)
+        {
+            used[pos[k]] = 1;
+            slots[pos[k]].key = entries[bucket[k]].key;
+            slots[pos[k]].ins_idx = entries[bucket[k]].ins_idx;
+        }
+    }
+
+    m_slots.swap(slots);
+    m_disp.swap(disp);
+    m_slot_mask = slot_num - 1;
+    m_bucket_mask = bucket_num - 1;
+    m_seed = seed;
+    m_count = count;
+    return true;
+}
+
+symbol_map_t::symbol_map_t()
+    : m_current(NULL), m_published_date(0), m_pos(1 << 16, -1)
+{
+    m_last_publish_ns = 0;
+    m_trade_date = 0;
+    m_dirty = false;
+}
+
+symbol_map_t::~symbol_map_t()
+{
+    delete m_current.load(std::memory_order_relaxed);
+    reclaim();
+    reclaim();
+}
+
+void symbol_map_t::check_publish()
+{
+    if (__builtin_expect(m_dirty, 0))
+    {
+        // 当日首次立即发布，之后限制重建频率，索引广播与行情交错时不会每条消息重建一次
+        if (m_last_publish_ns != 0 && monotonic_ns() - m_last_publish_ns < SYMBOL_REBUILD_INTERVAL_NS)
+            return;
+        publish();
+    }
+}
+
+void symbol_map_t::swap(symbol_index_t *index, uint32 trade_date)
+{
+    const symbol_index_t *old = m_current.load(std::memory_order_relaxed);
+    m_current.store(index, std::memory_order_release);
+    m_published_date.store(trade_date, std::memory_order_release);
+
+    if (old != NULL)
+        m_retired.push_back(old);
+}
+
+void symbol_map_t::reclaim()
+{
+    for (size_t i = 0; i < m_expired.size(); i++)
+        delete m_expired[i];
+    m_expired.swap(m_retired);
+    m_retired.clear();
+}
+
+int symbol_map_t::publish()
+{
+    m_dirty = false;
+
+    symbol_index_t *index = new symbol_index_t();
+    if (index->build(m_entries) != 0)
+    {
+        delete index;
+        return -1;
+    }
+
+    swap(index, m_trade_date);
+    m_last_publish_ns = monotonic_ns();
+    return 0;
+}
+
+void symbol_map_t::on_instrument_idx(const mdp_idx_event_t &ev)
+{
+    // 交易日切换后合约索引重新编排，立即撤下旧表，按新索引重新收集
+    if (ev.msg_idx == 0 && ev.trade_date != m_trade_date)
+    {
+        if (m_trade_date != 0)
+        {
+            for (size_t i = 0; i < m_entries.size(); i++)
+                m_pos[m_entries[i].ins_idx] = -1;
+            m_entries.clear();
+            reclaim();
+            swap(NULL, 0);
+        }
+        m_last_publish_ns = 0;
+        m_trade_date = ev.trade_date;
+    }
+
+    symbol_index_t::entry_t entry;
+    if (!symbol_index_t::make_key(ev.ins_id, entry.key))
+        return;
+    entry.ins_idx = ev.ins_idx;
+
+    // 索引重复广播时编码不变的合约不触发重建
+    int &pos = m_pos[ev.ins_idx];
+    if (pos < 0)
+    {
+        pos = m_entries.size();
+        m_entries.push_back(entry);
+        m_dirty = true;
+    }
+    else if (!(m_entries[pos].key == entry.key))
+    {
+        m_entries[pos] = entry;
+        m_dirty = true;
+    }
+}
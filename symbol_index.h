@@ -0,0 +1,242 @@
+#ifndef SYMBOL_INDEX_H_
+#define SYMBOL_INDEX_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "mdp_handler.h"
+
+#define SYMBOL_KEY_WORDS    3   ///< 合约编码按0补齐到24字节，分3个64位字比较
+#define SYMBOL_REBUILD_INTERVAL_NS  100000000ULL    ///< 同一交易日内两次重建的最小间隔(ns)，限制保留的旧表个数
+
+/**
+ * @brief 合约编码键，'\0'之后全部为0，可按字直接比较
+ */
+struct symbol_key_t
+{
+    uint64_t word[SYMBOL_KEY_WORDS];
+
+    bool operator==(const symbol_key_t &other) const
+    {
+        return word[0] == other.word[0] && word[1] == other.word[1] && word[2] == other.word[2];
+    }
+};
+
+/**
+ * @brief 合约编码到合约索引的只读完美哈希表
+ *
+ * 按当日合约索引一次性构建（hash-and-displace）：合约按哈希高位分桶，每个桶
+ * 选一个位移值使桶内合约落到互不冲突的槽位，查找只需一次哈希、读一个位移值
+ * 和一个槽位，比较3个字即可确定结果，不分配内存、不构造std::string。
+ * 构建后不再修改，可在任意线程并发查找。
+ */
+class symbol_index_t
+{
+public:
+    /**
+     * @brief 构建输入：合约编码+合约索引
+     */
+    struct entry_t
+    {
+        symbol_key_t key;  ///< 合约编码
+        uint16 ins_idx;    ///< 合约索引
+    };
+
+    symbol_index_t();
+
+    /**
+     * @brief 将合约编码转为键，逐字节在寄存器中拼字，避免按字节写入后按字读出的存储转发停顿
+     *
+     * @return true：成功；false：编码为空或不短于MDP_INS_ID_LEN
+     */
+    static bool make_key(const char *symbol, symbol_key_t &key)
+    {
+        uint64_t word[SYMBOL_KEY_WORDS] = {0, 0, 0};
+        int len = 0;
+        for (; len < MDP_INS_ID_LEN && symbol[len] != '\0'; len++)
+            word[len >> 3] |= (uint64_t)(uint8)symbol[len] << ((len & 7) * 8);
+
+        key.word[0] = word[0];
+        key.word[1] = word[1];
+        key.word[2] = word[2];
+        return len > 0 && len < MDP_INS_ID_LEN;
+    }
+
+    /**
+     * @brief 按合约列表构建，重复的编码以后出现的为准
+     *
+     * @return 0：成功；-1：无法构建（理论上不会发生）
+     */
+    int build(const std::vector<entry_t> &entries);
+
+    /**
+     * @brief 查找合约索引
+     *
+     * 耗时主要在变长编码转键，反复查找同一批合约时可预先make_key()再按键查找
+     *
+     * @param symbol 合约编码，如"SR501"
+     *
+     * @return 合约索引；-1：不存在
+     */
+    int find(const char *symbol) const
+    {
+        symbol_key_t key;
+        if (m_count == 0 || !make_key(symbol, key))
+            return -1;
+        return find(key);
+    }
+
+    /**
+     * @brief 按键查找合约索引，键必须由make_key()生成
+     */
+    int find(const symbol_key_t &key) const
+    {
+        uint64_t h = hash(key, m_seed);
+        uint32 disp = m_disp[(h >> 32) & m_bucket_mask];
+        const slot_t &slot = m_slots[slot_pos(h, disp) & m_slot_mask];
+        return slot.key == key ? slot.ins_idx : -1;
+    }
+
+    /**
+     * @brief 合约个数
+     */
+    int get_count() const { return m_count; }
+
+    /**
+     * @brief 占用内存字节数
+     */
+    size_t mem_size() const { return m_slots.size() * sizeof(slot_t) + m_disp.size() * sizeof(uint16); }
+
+private:
+    /**
+     * @brief 槽位，空槽的键全为0，不会与任何合约编码相等
+     */
+    struct slot_t
+    {
+        symbol_key_t key;  ///< 合约编码
+        uint16 ins_idx;    ///< 合约索引
+    };
+
+    static uint64_t hash(const symbol_key_t &key, uint64_t seed)
+    {
+        uint64_t h = seed ^ (key.word[0] * 0x9E3779B97F4A7C15ULL);
+        h = (h ^ (h >> 29) ^ key.word[1]) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 32) ^ key.word[2]) * 0x94D049BB133111EBULL;
+        return h ^ (h >> 31);
+    }
+
+    /**
+     * @brief 槽位 = 低32位 + 位移值 * 高16位（奇数），同桶合约的槽位序列各不相同
+     */
+    static uint32 slot_pos(uint64_t h, uint32 disp)
+    {
+        return (uint32)h + disp * ((uint32)(h >> 48) | 1);
+    }
+
+    /**
+     * @brief 以指定种子尝试构建
+     *
+     * @return true：成功；false：有桶找不到可用位移值，需换种子重试
+     */
+    bool try_build(const std::vector<entry_t> &entries, uint64_t seed);
+
+private:
+    std::vector<slot_t> m_slots;  ///< 槽位，个数为2的幂
+    std::vector<uint16> m_disp;   ///< 每个桶的位移值，个数为2的幂
+    uint32 m_slot_mask;           ///< 槽位个数-1
+    uint32 m_bucket_mask;         ///< 桶个数-1
+    uint64_t m_seed;              ///< 哈希种子
+    int m_count;                  ///< 合约个数
+};
+
+/**
+ * @brief 当日合约编码查找表
+ *
+ * 作为解码器处理器收集合约索引(0x05)，合约索引广播结束（收到其他类型的消息）
+ * 时构建新的symbol_index_t，以原子指针替换发布；交易日切换时先撤下旧表，
+ * 新索引广播结束前find()返回-1，避免按旧交易日的索引查到错误的合约。
+ * 广播结束后再收到新合约时重新构建。构建在解码线程上进行，数千个合约约1ms；
+ * 索引广播与其他消息交错时，同一交易日内两次重建至少间隔SYMBOL_REBUILD_INTERVAL_NS。
+ *
+ * 收集和构建只在解码线程进行；find()可在任意线程调用。读者取得表指针后可能
+ * 被抢占任意长时间，因此被替换的表不在下一次替换时释放，而是保留到下一个
+ * 交易日切换之后（即至少一个完整交易日），再切换时才释放。
+ */
+class symbol_map_t : public mdp_null_handler_t
+{
+public:
+    symbol_map_t();
+    ~symbol_map_t();
+
+    /**
+     * @brief 查找合约索引，可在任意线程调用
+     *
+     * @return 合约索引；-1：不存在或当日索引尚未就绪
+     */
+    int find(const char *symbol) const
+    {
+        const symbol_index_t *index = m_current.load(std::memory_order_acquire);
+        return index != NULL ? index->find(symbol) : -1;
+    }
+
+    /**
+     * @brief 当前发布的查找表中的合约个数
+     */
+    int get_count() const
+    {
+        const symbol_index_t *index = m_current.load(std::memory_order_acquire);
+        return index != NULL ? index->get_count() : 0;
+    }
+
+    /**
+     * @brief 当前发布的查找表对应的交易日，未发布时为0
+     */
+    uint32 get_trade_date() const { return m_published_date.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 用已收集的合约立即构建并发布，不等待广播结束
+     *
+     * @return 0：成功；-1：构建失败
+     */
+    int publish();
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev);
+
+    // 任一非索引消息表示本轮索引广播已结束
+    void on_instrument_init(const mdp_init_event_t &) { check_publish(); }
+    void on_instrument(const mdp_tick_event_t &) { check_publish(); }
+    void on_cmbtype(const mdp_cmb_event_t &) { check_publish(); }
+    void on_bulletine(const mdp_bulletine_event_t &) { check_publish(); }
+    void on_quot_req(const mdp_quot_req_event_t &) { check_publish(); }
+    void on_trade_status(const mdp_trade_status_event_t &) { check_publish(); }
+    void on_depth(const mdp_depth_event_t &) { check_publish(); }
+
+private:
+    void check_publish();
+
+    /**
+     * @brief 替换当前发布的表，被替换的表加入当日保留列表
+     */
+    void swap(symbol_index_t *index, uint32 trade_date);
+
+    /**
+     * @brief 交易日切换时释放上一个交易日被替换的表，当日被替换的表再保留一个交易日
+     */
+    void reclaim();
+
+private:
+    std::atomic<const symbol_index_t *> m_current;  ///< 当前发布的表
+    std::atomic<uint32> m_published_date;           ///< 当前发布的表对应的交易日
+    std::vector<const symbol_index_t *> m_retired;  ///< 当前交易日被替换的表
+    std::vector<const symbol_index_t *> m_expired;  ///< 上一个交易日被替换的表，下次交易日切换时释放
+    uint64_t m_last_publish_ns;                     ///< 最近一次发布的单调时钟，0表示当日尚未发布
+    std::vector<symbol_index_t::entry_t> m_entries; ///< 当日已收集的合约
+    std::vector<int> m_pos;                         ///< ins_idx在m_entries中的位置，-1为未收到
+    uint32 m_trade_date;                            ///< 正在收集的交易日
+    bool m_dirty;                                   ///< 有未发布的合约
+};
+
+#endif
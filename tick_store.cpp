@@ -0,0 +1,654 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tick_store.h"
+
+/**
+ * @brief 字段组的列定义
+ */
+static int get_cols(tick_group_t group, tick_col_desc_t *cols)
+{
+    static const char *level_names[4] = {"bid", "bid_qty", "ask", "ask_qty"};
+
+    int col_num = 0;
+    if (group == TICK_GROUP_L1)
+    {
+        static const struct { const char *name; uint32 size; } l1_cols[TICK_L1_COL_NUM] =
+        {
+            {"local_ns", 8}, {"time_us", 8}, {"last", 4}, {"volume", 4}, {"trade_val", 8}
+        };
+        for (; col_num < TICK_L1_COL_NUM; col_num++)
+        {
+            snprintf(cols[col_num].name, TICK_COL_NAME_LEN, "%s", l1_cols[col_num].name);
+            cols[col_num].size = l1_cols[col_num].size;
+        }
+    }
+    else
+    {
+        snprintf(cols[col_num].name, TICK_COL_NAME_LEN, "local_ns");
+        cols[col_num++].size = 8;
+        for (int kind = 0; kind < 4; kind++)
+        {
+            for (int level = 0; level < DEPTH_LEVEL_NUM; level++)
+            {
+                snprintf(cols[col_num].name, TICK_COL_NAME_LEN, "%s%d", level_names[kind], level + 1);
+                cols[col_num++].size = 4;
+            }
+        }
+    }
+
+    // 每列在块内占size * TICK_BLOCK_ROWS字节，各列自然对齐
+    uint32 offset = 0;
+    for (int c = 0; c < col_num; c++)
+    {
+        cols[c].offset = offset;
+        offset += cols[c].size * TICK_BLOCK_ROWS;
+    }
+    return col_num;
+}
+
+/**
+ * @brief 逐级创建目录
+ */
+static int make_dirs(const std::string &path)
+{
+    for (size_t pos = 1; pos <= path.size(); pos++)
+    {
+        if (pos != path.size() && path[pos] != '/')
+            continue;
+        std::string part = path.substr(0, pos);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            perror("create tick store directory");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/****** tick_feed_t ******/
+
+tick_feed_t::tick_feed_t(const char *name, uint32 queue_size)
+{
+    m_name = name;
+    m_size = queue_size;
+    m_tail = 0;
+    m_head_cache = 0;
+    m_dropped = 0;
+    m_head = 0;
+
+    m_recs = NULL;
+    if (m_size == 0)
+        return;
+
+    // 预先映射，避免解码线程首次写入槽位时缺页
+    void *mem = mmap(NULL, sizeof(tick_rec_t) * m_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    m_recs = mem == MAP_FAILED ? NULL : (tick_rec_t *)mem;
+}
+
+tick_feed_t::~tick_feed_t()
+{
+    if (m_recs != NULL)
+        munmap(m_recs, sizeof(tick_rec_t) * m_size);
+}
+
+/****** tick_file_writer_t ******/
+
+tick_file_writer_t::tick_file_writer_t()
+{
+    m_map = NULL;
+    m_map_len = 0;
+    m_header = NULL;
+    m_rows = 0;
+    m_capacity = 0;
+    m_block = NULL;
+    m_row_in_block = 0;
+}
+
+tick_file_writer_t::~tick_file_writer_t()
+{
+    close();
+}
+
+int tick_file_writer_t::reopen(const char *path, tick_group_t group, uint32 trade_date, const char *ins_id)
+{
+    int fd = ::open(path, O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < TICK_HEADER_LEN)
+    {
+        ::close(fd);
+        return -1;
+    }
+
+    void *mem = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap tick file");
+        return -1;
+    }
+
+    tick_col_desc_t cols[TICK_MAX_COLS];
+    memset(cols, 0, sizeof(cols));
+    int col_num = get_cols(group, cols);
+
+    const tick_file_header_t *header = (const tick_file_header_t *)mem;
+    uint64_t capacity = header->block_size == 0 ? 0
+            : (st.st_size - TICK_HEADER_LEN) / header->block_size * TICK_BLOCK_ROWS;
+    if (memcmp(header->magic, TICK_MAGIC, sizeof(header->magic)) != 0 || header->version != TICK_VERSION
+            || header->header_len != TICK_HEADER_LEN || header->group != (uint32)group
+            || header->trade_date != trade_date || strncmp(header->ins_id, ins_id, MDP_INS_ID_LEN) != 0
+            || header->col_num != (uint32)col_num || header->block_rows != TICK_BLOCK_ROWS
+            || memcmp(header->cols, cols, sizeof(cols)) != 0
+            || header->rows.load(std::memory_order_relaxed) > capacity)
+    {
+        munmap(mem, st.st_size);
+        return -1;
+    }
+
+    m_path = path;
+    m_map = (char *)mem;
+    m_map_len = st.st_size;
+    m_header = (tick_file_header_t *)m_map;
+    m_rows = header->rows.load(std::memory_order_relaxed);
+    m_capacity = capacity;
+    return 0;
+}
+
+int tick_file_writer_t::open(const char *path, tick_group_t group, uint32 trade_date, const char *ins_id, uint16 ins_idx)
+{
+    if (m_map != NULL)
+    {
+        printf("tick file has been opened: %s\n", m_path.c_str());
+        return -1;
+    }
+
+    // 盘中重启时接着写当日文件
+    if (reopen(path, group, trade_date, ins_id) == 0)
+    {
+        m_header->ins_idx = ins_idx;
+        printf("tick file reopened: %s, rows = %lu\n", path, (unsigned long)m_rows);
+        return 0;
+    }
+
+    tick_col_desc_t cols[TICK_MAX_COLS];
+    memset(cols, 0, sizeof(cols));
+    int col_num = get_cols(group, cols);
+
+    int fd = ::open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        perror("create tick file");
+        return -1;
+    }
+
+    // 文件按需扩展，未写入的部分为空洞，不占磁盘空间
+    if (ftruncate(fd, TICK_HEADER_LEN) != 0)
+    {
+        perror("truncate tick file");
+        ::close(fd);
+        return -1;
+    }
+
+    void *mem = mmap(NULL, TICK_HEADER_LEN, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap tick file");
+        return -1;
+    }
+
+    m_path = path;
+    m_map = (char *)mem;
+    m_map_len = TICK_HEADER_LEN;
+    m_header = (tick_file_header_t *)m_map;
+    m_rows = 0;
+    m_capacity = 0;
+
+    memcpy(m_header->magic, TICK_MAGIC, sizeof(m_header->magic));
+    m_header->version = TICK_VERSION;
+    m_header->header_len = TICK_HEADER_LEN;
+    m_header->group = group;
+    m_header->trade_date = trade_date;
+    memcpy(m_header->ins_id, ins_id, sizeof(m_header->ins_id));
+    m_header->ins_idx = ins_idx;
+    m_header->price_size = 0;
+    m_header->col_num = col_num;
+    m_header->block_rows = TICK_BLOCK_ROWS;
+    m_header->block_size = cols[col_num - 1].offset + cols[col_num - 1].size * TICK_BLOCK_ROWS;
+    m_header->rows.store(0, std::memory_order_relaxed);
+    memcpy(m_header->cols, cols, sizeof(m_header->cols));
+    return 0;
+}
+
+int tick_file_writer_t::grow()
+{
+    uint64_t block_num = m_capacity / TICK_BLOCK_ROWS;
+    uint64_t new_block_num = block_num == 0 ? 1 : (block_num < 64 ? block_num * 2 : block_num + 64);
+    size_t new_len = TICK_HEADER_LEN + new_block_num * m_header->block_size;
+
+    // 映射后文件描述符已关闭，扩展时重新打开
+    int fd = ::open(m_path.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+        perror("open tick file");
+        return -1;
+    }
+
+    if (ftruncate(fd, new_len) != 0)
+    {
+        perror("extend tick file");
+        ::close(fd);
+        return -1;
+    }
+    ::close(fd);
+
+    void *mem = mremap(m_map, m_map_len, new_len, MREMAP_MAYMOVE);
+    if (mem == MAP_FAILED)
+    {
+        perror("remap tick file");
+        return -1;
+    }
+
+    m_map = (char *)mem;
+    m_map_len = new_len;
+    m_header = (tick_file_header_t *)m_map;
+    m_capacity = new_block_num * TICK_BLOCK_ROWS;
+    return 0;
+}
+
+int tick_file_writer_t::begin_row()
+{
+    if (m_rows == m_capacity && grow() != 0)
+        return -1;
+
+    m_block = m_map + TICK_HEADER_LEN + (m_rows / TICK_BLOCK_ROWS) * m_header->block_size;
+    m_row_in_block = m_rows % TICK_BLOCK_ROWS;
+    return 0;
+}
+
+void tick_file_writer_t::close()
+{
+    if (m_map == NULL)
+        return;
+
+    // 截掉未使用的块，最后一块保留完整长度
+    uint64_t block_num = (m_rows + TICK_BLOCK_ROWS - 1) / TICK_BLOCK_ROWS;
+    size_t file_len = TICK_HEADER_LEN + block_num * m_header->block_size;
+    munmap(m_map, m_map_len);
+    m_map = NULL;
+    m_header = NULL;
+
+    if (truncate(m_path.c_str(), file_len) != 0)
+        perror("truncate tick file");
+}
+
+/****** tick_store_t ******/
+
+tick_store_t::tick_store_t()
+{
+    m_skipped = 0;
+    m_started = false;
+    m_stop = false;
+    m_written = 0;
+}
+
+tick_store_t::~tick_store_t()
+{
+    stop();
+
+    for (size_t i = 0; i < m_feeds.size(); i++)
+    {
+        close_feed(m_feeds[i]);
+        delete m_feeds[i].feed;
+    }
+}
+
+tick_feed_t *tick_store_t::add_feed(const char *name, uint32 queue_size)
+{
+    if (m_started)
+    {
+        printf("add tick feed failed: store started!\n");
+        return NULL;
+    }
+
+    if (queue_size == 0 || (queue_size & (queue_size - 1)) != 0)
+    {
+        printf("tick queue size must be power of 2: %u\n", queue_size);
+        return NULL;
+    }
+
+    tick_feed_t *feed = new tick_feed_t(name, queue_size);
+    if (feed->m_recs == NULL)
+    {
+        perror("mmap tick queue");
+        delete feed;
+        return NULL;
+    }
+
+    feed_state_t fs;
+    fs.feed = feed;
+    fs.trade_date = 0;
+    fs.ins.assign(1 << 16, NULL);
+    m_feeds.push_back(fs);
+    return feed;
+}
+
+int tick_store_t::start(const char *dir)
+{
+    if (m_started)
+    {
+        printf("tick store has been started!\n");
+        return -1;
+    }
+
+    m_dir = dir;
+    if (make_dirs(m_dir) != 0)
+    {
+        return -2;
+    }
+
+    m_stop = false;
+    int res = pthread_create(&m_thread, NULL, thread_main, this);
+    if (res != 0)
+    {
+        printf("create tick store thread failed: %s\n", strerror(res));
+        return -3;
+    }
+
+    m_started = true;
+    return 0;
+}
+
+void tick_store_t::stop()
+{
+    if (!m_started)
+        return;
+
+    m_stop.store(true, std::memory_order_release);
+    pthread_join(m_thread, NULL);
+    m_started = false;
+
+    for (size_t i = 0; i < m_feeds.size(); i++)
+    {
+        close_feed(m_feeds[i]);
+        printf("tick feed %s: dropped = %lu\n", m_feeds[i].feed->get_name(),
+                (unsigned long)m_feeds[i].feed->get_dropped());
+    }
+    printf("tick rows written: %lu, skipped = %lu\n", (unsigned long)get_written(), (unsigned long)m_skipped);
+}
+
+void *tick_store_t::thread_main(void *arg)
+{
+    ((tick_store_t *)arg)->run();
+    return NULL;
+}
+
+void tick_store_t::run()
+{
+    while (true)
+    {
+        if (drain() > 0)
+            continue;
+
+        // 队列已空，停止请求之前的记录都已写入
+        if (m_stop.load(std::memory_order_acquire))
+        {
+            drain();
+            return;
+        }
+
+        usleep(100);
+    }
+}
+
+int tick_store_t::drain()
+{
+    int count = 0;
+
+    for (size_t i = 0; i < m_feeds.size(); i++)
+    {
+        feed_state_t &fs = m_feeds[i];
+
+        // 每个队列每轮最多取一批，避免某个输入独占写盘线程
+        for (int n = 0; n < 1024; n++)
+        {
+            const tick_rec_t *rec = fs.feed->front();
+            if (rec == NULL)
+                break;
+
+            apply(fs, *rec);
+            fs.feed->pop();
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void tick_store_t::apply(feed_state_t &fs, const tick_rec_t &rec)
+{
+    if (rec.kind == PACKAGE_INSTRUMENT_IDX)
+    {
+        // 交易日切换后合约索引重新编排，关闭旧交易日的所有文件
+        if (rec.idx.msg_idx == 0 && rec.idx.trade_date != fs.trade_date)
+        {
+            close_feed(fs);
+            fs.trade_date = rec.idx.trade_date;
+        }
+
+        ins_state_t *&ins = fs.ins[rec.ins_idx];
+        if (ins != NULL && strncmp(ins->ins_id, rec.idx.ins_id, MDP_INS_ID_LEN) == 0)
+            return;
+
+        // 新合约，或同一索引换了合约编码
+        delete ins;
+        ins = new ins_state_t();
+        memset(ins->ins_id, 0, sizeof(ins->ins_id));
+        memcpy(ins->ins_id, rec.idx.ins_id, sizeof(ins->ins_id) - 1);
+        ins->ins_idx = rec.ins_idx;
+        memset(ins->value, 0, sizeof(ins->value));
+        memset(ins->book, 0, sizeof(ins->book));
+        return;
+    }
+
+    ins_state_t *ins = fs.ins[rec.ins_idx];
+    if (ins == NULL || fs.trade_date == 0)
+    {
+        m_skipped++;
+        return;
+    }
+
+    if (rec.kind == PACKAGE_INSTRUMENT)
+        apply_tick(fs, *ins, rec);
+    else if (rec.kind == PACKAGE_DEPTH)
+        apply_depth(fs, *ins, rec);
+}
+
+void tick_store_t::apply_tick(feed_state_t &fs, ins_state_t &ins, const tick_rec_t &rec)
+{
+    uint32 mask = rec.mask;
+    while (mask != 0)
+    {
+        int fld_idx = __builtin_ctz(mask);
+        ins.value[fld_idx] = rec.value[fld_idx];
+        mask &= mask - 1;
+    }
+
+    tick_file_writer_t &file = ins.l1;
+    if ((!file.is_open() && open_file(fs, ins, TICK_GROUP_L1) != 0) || file.begin_row() != 0)
+    {
+        m_skipped++;
+        return;
+    }
+
+    // 秒级时间为HHMMSS
+    int hhmmss = ins.value[TICK_FLD_TIME_SEC];
+    long long day_sec = hhmmss / 10000 * 3600 + hhmmss / 100 % 100 * 60 + hhmmss % 100;
+    long long trade_val = ((long long)ins.value[TICK_FLD_TRADE_VAL1] << 26) | ins.value[TICK_FLD_TRADE_VAL2];
+
+    file.put<int64_t>(TICK_COL_LOCAL_NS, rec.local_ns);
+    file.put<int64_t>(TICK_COL_TIME_US, day_sec * 1000000 + ins.value[TICK_FLD_TIME_USEC]);
+    file.put<int32_t>(TICK_COL_LAST, ins.value[TICK_FLD_LAST]);
+    file.put<int32_t>(TICK_COL_VOLUME, ins.value[TICK_FLD_VOLUME]);
+    file.put<int64_t>(TICK_COL_TRADE_VAL, trade_val);
+    file.end_row(rec.price_size);
+
+    m_written.store(m_written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void tick_store_t::apply_depth(feed_state_t &fs, ins_state_t &ins, const tick_rec_t &rec)
+{
+    // 只处理买一~卖五对应的字段1~10
+    uint32 mask = rec.mask & (((1u << (DEPTH_LEVEL_NUM * 2)) - 1) << 1);
+    while (mask != 0)
+    {
+        int fld_idx = __builtin_ctz(mask);
+        int level = (fld_idx - 1) >> 1;
+        const mdp_depth_entry_t &entry = rec.entry[fld_idx];
+        if (fld_idx & 1)
+        {
+            ins.book[DEPTH_COL_BID_PRICE + level] = entry.price;
+            ins.book[DEPTH_COL_BID_QTY + level] = entry.qty;
+        }
+        else
+        {
+            ins.book[DEPTH_COL_ASK_PRICE + level] = entry.price;
+            ins.book[DEPTH_COL_ASK_QTY + level] = entry.qty;
+        }
+        mask &= mask - 1;
+    }
+
+    tick_file_writer_t &file = ins.depth;
+    if ((!file.is_open() && open_file(fs, ins, TICK_GROUP_DEPTH) != 0) || file.begin_row() != 0)
+    {
+        m_skipped++;
+        return;
+    }
+
+    file.put<int64_t>(DEPTH_COL_LOCAL_NS, rec.local_ns);
+    for (int c = DEPTH_COL_BID_PRICE; c < TICK_DEPTH_COL_NUM; c++)
+        file.put<int32_t>(c, ins.book[c]);
+    file.end_row(rec.price_size);
+
+    m_written.store(m_written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+int tick_store_t::open_file(feed_state_t &fs, ins_state_t &ins, tick_group_t group)
+{
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s/%u/%s", m_dir.c_str(), fs.trade_date, fs.feed->get_name());
+    if (make_dirs(dir) != 0)
+        return -1;
+
+    // 合约编码只含字母和数字，可直接作为文件名
+    char path[1200];
+    snprintf(path, sizeof(path), "%s/%s.%s", dir, ins.ins_id, group == TICK_GROUP_L1 ? "tick" : "depth");
+
+    tick_file_writer_t &file = group == TICK_GROUP_L1 ? ins.l1 : ins.depth;
+    return file.open(path, group, fs.trade_date, ins.ins_id, ins.ins_idx);
+}
+
+void tick_store_t::close_feed(feed_state_t &fs)
+{
+    for (size_t i = 0; i < fs.ins.size(); i++)
+    {
+        delete fs.ins[i];
+        fs.ins[i] = NULL;
+    }
+}
+
+/****** tick_file_t ******/
+
+tick_file_t::tick_file_t()
+{
+    m_map = NULL;
+    m_map_len = 0;
+    m_header = NULL;
+    m_capacity = 0;
+}
+
+tick_file_t::~tick_file_t()
+{
+    close();
+}
+
+int tick_file_t::open(const char *path)
+{
+    if (m_map != NULL)
+        close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("open tick file");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < TICK_HEADER_LEN)
+    {
+        printf("invalid tick file: %s\n", path);
+        ::close(fd);
+        return -1;
+    }
+
+    void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        perror("mmap tick file");
+        return -1;
+    }
+
+    const tick_file_header_t *header = (const tick_file_header_t *)mem;
+    if (memcmp(header->magic, TICK_MAGIC, sizeof(header->magic)) != 0 || header->version != TICK_VERSION
+            || header->header_len != TICK_HEADER_LEN || header->block_rows != TICK_BLOCK_ROWS
+            || header->col_num == 0 || header->col_num > TICK_MAX_COLS || header->block_size == 0)
+    {
+        printf("invalid tick file header: %s\n", path);
+        munmap(mem, st.st_size);
+        return -1;
+    }
+
+    // 按列顺序扫描，提示内核预读
+    madvise(mem, st.st_size, MADV_SEQUENTIAL);
+    madvise(mem, st.st_size, MADV_WILLNEED);
+
+    m_map = (char *)mem;
+    m_map_len = st.st_size;
+    m_header = header;
+    m_capacity = (m_map_len - TICK_HEADER_LEN) / header->block_size * TICK_BLOCK_ROWS;
+    return 0;
+}
+
+void tick_file_t::close()
+{
+    if (m_map == NULL)
+        return;
+
+    munmap(m_map, m_map_len);
+    m_map = NULL;
+    m_map_len = 0;
+    m_header = NULL;
+    m_capacity = 0;
+}
+
+int tick_file_t::find_col(const char *name) const
+{
+    for (uint32 c = 0; c < m_header->col_num; c++)
+    {
+        if (strncmp(m_header->cols[c].name, name, TICK_COL_NAME_LEN) == 0)
+            return c;
+    }
+    return -1;
+}
@@ -0,0 +1,492 @@
+#ifndef TICK_STORE_H_
+#define TICK_STORE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "mdp_handler.h"
+#include "tsc_clock.h"
+
+#define TICK_MAGIC              "CZCETCK1"  ///< 文件标识
+#define TICK_VERSION            1
+#define TICK_HEADER_LEN         4096        ///< 文件头长度，第一个块从此偏移开始
+#define TICK_BLOCK_ROWS         4096        ///< 每个块的行数
+#define TICK_MAX_COLS           32          ///< 单个文件最多列数
+#define TICK_COL_NAME_LEN       16          ///< 列名长度（含结尾'\0'）
+#define TICK_DEFAULT_QUEUE_SIZE 65536       ///< 默认每个输入队列的槽位数，必须为2的幂
+
+/**
+ * @brief 字段组，每个合约每个字段组一个文件
+ */
+enum tick_group_t
+{
+    TICK_GROUP_L1 = 1,      ///< 单腿行情(0x10)，文件扩展名.tick
+    TICK_GROUP_DEPTH = 2    ///< 深度行情(0x20)，文件扩展名.depth
+};
+
+/**
+ * @brief 单腿行情文件的列
+ */
+enum tick_l1_col_t
+{
+    TICK_COL_LOCAL_NS = 0,  ///< int64，本地时间（进入写入队列时的系统时钟ns）
+    TICK_COL_TIME_US,       ///< int64，交易所时间，当日微秒数（字段16、18）
+    TICK_COL_LAST,          ///< int32，最新价
+    TICK_COL_VOLUME,        ///< int32，累计成交量
+    TICK_COL_TRADE_VAL,     ///< int64，累计成交金额（未除价格精度）
+    TICK_L1_COL_NUM
+};
+
+/**
+ * @brief 深度行情文件的列，每档一列，level从0开始
+ */
+enum tick_depth_col_t
+{
+    DEPTH_COL_LOCAL_NS = 0,                                     ///< int64，本地时间
+    DEPTH_COL_BID_PRICE = 1,                                    ///< int32 x 5，买一~买五价格
+    DEPTH_COL_BID_QTY = DEPTH_COL_BID_PRICE + DEPTH_LEVEL_NUM,  ///< int32 x 5，买一~买五委托量
+    DEPTH_COL_ASK_PRICE = DEPTH_COL_BID_QTY + DEPTH_LEVEL_NUM,  ///< int32 x 5，卖一~卖五价格
+    DEPTH_COL_ASK_QTY = DEPTH_COL_ASK_PRICE + DEPTH_LEVEL_NUM,  ///< int32 x 5，卖一~卖五委托量
+    TICK_DEPTH_COL_NUM = DEPTH_COL_ASK_QTY + DEPTH_LEVEL_NUM
+};
+
+/**
+ * @brief 列描述
+ */
+struct tick_col_desc_t
+{
+    char name[TICK_COL_NAME_LEN];   ///< 列名
+    uint32 size;                    ///< 元素字节数
+    uint32 offset;                  ///< 列在块内的偏移
+};
+
+/**
+ * @brief 列存文件头
+ *
+ * 文件由文件头和若干块组成，每块TICK_BLOCK_ROWS行，块内各列连续存放
+ * （第b块第c列位于TICK_HEADER_LEN + b * block_size + cols[c].offset）。
+ * 每行是该合约一条行情处理后的完整状态，而不是增量字段。
+ */
+struct tick_file_header_t
+{
+    char magic[8];                  ///< TICK_MAGIC
+    uint32 version;                 ///< 文件格式版本
+    uint32 header_len;              ///< 文件头长度
+    uint32 group;                   ///< 字段组，见tick_group_t
+    uint32 trade_date;              ///< 交易日
+    char ins_id[MDP_INS_ID_LEN];    ///< 合约编码
+    uint16 ins_idx;                 ///< 当日合约索引
+    uint16 price_size;              ///< 价格精度（最近一条行情中的值）
+    uint32 col_num;                 ///< 列数
+    uint32 block_rows;              ///< 每块行数
+    uint64_t block_size;            ///< 每块字节数
+    std::atomic<uint64_t> rows;     ///< 已写入的行数，写完一行的所有列后更新
+    tick_col_desc_t cols[TICK_MAX_COLS];
+};
+
+/**
+ * @brief 写入队列中的记录
+ */
+struct tick_rec_t
+{
+    uint64_t local_ns;      ///< 进入队列时的系统时钟
+    uint8 kind;             ///< PACKAGE_INSTRUMENT_IDX/PACKAGE_INSTRUMENT/PACKAGE_DEPTH
+    uint16 ins_idx;         ///< 合约索引
+    uint16 price_size;      ///< 价格精度
+    uint32 mask;            ///< 本次出现的字段位图
+    union
+    {
+        struct
+        {
+            int msg_idx;                    ///< 消息在包内的位置
+            uint32 trade_date;              ///< 交易日
+            char ins_id[MDP_INS_ID_LEN];    ///< 合约编码
+        } idx;
+        int value[MDP_FIELD_NUM];                       ///< 单腿行情字段
+        mdp_depth_entry_t entry[DEPTH_LEVEL_NUM * 2 + 1];  ///< 深度行情档位，按字段索引1~10存放
+    };
+};
+
+/**
+ * @brief 行情列存输入（单生产者单消费者队列）
+ *
+ * 作为解码器处理器使用，把合约索引、单腿行情和深度行情复制到队列，
+ * 由tick_store_t的写盘线程取出，解码线程不接触磁盘。
+ * 队列满时丢弃记录并计数，不阻塞解码。
+ */
+class tick_feed_t : public mdp_null_handler_t
+{
+public:
+    /**
+     * @param name 输入名称，作为交易日目录下的子目录名
+     * @param queue_size 槽位数，必须为2的幂；为0时不分配队列，忽略所有记录
+     */
+    tick_feed_t(const char *name, uint32 queue_size);
+    ~tick_feed_t();
+
+    const char *get_name() const { return m_name.c_str(); }
+
+    /**
+     * @brief 因队列满被丢弃的记录数
+     */
+    uint64_t get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+/****** 处理器接口 ******/
+public:
+    void on_instrument_idx(const mdp_idx_event_t &ev)
+    {
+        tick_rec_t *rec = claim(PACKAGE_INSTRUMENT_IDX, ev.ins_idx, 0, 0);
+        if (rec == NULL)
+            return;
+        rec->idx.msg_idx = ev.msg_idx;
+        rec->idx.trade_date = ev.trade_date;
+        memcpy(rec->idx.ins_id, ev.ins_id, sizeof(rec->idx.ins_id));
+        commit();
+    }
+
+    void on_instrument(const mdp_tick_event_t &ev)
+    {
+        tick_rec_t *rec = claim(PACKAGE_INSTRUMENT, ev.ins_idx, ev.price_size, ev.fld.mask);
+        if (rec == NULL)
+            return;
+        memcpy(rec->value, ev.fld.value, sizeof(rec->value));
+        commit();
+    }
+
+    void on_depth(const mdp_depth_event_t &ev)
+    {
+        tick_rec_t *rec = claim(PACKAGE_DEPTH, ev.ins_idx, ev.price_size, ev.mask);
+        if (rec == NULL)
+            return;
+        memcpy(rec->entry, ev.entry, sizeof(rec->entry));
+        commit();
+    }
+
+private:
+    friend class tick_store_t;
+
+    /**
+     * @brief 取得队尾槽位并填写公共字段，队列已满时返回NULL
+     */
+    tick_rec_t *claim(uint8 kind, uint16 ins_idx, uint16 price_size, uint32 mask)
+    {
+        if (m_recs == NULL)
+            return NULL;
+
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache >= m_size)
+        {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache >= m_size)
+            {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return NULL;
+            }
+        }
+
+        tick_rec_t *rec = &m_recs[tail & (m_size - 1)];
+        rec->local_ns = realtime_ns();
+        rec->kind = kind;
+        rec->ins_idx = ins_idx;
+        rec->price_size = price_size;
+        rec->mask = mask;
+        return rec;
+    }
+
+    void commit()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 取出队首记录，仅限写盘线程调用，队列为空时返回NULL
+     */
+    const tick_rec_t *front()
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return NULL;
+        return &m_recs[head & (m_size - 1)];
+    }
+
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    std::string m_name;                 ///< 输入名称
+    uint32 m_size;                      ///< 槽位数
+    tick_rec_t *m_recs;                 ///< 槽位数组
+
+    // 对象经new分配，C++11下无法保证alignas生效，用填充隔开两个线程各自写的变量
+    char m_pad0[64];
+    std::atomic<uint64_t> m_tail;       ///< 写入位置（解码线程）
+    uint64_t m_head_cache;              ///< 解码线程缓存的读取位置
+    std::atomic<uint64_t> m_dropped;    ///< 丢弃计数
+
+    char m_pad1[64];
+    std::atomic<uint64_t> m_head;       ///< 读取位置（写盘线程）
+    char m_pad2[64];
+};
+
+/**
+ * @brief 列存文件写入，文件按块增长并映射到内存
+ */
+class tick_file_writer_t
+{
+public:
+    tick_file_writer_t();
+    ~tick_file_writer_t();
+
+    /**
+     * @brief 打开文件，从已写入的行之后继续追加
+     *
+     * 文件不存在、文件头无效或属于其他交易日/合约时创建新文件并写入文件头，
+     * 盘中重启时不会丢失当日已写入的行。
+     *
+     * @return 0：成功；-1：失败
+     */
+    int open(const char *path, tick_group_t group, uint32 trade_date, const char *ins_id, uint16 ins_idx);
+
+    bool is_open() const { return m_map != NULL; }
+
+    /**
+     * @brief 开始新的一行，必要时扩展文件
+     *
+     * @return 0：成功；-1：扩展失败
+     */
+    int begin_row();
+
+    /**
+     * @brief 写入当前行的一列，T必须与列的元素字节数一致
+     */
+    template <typename T>
+    void put(int col, T value)
+    {
+        memcpy(m_block + m_header->cols[col].offset + m_row_in_block * sizeof(T), &value, sizeof(T));
+    }
+
+    /**
+     * @brief 结束当前行，读者随即可见
+     */
+    void end_row(uint16 price_size)
+    {
+        m_header->price_size = price_size;
+        m_rows++;
+        m_header->rows.store(m_rows, std::memory_order_release);
+    }
+
+    /**
+     * @brief 截掉未使用的块并关闭文件
+     */
+    void close();
+
+private:
+    /**
+     * @brief 映射已有文件，文件头与参数一致时返回0
+     */
+    int reopen(const char *path, tick_group_t group, uint32 trade_date, const char *ins_id);
+
+    /**
+     * @brief 扩展文件并重新映射，块数按倍数增长，每次最多64块
+     */
+    int grow();
+
+private:
+    std::string m_path;             ///< 文件路径
+    char *m_map;                    ///< 文件映射
+    size_t m_map_len;               ///< 映射长度
+    tick_file_header_t *m_header;   ///< 文件头
+    uint64_t m_rows;                ///< 已写入的行数
+    uint64_t m_capacity;            ///< 已映射的行数
+    char *m_block;                  ///< 当前行所在的块
+    uint32 m_row_in_block;          ///< 当前行在块内的位置
+};
+
+/**
+ * @brief 行情列存
+ *
+ * 独立写盘线程从各输入队列取出记录，按合约维护最新状态，每条单腿/深度行情
+ * 追加一行到<dir>/<交易日>/<输入名称>/<合约编码>.tick或.depth，文件在合约
+ * 首次收到行情时打开，当日文件已存在时接着写；交易日切换时关闭该输入的所有文件，按新交易日重新创建。
+ * 文件随写随映射，读取见tick_file_t。
+ */
+class tick_store_t
+{
+public:
+    tick_store_t();
+
+    /**
+     * @brief 析构函数，未停止的写盘线程会被停止
+     */
+    ~tick_store_t();
+
+    /**
+     * @brief 添加输入，需在start()之前调用，每个解码线程一个
+     *
+     * @param name 输入名称，如"l1"、"l5"
+     * @param queue_size 队列槽位数，必须为2的幂
+     *
+     * @return 输入处理器，加入该解码线程的处理器组合；失败返回NULL
+     */
+    tick_feed_t *add_feed(const char *name, uint32 queue_size = TICK_DEFAULT_QUEUE_SIZE);
+
+    /**
+     * @brief 启动写盘线程
+     *
+     * @param dir 根目录
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int start(const char *dir);
+
+    /**
+     * @brief 写完队列中剩余记录后停止写盘线程并关闭所有文件
+     */
+    void stop();
+
+    /**
+     * @brief 已写入的行数
+     */
+    uint64_t get_written() const { return m_written.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief 单个合约的最新状态和文件
+     */
+    struct ins_state_t
+    {
+        char ins_id[MDP_INS_ID_LEN];        ///< 合约编码
+        uint16 ins_idx;                     ///< 合约索引
+        int value[MDP_FIELD_NUM];           ///< 单腿行情各字段最新值
+        int book[TICK_DEPTH_COL_NUM];       ///< 五档盘口，按深度文件的列存放（第0列不用）
+        tick_file_writer_t l1;              ///< 单腿行情文件
+        tick_file_writer_t depth;           ///< 深度行情文件
+    };
+
+    /**
+     * @brief 单个输入的状态
+     */
+    struct feed_state_t
+    {
+        tick_feed_t *feed;                  ///< 输入队列
+        uint32 trade_date;                  ///< 当前交易日
+        std::vector<ins_state_t *> ins;     ///< 以ins_idx为下标的合约状态
+    };
+
+    static void *thread_main(void *arg);
+
+    void run();
+
+    /**
+     * @brief 取出各队列中的记录写入文件
+     *
+     * @return 本次处理的记录数
+     */
+    int drain();
+
+    void apply(feed_state_t &fs, const tick_rec_t &rec);
+    void apply_tick(feed_state_t &fs, ins_state_t &ins, const tick_rec_t &rec);
+    void apply_depth(feed_state_t &fs, ins_state_t &ins, const tick_rec_t &rec);
+
+    /**
+     * @brief 创建合约在当前交易日的文件
+     */
+    int open_file(feed_state_t &fs, ins_state_t &ins, tick_group_t group);
+
+    /**
+     * @brief 关闭输入的所有文件并释放合约状态
+     */
+    void close_feed(feed_state_t &fs);
+
+private:
+    std::vector<feed_state_t> m_feeds;      ///< 各输入
+    std::string m_dir;                      ///< 根目录
+    uint64_t m_skipped;                     ///< 未收到合约索引的行情数
+
+    pthread_t m_thread;                     ///< 写盘线程
+    bool m_started;                         ///< 写盘线程是否已启动
+    std::atomic<bool> m_stop;               ///< 停止标志
+    std::atomic<uint64_t> m_written;        ///< 已写入行数
+};
+
+/**
+ * @brief 列存文件只读映射，可读取正在写入的文件
+ *
+ * 按块扫描各列即为顺序内存访问：
+ *
+ *     tick_file_t file;
+ *     file.open("ticks/20250102/l1/SR501.tick");
+ *     for (int b = 0; b < file.get_block_num(); b++)
+ *     {
+ *         const int *last = file.column<int>(b, TICK_COL_LAST);
+ *         for (uint32 r = 0; r < file.get_block_rows(b); r++)
+ *             ...
+ *     }
+ */
+class tick_file_t
+{
+public:
+    tick_file_t();
+    ~tick_file_t();
+
+    /**
+     * @brief 打开并映射文件，校验文件头
+     *
+     * @return 0：成功；-1：失败
+     */
+    int open(const char *path);
+
+    void close();
+
+    const tick_file_header_t &get_header() const { return *m_header; }
+
+    /**
+     * @brief 可读取的行数，不超过打开时已映射的部分
+     */
+    uint64_t get_rows() const
+    {
+        uint64_t rows = m_header->rows.load(std::memory_order_acquire);
+        return rows < m_capacity ? rows : m_capacity;
+    }
+
+    int get_block_num() const { return (int)((get_rows() + TICK_BLOCK_ROWS - 1) / TICK_BLOCK_ROWS); }
+
+    /**
+     * @brief 块内的有效行数
+     */
+    uint32 get_block_rows(int block) const
+    {
+        uint64_t rows = get_rows() - (uint64_t)block * TICK_BLOCK_ROWS;
+        return rows < TICK_BLOCK_ROWS ? (uint32)rows : TICK_BLOCK_ROWS;
+    }
+
+    /**
+     * @brief 块内一列的起始位置，T必须与列的元素字节数一致
+     */
+    template <typename T>
+    const T *column(int block, int col) const
+    {
+        return (const T *)(m_map + m_header->header_len + block * m_header->block_size + m_header->cols[col].offset);
+    }
+
+    /**
+     * @brief 按列名查找列
+     *
+     * @return 列序号；-1：不存在
+     */
+    int find_col(const char *name) const;
+
+private:
+    char *m_map;                            ///< 文件映射
+    size_t m_map_len;                       ///< 映射长度
+    const tick_file_header_t *m_header;     ///< 文件头
+    uint64_t m_capacity;                    ///< 已映射的行数
+};
+
+#endif
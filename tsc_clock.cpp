@@ -0,0 +1,22 @@
+#include "tsc_clock.h"
+
+/**
+ * @brief 对照单调时钟计数10ms
+ */
+static double calibrate_tsc()
+{
+    uint64_t ns0 = monotonic_ns();
+    uint64_t tsc0 = rdtsc();
+    while (monotonic_ns() - ns0 < 10000000)
+        ;
+    uint64_t ns1 = monotonic_ns();
+    uint64_t tsc1 = rdtsc();
+    return (double)(tsc1 - tsc0) / (ns1 - ns0);
+}
+
+double tsc_per_ns()
+{
+    // 局部静态变量的初始化由编译器保证只执行一次
+    static const double s_tsc_per_ns = calibrate_tsc();
+    return s_tsc_per_ns;
+}
@@ -0,0 +1,53 @@
+#ifndef TSC_CLOCK_H_
+#define TSC_CLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief 读取CPU时间戳计数器，非x86平台退化为单调时钟(ns)
+ */
+static inline uint64_t rdtsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief 单调时钟(ns)
+ */
+static inline uint64_t monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 系统时钟(ns)，与内核报文时间戳同源
+ */
+static inline uint64_t realtime_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 每纳秒的时间戳计数（TSC频率，不是CPU周期）
+ *
+ * 整个进程只标定一次（定义在tsc_clock.cpp），首次调用约耗时10ms，之后返回缓存值，
+ * 可在多个线程中首次调用。
+ */
+double tsc_per_ns();
+
+#endif
@@ -0,0 +1,428 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "uring_engine.h"
+#include "tsc_clock.h"
+
+#define URING_BGID  0   ///< 缓冲区组号
+
+static int sys_io_uring_setup(uint32 entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, uint32 to_submit, uint32 min_complete, uint32 flags, const void *arg, size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int sys_io_uring_register(int fd, uint32 opcode, const void *arg, uint32 nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+uring_engine_t::uring_engine_t()
+{
+    m_stop = false;
+
+    m_ring_fd = -1;
+    m_sq_ptr = NULL;
+    m_sq_size = 0;
+    m_cq_ptr = NULL;
+    m_cq_size = 0;
+    m_sqes = NULL;
+    m_sqes_size = 0;
+
+    m_sq_head = NULL;
+    m_sq_tail = NULL;
+    m_sq_mask = 0;
+    m_sq_array = NULL;
+    m_sq_pending = 0;
+
+    m_cq_head = NULL;
+    m_cq_tail = NULL;
+    m_cq_mask = 0;
+    m_cqes = NULL;
+
+    m_buf_ring = NULL;
+    m_buf_ring_size = 0;
+    m_bufs = NULL;
+    m_buf_num = 0;
+    m_buf_size = 0;
+    m_buf_tail = 0;
+
+    m_enter_calls = 0;
+    m_recv_dgrams = 0;
+    m_no_bufs = 0;
+}
+
+uring_engine_t::~uring_engine_t()
+{
+    if (m_ring_fd >= 0)
+        close(m_ring_fd);
+    if (m_cq_ptr != NULL && m_cq_ptr != m_sq_ptr)
+        munmap(m_cq_ptr, m_cq_size);
+    if (m_sq_ptr != NULL)
+        munmap(m_sq_ptr, m_sq_size);
+    if (m_sqes != NULL)
+        munmap(m_sqes, m_sqes_size);
+    if (m_buf_ring != NULL)
+        munmap(m_buf_ring, m_buf_ring_size);
+    if (m_bufs != NULL)
+        munmap(m_bufs, (size_t)m_buf_num * m_buf_size);
+}
+
+int uring_engine_t::add_channel(mc_client_t *client)
+{
+    if (m_ring_fd >= 0 || client == NULL || client->get_fd() < 0)
+    {
+        printf("add uring channel failed: engine initialized or client not initialized!\n");
+        return -1;
+    }
+
+    // 接收环模式下socket丢弃全部报文，引擎在socket上收不到任何数据
+    if (client->has_packet_ring())
+    {
+        printf("add uring channel failed: %s receives from packet ring!\n", client->get_name().c_str());
+        return -1;
+    }
+
+    channel_t channel;
+    memset(&channel, 0, sizeof(channel));
+    channel.client = client;
+    channel.msg.msg_namelen = 0;
+    channel.msg.msg_controllen = MC_CTRL_BUF_LEN;
+    channel.armed = false;
+    channel.failed = false;
+    m_channels.push_back(channel);
+
+    return 0;
+}
+
+int uring_engine_t::init(uint32 buf_num)
+{
+    if (m_ring_fd >= 0)
+    {
+        printf("uring engine has been initialized!\n");
+        return -1;
+    }
+
+    if (m_channels.empty() || buf_num == 0 || buf_num > 32768 || (buf_num & (buf_num - 1)) != 0)
+    {
+        printf("invalid uring engine config: channels = %lu, buffers = %u\n",
+                (unsigned long)m_channels.size(), buf_num);
+        return -1;
+    }
+
+    // 完成队列放大，避免报文突发时溢出
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = buf_num;
+    m_ring_fd = sys_io_uring_setup(URING_QUEUE_DEPTH, &params);
+    if (m_ring_fd < 0 && errno == EINVAL)
+    {
+        params.flags = IORING_SETUP_CQSIZE;
+        m_ring_fd = sys_io_uring_setup(URING_QUEUE_DEPTH, &params);
+    }
+    if (m_ring_fd < 0)
+    {
+        perror("io_uring_setup");
+        return -2;
+    }
+
+    m_sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32);
+    m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (m_cq_size > m_sq_size)
+            m_sq_size = m_cq_size;
+        m_cq_size = m_sq_size;
+    }
+
+    void *sq = mmap(NULL, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+    {
+        perror("mmap io_uring sq");
+        return -3;
+    }
+    m_sq_ptr = (char *)sq;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        m_cq_ptr = m_sq_ptr;
+    }
+    else
+    {
+        void *cq = mmap(NULL, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+        {
+            perror("mmap io_uring cq");
+            return -3;
+        }
+        m_cq_ptr = (char *)cq;
+    }
+
+    m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        perror("mmap io_uring sqes");
+        return -3;
+    }
+    m_sqes = (struct io_uring_sqe *)sqes;
+
+    m_sq_head = (uint32 *)(m_sq_ptr + params.sq_off.head);
+    m_sq_tail = (uint32 *)(m_sq_ptr + params.sq_off.tail);
+    m_sq_mask = *(uint32 *)(m_sq_ptr + params.sq_off.ring_mask);
+    m_sq_array = (uint32 *)(m_sq_ptr + params.sq_off.array);
+    m_cq_head = (uint32 *)(m_cq_ptr + params.cq_off.head);
+    m_cq_tail = (uint32 *)(m_cq_ptr + params.cq_off.tail);
+    m_cq_mask = *(uint32 *)(m_cq_ptr + params.cq_off.ring_mask);
+    m_cqes = (struct io_uring_cqe *)(m_cq_ptr + params.cq_off.cqes);
+
+    // 每个缓冲区依次存放：recvmsg输出头 | 控制消息 | 报文
+    m_buf_num = buf_num;
+    m_buf_size = (sizeof(struct io_uring_recvmsg_out) + MC_CTRL_BUF_LEN + MC_RECV_BUF_LEN + 63) & ~63u;
+    void *bufs = mmap(NULL, (size_t)m_buf_num * m_buf_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (bufs == MAP_FAILED)
+    {
+        perror("mmap uring buffers");
+        return -4;
+    }
+    m_bufs = (char *)bufs;
+
+    m_buf_ring_size = (size_t)m_buf_num * sizeof(struct io_uring_buf);
+    void *ring = mmap(NULL, m_buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (ring == MAP_FAILED)
+    {
+        perror("mmap uring buffer ring");
+        return -4;
+    }
+    m_buf_ring = (struct io_uring_buf_ring *)ring;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)m_buf_ring;
+    reg.ring_entries = m_buf_num;
+    reg.bgid = URING_BGID;
+    if (sys_io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        perror("register uring buffer ring");
+        return -5;
+    }
+
+    m_buf_tail = 0;
+    for (uint32 i = 0; i < m_buf_num; i++)
+        recycle(i);
+    __atomic_store_n(&m_buf_ring->tail, m_buf_tail, __ATOMIC_RELEASE);
+
+    printf("io_uring engine: %lu channels, %u buffers x %u bytes\n",
+            (unsigned long)m_channels.size(), m_buf_num, m_buf_size);
+    return 0;
+}
+
+struct io_uring_sqe *uring_engine_t::get_sqe()
+{
+    uint32 head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    uint32 tail = *m_sq_tail + m_sq_pending;
+    if (tail - head > m_sq_mask)
+        return NULL;
+
+    uint32 idx = tail & m_sq_mask;
+    m_sq_array[idx] = idx;
+    m_sq_pending++;
+
+    struct io_uring_sqe *sqe = &m_sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int uring_engine_t::arm(int channel)
+{
+    struct io_uring_sqe *sqe = get_sqe();
+    if (sqe == NULL)
+        return -1;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = m_channels[channel].client->get_fd();
+    sqe->addr = (uint64_t)(uintptr_t)&m_channels[channel].msg;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BGID;
+    sqe->user_data = channel;
+
+    m_channels[channel].armed = true;
+    return 0;
+}
+
+int uring_engine_t::enter(uint32 to_submit, uint32 min_complete)
+{
+    if (to_submit > 0)
+    {
+        __atomic_store_n(m_sq_tail, *m_sq_tail + to_submit, __ATOMIC_RELEASE);
+        m_sq_pending = 0;
+    }
+
+    // 超时与阻塞模式的socket接收超时一致
+    struct __kernel_timespec ts;
+    ts.tv_sec = MC_IDLE_WAIT_MS / 1000;
+    ts.tv_nsec = (MC_IDLE_WAIT_MS % 1000) * 1000000LL;
+
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+
+    m_enter_calls++;
+    int res = sys_io_uring_enter(m_ring_fd, to_submit, min_complete,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    return res < 0 ? -errno : res;
+}
+
+void uring_engine_t::recycle(uint16 bid)
+{
+    // 头文件中bufs[]前的空结构体在C++中占1字节，使bufs偏移8字节，这里按io_uring_buf数组直接寻址
+    struct io_uring_buf *buf = (struct io_uring_buf *)m_buf_ring + (m_buf_tail & (m_buf_num - 1));
+    buf->addr = (uint64_t)(uintptr_t)(m_bufs + (size_t)bid * m_buf_size);
+    buf->len = m_buf_size;
+    buf->bid = bid;
+    m_buf_tail++;
+}
+
+void uring_engine_t::on_cqe(const struct io_uring_cqe *cqe, mdp_recv_info_t &info)
+{
+    channel_t &channel = m_channels[cqe->user_data];
+
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+        channel.armed = false;
+
+    if (cqe->res <= 0)
+    {
+        // 缓冲区耗尽时multishot终止，回收缓冲区后重新提交；其他错误重新提交只会立即再次失败，放弃该通道
+        if (cqe->res == -ENOBUFS)
+            m_no_bufs++;
+        else if (cqe->res < 0 && !channel.armed)
+        {
+            channel.failed = true;
+            if (!m_stop.load(std::memory_order_relaxed))
+                printf("[%s] io_uring recvmsg failed: %s, channel stopped\n",
+                        channel.client->get_name().c_str(), strerror(-cqe->res));
+        }
+        return;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_BUFFER))
+        return;
+
+    uint16 bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+    char *buf = m_bufs + (size_t)bid * m_buf_size;
+    const struct io_uring_recvmsg_out *out = (const struct io_uring_recvmsg_out *)buf;
+
+    // 输出布局按提交时的名字和控制消息长度排布，控制消息实际长度见controllen
+    char *control = buf + sizeof(*out) + channel.msg.msg_namelen;
+    const char *payload = control + channel.msg.msg_controllen;
+    int len = out->payloadlen;
+    if ((out->flags & MSG_TRUNC) || len > (int)MC_RECV_BUF_LEN)
+        len = MC_RECV_BUF_LEN;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = out->controllen;
+
+    m_recv_dgrams++;
+    if (len > 0)
+        channel.client->deliver(payload, len, &msg, info);
+
+    recycle(bid);
+}
+
+void uring_engine_t::loop()
+{
+    printf("io_uring engine %s running\n", get_name().c_str());
+
+    mdp_recv_info_t info;
+
+    while (!m_stop.load(std::memory_order_relaxed))
+    {
+        // 重新提交已终止的multishot请求，所有通道都失败时退出
+        size_t failed = 0;
+        for (size_t i = 0; i < m_channels.size(); i++)
+        {
+            if (m_channels[i].failed)
+                failed++;
+            else if (!m_channels[i].armed && arm(i) != 0)
+                break;
+        }
+        if (failed != 0 && failed == m_channels.size())
+        {
+            printf("io_uring engine %s: all channels failed\n", get_name().c_str());
+            break;
+        }
+
+        int res = enter(m_sq_pending, 1);
+        if (res < 0 && res != -ETIME && res != -EINTR && res != -EBUSY)
+        {
+            printf("io_uring_enter failed: %s\n", strerror(-res));
+            break;
+        }
+
+        // 一批完成事件共用取出时间
+        info.dequeue_tsc = rdtsc();
+        info.dequeue_ns = realtime_ns();
+
+        uint32 head = *m_cq_head;
+        uint32 tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail)
+        {
+            if (res == -ETIME)
+                printf("io_uring_enter() timed out.\n");
+            continue;
+        }
+
+        uint16 buf_tail = m_buf_tail;
+        for (; head != tail; head++)
+            on_cqe(&m_cqes[head & m_cq_mask], info);
+
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        if (m_buf_tail != buf_tail)
+            __atomic_store_n(&m_buf_ring->tail, m_buf_tail, __ATOMIC_RELEASE);
+    }
+}
+
+void uring_engine_t::stop()
+{
+    m_stop.store(true);
+
+    // shutdown使各socket上的multishot请求结束，阻塞中的io_uring_enter随之返回
+    for (size_t i = 0; i < m_channels.size(); i++)
+        m_channels[i].client->stop();
+}
+
+std::string uring_engine_t::get_name() const
+{
+    std::string name = "uring[";
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        if (i > 0)
+            name += ",";
+        name += m_channels[i].client->get_name();
+    }
+    return name + "]";
+}
+
+void uring_engine_t::print_stats() const
+{
+    printf("%s: enter calls = %llu, datagrams = %llu, datagrams/call = %.2f, buffer exhausted = %llu\n",
+            get_name().c_str(), m_enter_calls, m_recv_dgrams,
+            m_enter_calls == 0 ? 0.0 : (double)m_recv_dgrams / m_enter_calls, m_no_bufs);
+}
@@ -0,0 +1,145 @@
+#ifndef URING_ENGINE_H_
+#define URING_ENGINE_H_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <sys/socket.h>
+
+#include "mc_client.h"
+
+#define URING_QUEUE_DEPTH   64      ///< 提交队列深度，完成队列按缓冲区个数分配
+#define URING_BUF_NUM       4096    ///< 提供给内核的接收缓冲区个数，必须为2的幂
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+/**
+ * @brief 基于io_uring的多通道接收引擎
+ *
+ * 一个线程通过一个io_uring同时接收多个组播通道：每个通道的socket上挂一个multishot recvmsg，
+ * 内核从共享的缓冲区环中取缓冲区填入报文，一次io_uring_enter可取回所有通道的多个报文。
+ * 报文经mc_client_t::deliver()交给各通道的回调，回调返回后缓冲区立即还给内核，
+ * 接收过程中没有内存分配。直接使用io_uring系统调用，不依赖liburing，需要Linux 6.0及以上。
+ */
+class uring_engine_t
+{
+public:
+    uring_engine_t();
+    ~uring_engine_t();
+
+    /**
+     * @brief 添加接收通道，需在init()之前调用
+     *
+     * @param client 已完成init()的组播客户端（socket接收方式，不能开启接收环），生命周期由调用方管理；
+     *               回调、录制、计数等设置沿用客户端上的设置
+     *
+     * @return 0：成功；-1：失败
+     */
+    int add_channel(mc_client_t *client);
+
+    /**
+     * @brief 创建io_uring并注册缓冲区环
+     *
+     * @param buf_num 接收缓冲区个数，2的幂
+     *
+     * @return 0：成功；其他：错误码
+     */
+    int init(uint32 buf_num = URING_BUF_NUM);
+
+    /**
+     * @brief 循环接收所有通道的报文，直到调用stop()
+     */
+    void loop();
+
+    /**
+     * @brief 通知接收循环退出，可在其他线程中调用
+     */
+    void stop();
+
+    /**
+     * @brief 引擎描述，如"uring[239.26.1.1:23001,239.27.1.1:23005]"
+     */
+    std::string get_name() const;
+
+    /**
+     * @brief 打印系统调用次数和每次取回的报文数
+     */
+    void print_stats() const;
+
+private:
+    /**
+     * @brief 接收通道
+     */
+    struct channel_t
+    {
+        mc_client_t *client;    ///< 组播客户端
+        struct msghdr msg;      ///< multishot recvmsg的模板，只用到名字和控制消息长度
+        bool armed;             ///< 是否有生效中的multishot请求
+        bool failed;            ///< 请求因错误终止，不再重新提交
+    };
+
+    /**
+     * @brief 为通道提交multishot recvmsg
+     */
+    int arm(int channel);
+
+    /**
+     * @brief 取一个空闲的提交队列项
+     */
+    struct io_uring_sqe *get_sqe();
+
+    /**
+     * @brief 提交并等待至少一个完成事件
+     *
+     * @return 大于等于0：成功；-ETIME：超时；其他负数：错误
+     */
+    int enter(uint32 to_submit, uint32 min_complete);
+
+    /**
+     * @brief 处理一个完成事件
+     */
+    void on_cqe(const struct io_uring_cqe *cqe, mdp_recv_info_t &info);
+
+    /**
+     * @brief 把缓冲区还给内核，在一批完成事件处理后统一更新环尾
+     */
+    void recycle(uint16 bid);
+
+private:
+    std::vector<channel_t> m_channels;  ///< 通道列表
+    std::atomic<bool> m_stop;           ///< 接收循环退出标志
+
+    int m_ring_fd;                      ///< io_uring描述符
+    char *m_sq_ptr;                     ///< 提交队列映射
+    size_t m_sq_size;                   ///< 提交队列映射大小
+    char *m_cq_ptr;                     ///< 完成队列映射（与提交队列共用时同m_sq_ptr）
+    size_t m_cq_size;                   ///< 完成队列映射大小
+    struct io_uring_sqe *m_sqes;        ///< 提交队列项数组
+    size_t m_sqes_size;                 ///< 提交队列项映射大小
+
+    uint32 *m_sq_head;                  ///< 提交队列头（内核更新）
+    uint32 *m_sq_tail;                  ///< 提交队列尾（用户更新）
+    uint32 m_sq_mask;                   ///< 提交队列掩码
+    uint32 *m_sq_array;                 ///< 提交队列索引数组
+    uint32 m_sq_pending;                ///< 已填写未提交的项数
+
+    uint32 *m_cq_head;                  ///< 完成队列头（用户更新）
+    uint32 *m_cq_tail;                  ///< 完成队列尾（内核更新）
+    uint32 m_cq_mask;                   ///< 完成队列掩码
+    struct io_uring_cqe *m_cqes;        ///< 完成队列项数组
+
+    struct io_uring_buf_ring *m_buf_ring;  ///< 缓冲区环
+    size_t m_buf_ring_size;             ///< 缓冲区环映射大小
+    char *m_bufs;                       ///< 接收缓冲区
+    uint32 m_buf_num;                   ///< 缓冲区个数
+    uint32 m_buf_size;                  ///< 单个缓冲区大小
+    uint16 m_buf_tail;                  ///< 缓冲区环尾（本地副本）
+
+    unsigned long long m_enter_calls;   ///< io_uring_enter次数
+    unsigned long long m_recv_dgrams;   ///< 收到的报文数
+    unsigned long long m_no_bufs;       ///< 缓冲区耗尽次数
+};
+
+#endif